@@ -21,12 +21,22 @@
 extern "C" {
 #endif
 
+/* Wire format written and read by the generated CDR codec */
+typedef enum java_cdr_format {
+    JAVA_CDR_PACKED,    /* unaligned little-endian fields, no header (default) */
+    JAVA_CDR_XCDR1,     /* XCDR version 1 with encapsulation header */
+    JAVA_CDR_XCDR2      /* XCDR version 2 with encapsulation header */
+} java_cdr_format_t;
+
 typedef struct java_generator_config {
-    char *output_dir;
-    char *package_prefix;
+    const char *output_dir;
+    const char *package_prefix;
     bool use_arrays_for_sequences;
     bool disable_cdr;
-    bool generate_records;
+    bool generate_records;   /* plain final classes instead of JNA Structures */
+    bool inline_typedefs;    /* aliased types at use sites instead of alias classes */
+    bool native_layout;      /* also <Type>Native Structures with the C layout */
+    java_cdr_format_t cdr_format;
 } java_generator_config_t;
 
 typedef struct java_type_map {
@@ -37,15 +47,131 @@ typedef struct java_type_map {
     bool is_string;
 } java_type_map_t;
 
+/* CDR size and alignment of a type, computed at generation time */
+typedef struct cdr_layout {
+    bool fixed;       /* encoded size is independent of the sample */
+    uint32_t size;    /* encoded size in bytes, valid if fixed */
+    uint32_t align;   /* alignment of the type in the stream */
+} cdr_layout_t;
+
+/*
+ * Emission state of one generated codec method, see java_codec.c. The size
+ * emitter folds constant-size members into `pending` and only writes them out
+ * where a runtime-dependent part follows.
+ */
+typedef struct java_codec {
+    struct string_builder *sb;
+    java_cdr_format_t format;
+    bool use_arrays;
+    bool key_only;          /* nested structs contribute only their key */
+    uint32_t known_align;   /* alignment the stream position is known to have */
+    uint32_t pending;       /* bytes not yet added to the running size */
+} java_codec_t;
+
+/* Per-run allocations, see java_arena.c */
+typedef struct java_arena java_arena_t;
+
+/* One struct member as the emitters see it, see java_ir.c */
+typedef struct java_member_ir {
+    const idl_member_t *member;
+    const char *name;
+    const idl_type_spec_t *type_spec;
+    idl_type_t kind;            /* type after resolving aliases */
+    const char *java_type;      /* field type */
+    const char *alias;          /* typedef kept as a comment on the field, or NULL */
+    cdr_layout_t layout;        /* in the run's CDR format */
+    uint32_t offset;            /* from the start of the struct, if it is fixed-size */
+    uint32_t id;                /* member id */
+    bool key;
+    bool optional;
+} java_member_ir_t;
+
+typedef struct java_struct_ir {
+    const idl_struct_t *struct_def;
+    java_member_ir_t *members;  /* in declaration order */
+    size_t count;
+    const java_member_ir_t **keys;  /* by member id: the @key members, or all if there are none */
+    size_t key_count;
+    bool has_key;               /* some member is @key */
+    cdr_layout_t layout;
+} java_struct_ir_t;
+
 #ifdef __cplusplus
 }
 #endif
 
-int generate_java_record(const idl_struct_t *struct_def, const char *output_dir, const char *prefix, bool disable_cdr, const char *class_name);
-int generate_java_enum(const idl_enum_t *enum_def, const char *output_dir, const char *prefix, const char *enum_name);
-int generate_java_typedef(const idl_typedef_t *typedef_def, const char *output_dir, const char *prefix);
-char *resolve_package(const idl_node_t *node, const char *prefix);
+int generate_java_record(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *class_name);
+int generate_java_enum(const idl_enum_t *enum_def, const java_generator_config_t *config, const char *enum_name);
+int generate_java_typedef(const idl_typedef_t *typedef_def, const java_generator_config_t *config);
+int generate_java_union(const idl_union_t *union_def, const java_generator_config_t *config, const char *union_name);
+int generate_java_bitmask(const idl_bitmask_t *bitmask_def, const java_generator_config_t *config, const char *bitmask_name);
+int generate_java_instance_cache(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *class_name);
+int generate_java_native_struct(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *struct_name);
+int generate_java_native_union(const idl_union_t *union_def, const java_generator_config_t *config, const char *union_name);
+int generate_java_runtime(const java_generator_config_t *config);
+int generate_java_endpoints(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *struct_name);
+char *java_package_path(const java_generator_config_t *config, const char *package);
+int java_write_class(const char *package_path, const char *class_name, const struct string_builder *sb);
+int java_write_file(const char *file_path, const struct string_builder *sb);
+int java_output_begin(const char *output_dir, bool track_owners);
+int java_output_end(bool complete);
+void java_output_set_owner(const void *owner);
+int java_output_owned_files(const void *owner, void (*fn)(const char *path, void *arg), void *arg);
+int java_deps_write(const idl_pstate_t *pstate, const java_generator_config_t *config, const char *deps_path);
+const char *resolve_package(const idl_node_t *node, const char *prefix);
+const char *resolve_qualified_name(const idl_node_t *node, const char *prefix);
 const char *get_struct_name(const idl_struct_t *struct_def);
-char *java_type_name(const idl_type_spec_t *type_spec, bool boxed);
+const char *java_type_name(const idl_type_spec_t *type_spec, bool boxed);
+const char *java_field_type_name(const idl_type_spec_t *type_spec, bool use_arrays);
+const char *get_type_description(const idl_type_spec_t *type_spec);
+const char *java_bitmask_type(const idl_bitmask_t *bitmask_def, bool boxed);
+void java_set_inline_typedefs(bool enabled);
+const idl_type_spec_t *java_resolve_alias(const idl_type_spec_t *type_spec);
+const idl_type_spec_t *java_resolve_forward(const idl_type_spec_t *type_spec);
+char *java_key_hash_expr(const idl_type_spec_t *type_spec, const char *expr, bool use_arrays);
+char *java_key_equals_expr(const idl_type_spec_t *type_spec, const char *a, const char *b, bool use_arrays);
+uint32_t cdr_primitive_size(idl_type_t type);
+uint32_t cdr_align(uint32_t offset, uint32_t align);
+uint32_t cdr_max_align(java_cdr_format_t format);
+uint32_t cdr_enum_size(const idl_enum_t *enum_def, java_cdr_format_t format);
+uint32_t cdr_bitmask_size(const idl_bitmask_t *bitmask_def);
+bool cdr_type_layout(const idl_type_spec_t *type_spec, java_cdr_format_t format, cdr_layout_t *layout);
+bool cdr_struct_layout(const idl_struct_t *struct_def, java_cdr_format_t format, cdr_layout_t *layout);
+const idl_member_t **cdr_key_members(const idl_struct_t *struct_def, size_t *count);
+bool cdr_struct_has_key(const idl_struct_t *struct_def);
+bool cdr_key_supported(const idl_struct_t *struct_def);
+bool cdr_key_fits(const idl_struct_t *struct_def, java_cdr_format_t format, uint32_t limit);
+
+int64_t case_label_value(const idl_const_expr_t *const_expr);
+int64_t default_discriminator(const idl_union_t *union_def);
+bool generate_topic_descriptor(struct string_builder *sb, const idl_struct_t *struct_def);
+int generate_type_object_constants(struct string_builder *sb, const idl_type_spec_t *type_spec);
+
+void codec_init(java_codec_t *codec, struct string_builder *sb, java_cdr_format_t format, bool use_arrays);
+void codec_size_align(java_codec_t *codec, int indent, uint32_t align);
+void codec_size_add(java_codec_t *codec, uint32_t size);
+void codec_size_flush(java_codec_t *codec, int indent);
+void codec_write_align(java_codec_t *codec, int indent, uint32_t align);
+void codec_read_align(java_codec_t *codec, int indent, uint32_t align);
+void codec_emit_size(java_codec_t *codec, const idl_type_spec_t *type_spec, const char *expr, int indent, int depth);
+void codec_emit_write(java_codec_t *codec, const idl_type_spec_t *type_spec, const char *expr, int indent, int depth);
+void codec_emit_read(java_codec_t *codec, const idl_type_spec_t *type_spec, const char *target, int indent, int depth);
+const idl_type_spec_t *codec_typedef_alias(const idl_type_spec_t *type_spec);
+const idl_type_spec_t *codec_unalias(const idl_type_spec_t *type_spec);
+uint32_t codec_length_code(const java_codec_t *codec, const idl_type_spec_t *type_spec);
+bool codec_type_encodable(const idl_type_spec_t *type_spec);
+const char *codec_width_accessor(uint32_t width);
+const char *codec_width_cast(uint32_t width);
+uint32_t codec_bytecode_size(const char *code);
+
+java_struct_ir_t *java_struct_ir_build(const idl_struct_t *struct_def, java_cdr_format_t format, bool use_arrays);
+
+java_arena_t *java_arena_create(void);
+void java_arena_destroy(java_arena_t *arena);
+void java_arena_set_current(java_arena_t *arena);
+java_arena_t *java_arena_current(void);
+void *java_arena_alloc(size_t size);
+const char *java_intern(const char *str);
+const char *java_internf(const char *format, ...);
 
 #endif /* IDLC_JAVA_H */
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "idlc_java.h"
+
+/* Natural CDR size of a primitive, or 0 if the type is not a primitive */
+uint32_t cdr_primitive_size(idl_type_t type) {
+    switch (type) {
+        case IDL_BOOL:
+        case IDL_OCTET:
+        case IDL_CHAR: return 1;
+        case IDL_SHORT:
+        case IDL_USHORT: return 2;
+        case IDL_LONG:
+        case IDL_ULONG:
+        case IDL_FLOAT: return 4;
+        case IDL_LLONG:
+        case IDL_ULLONG:
+        case IDL_DOUBLE: return 8;
+        default: return 0;
+    }
+}
+
+uint32_t cdr_align(uint32_t offset, uint32_t align) {
+    if (align <= 1) return offset;
+    return (offset + align - 1) & ~(align - 1);
+}
+
+/* Largest alignment applied in the stream: XCDR1 aligns up to 8, XCDR2 up to 4 */
+uint32_t cdr_max_align(java_cdr_format_t format) {
+    switch (format) {
+        case JAVA_CDR_XCDR1: return 8;
+        case JAVA_CDR_XCDR2: return 4;
+        default: return 1;
+    }
+}
+
+static uint32_t bit_bound_size(uint16_t bit_bound, uint32_t max_size) {
+    uint32_t size = bit_bound <= 8 ? 1 : bit_bound <= 16 ? 2 : bit_bound <= 32 ? 4 : 8;
+    return size < max_size ? size : max_size;
+}
+
+/* XCDR2 sizes enums by @bit_bound; XCDR1 and the packed encoding always use 4 bytes */
+uint32_t cdr_enum_size(const idl_enum_t *enum_def, java_cdr_format_t format) {
+    if (format != JAVA_CDR_XCDR2 || enum_def->bit_bound.value == 0) return 4;
+    return bit_bound_size(enum_def->bit_bound.value, 4);
+}
+
+uint32_t cdr_bitmask_size(const idl_bitmask_t *bitmask_def) {
+    return bit_bound_size(bitmask_def->bit_bound.value ? bitmask_def->bit_bound.value : 32, 8);
+}
+
+/* True if the type is an array typedef, or an alias of one */
+static bool is_array_alias(const idl_type_spec_t *type_spec) {
+    while (type_spec && idl_type(type_spec) == IDL_TYPEDEF) {
+        if (idl_is_array(type_spec)) return true;
+        type_spec = codec_typedef_alias(type_spec);
+    }
+    return false;
+}
+
+/*
+ * Layout of a single type. Primitives, enums and bitmasks are fixed-size;
+ * structs are fixed-size if all of their members are. Strings, sequences,
+ * unions, arrays and anything not handled by the codec make the enclosing
+ * type variable-size; an array member holds a single element in Java, so
+ * the fixed codec could not move the others.
+ * For the aligned formats a struct only counts as fixed if its first member
+ * carries its largest alignment, so that member offsets are the same wherever
+ * the struct starts, and if it has no DHEADER/EMHEADERs.
+ */
+bool cdr_type_layout(const idl_type_spec_t *type_spec, java_cdr_format_t format, cdr_layout_t *layout) {
+    uint32_t max_align = cdr_max_align(format);
+
+    layout->fixed = false;
+    layout->size = 0;
+    layout->align = 1;
+
+    if (!type_spec || is_array_alias(type_spec)) return false;
+
+    type_spec = java_resolve_alias(type_spec);
+    idl_type_t type = idl_type(type_spec);
+    uint32_t size = cdr_primitive_size(type);
+
+    if (size == 0 && type == IDL_ENUM) {
+        size = cdr_enum_size((const idl_enum_t *)type_spec, format);
+    } else if (size == 0 && type == IDL_BITMASK) {
+        size = cdr_bitmask_size((const idl_bitmask_t *)type_spec);
+    }
+
+    if (size > 0) {
+        layout->fixed = true;
+        layout->size = size;
+        layout->align = size < max_align ? size : max_align;
+        return true;
+    }
+
+    if (type == IDL_STRUCT) {
+        return cdr_struct_layout((const idl_struct_t *)type_spec, format, layout);
+    }
+    return false;
+}
+
+bool cdr_struct_layout(const idl_struct_t *struct_def, java_cdr_format_t format, cdr_layout_t *layout) {
+    uint32_t offset = 0;
+    uint32_t align = 1;
+    uint32_t first_align = 0;
+
+    layout->fixed = false;
+    layout->size = 0;
+    layout->align = 1;
+
+    if (!struct_def) return false;
+
+    if (format == JAVA_CDR_XCDR2 && struct_def->extensibility.value != IDL_FINAL) return false;
+    if (format == JAVA_CDR_XCDR1 && struct_def->extensibility.value == IDL_MUTABLE) return false;
+
+    for (const idl_member_t *member = struct_def->members; member; ) {
+        cdr_layout_t member_layout;
+        if (member->declarators && idl_is_array(member->declarators)) return false;
+        if (!cdr_type_layout(member->type_spec, format, &member_layout)) {
+            return false;
+        }
+        offset = cdr_align(offset, member_layout.align) + member_layout.size;
+        if (member_layout.align > align) align = member_layout.align;
+        if (first_align == 0) first_align = member_layout.align;
+
+        idl_node_t *next_node = (idl_node_t *)member;
+        if (!next_node->next) break;
+        member = (const idl_member_t *)next_node->next;
+    }
+
+    if (format != JAVA_CDR_PACKED && first_align != 0 && first_align != align) {
+        return false;
+    }
+
+    layout->fixed = true;
+    layout->size = offset;
+    layout->align = align;
+    return true;
+}
+
+static int compare_member_ids(const void *a, const void *b) {
+    const idl_member_t *ma = *(const idl_member_t *const *)a;
+    const idl_member_t *mb = *(const idl_member_t *const *)b;
+    uint32_t ia = ma->declarators ? ma->declarators->id.value : 0;
+    uint32_t ib = mb->declarators ? mb->declarators->id.value : 0;
+    return ia < ib ? -1 : ia > ib ? 1 : 0;
+}
+
+/*
+ * Members that make up the key of a struct, ordered by member id: its @key
+ * members, or all of its members if it has none (which is what a struct
+ * contributes when it is itself used as a key member). Caller frees the array.
+ */
+const idl_member_t **cdr_key_members(const idl_struct_t *struct_def, size_t *count) {
+    size_t total = 0, keys = 0;
+
+    *count = 0;
+    for (const idl_member_t *member = struct_def->members; member; ) {
+        total++;
+        if (member->key.value) keys++;
+        idl_node_t *next_node = (idl_node_t *)member;
+        if (!next_node->next) break;
+        member = (const idl_member_t *)next_node->next;
+    }
+    if (total == 0) return NULL;
+
+    const idl_member_t **members = malloc(total * sizeof(*members));
+    if (!members) return NULL;
+    for (const idl_member_t *member = struct_def->members; member; ) {
+        if (keys == 0 || member->key.value) members[(*count)++] = member;
+        idl_node_t *next_node = (idl_node_t *)member;
+        if (!next_node->next) break;
+        member = (const idl_member_t *)next_node->next;
+    }
+    qsort(members, *count, sizeof(*members), compare_member_ids);
+    return members;
+}
+
+bool cdr_struct_has_key(const idl_struct_t *struct_def) {
+    for (const idl_member_t *member = struct_def->members; member; ) {
+        if (member->key.value) return true;
+        idl_node_t *next_node = (idl_node_t *)member;
+        if (!next_node->next) break;
+        member = (const idl_member_t *)next_node->next;
+    }
+    return false;
+}
+
+/* Structs whose key is being checked, innermost first */
+typedef struct key_visit {
+    const idl_struct_t *struct_def;
+    const struct key_visit *outer;
+} key_visit_t;
+
+static bool struct_key_supported(const idl_struct_t *struct_def, const key_visit_t *outer);
+
+static bool type_key_supported(const idl_type_spec_t *type_spec, const key_visit_t *visiting) {
+    type_spec = java_resolve_forward(type_spec);
+    switch (idl_type(type_spec)) {
+        case IDL_UNION:
+            return false;
+        case IDL_SEQUENCE:
+            return type_key_supported(((const idl_sequence_t *)type_spec)->type_spec, visiting);
+        case IDL_TYPEDEF:
+            return type_key_supported(codec_typedef_alias(type_spec), visiting);
+        case IDL_STRUCT:
+            return struct_key_supported((const idl_struct_t *)type_spec, visiting);
+        default:
+            return type_spec != NULL;
+    }
+}
+
+/* A struct met again through a sequence adds nothing its outer check does not cover */
+static bool struct_key_supported(const idl_struct_t *struct_def, const key_visit_t *outer) {
+    for (const key_visit_t *visit = outer; visit; visit = visit->outer) {
+        if (visit->struct_def == struct_def) return true;
+    }
+    key_visit_t visit = { struct_def, outer };
+    size_t count;
+    const idl_member_t **members = cdr_key_members(struct_def, &count);
+    bool supported = true;
+    for (size_t i = 0; i < count && supported; i++) {
+        supported = type_key_supported(members[i]->type_spec, &visit);
+    }
+    free(members);
+    return supported;
+}
+
+/* Key serialization does not cover unions */
+bool cdr_key_supported(const idl_struct_t *struct_def) {
+    return struct_key_supported(struct_def, NULL);
+}
+
+static bool key_extent(const idl_type_spec_t *type_spec, java_cdr_format_t format, uint32_t *offset, uint32_t limit);
+
+static bool struct_key_extent(const idl_struct_t *struct_def, java_cdr_format_t format, uint32_t *offset, uint32_t limit) {
+    size_t count;
+    const idl_member_t **members = cdr_key_members(struct_def, &count);
+    bool fits = true;
+    for (size_t i = 0; i < count && fits; i++) {
+        fits = key_extent(members[i]->type_spec, format, offset, limit);
+    }
+    free(members);
+    return fits;
+}
+
+/*
+ * Advance *offset past the largest encoding of a key value in format. Padding
+ * only grows with the offset, so the largest value always ends furthest.
+ * Returns false once the key may exceed limit bytes.
+ */
+static bool key_extent(const idl_type_spec_t *type_spec, java_cdr_format_t format, uint32_t *offset, uint32_t limit) {
+    type_spec = java_resolve_forward(type_spec);
+    cdr_layout_t layout;
+
+    if (!type_spec || *offset > limit) return false;
+
+    switch (idl_type(type_spec)) {
+        case IDL_STRING: {
+            uint32_t maximum = ((const idl_string_t *)type_spec)->maximum;
+            if (maximum == 0) return false;
+            *offset = cdr_align(*offset, 4) + 4 + maximum + 1;
+            break;
+        }
+        case IDL_SEQUENCE: {
+            const idl_sequence_t *seq = (const idl_sequence_t *)type_spec;
+            if (seq->maximum == 0) return false;
+            *offset = cdr_align(*offset, 4) + 4;
+            /* the same DHEADER rule as the codec, through any typedefs of the element */
+            if (format == JAVA_CDR_XCDR2 && cdr_primitive_size(idl_type(codec_unalias(seq->type_spec))) == 0) *offset += 4;
+            for (uint32_t i = 0; i < seq->maximum; i++) {
+                if (!key_extent(seq->type_spec, format, offset, limit)) return false;
+            }
+            break;
+        }
+        case IDL_TYPEDEF:
+            return key_extent(codec_typedef_alias(type_spec), format, offset, limit);
+        case IDL_STRUCT:
+            return struct_key_extent((const idl_struct_t *)type_spec, format, offset, limit);
+        default:
+            if (!cdr_type_layout(type_spec, format, &layout)) return false;
+            *offset = cdr_align(*offset, layout.align) + layout.size;
+            break;
+    }
+    return *offset <= limit;
+}
+
+/*
+ * True if the key of a struct never exceeds limit bytes in format. XCDR1
+ * pads 8-byte members to 8, so a key can fit in XCDR2 and not in XCDR1.
+ */
+bool cdr_key_fits(const idl_struct_t *struct_def, java_cdr_format_t format, uint32_t limit) {
+    uint32_t offset = 0;
+    return struct_key_extent(struct_def, format, &offset, limit);
+}
@@ -13,6 +13,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include "idlc/generator.h"
 #include "idlc/options.h"
@@ -28,33 +31,58 @@ extern int sb_append(string_builder_t *sb, const char *str);
 extern int sb_appendf(string_builder_t *sb, const char *format, ...);
 extern const char *sb_string(const string_builder_t *sb);
 
-extern int generate_java_record(const idl_struct_t *struct_def, const char *output_dir, const char *prefix, bool disable_cdr, const char *class_name);
-extern int generate_java_enum(const idl_enum_t *enum_def, const char *output_dir, const char *prefix, const char *enum_name);
-extern int generate_java_typedef(const idl_typedef_t *typedef_def, const char *output_dir, const char *prefix);
-extern int generate_java_union(const idl_union_t *union_def, const char *output_dir, const char *prefix, const char *union_name);
-extern int generate_java_bitmask(const idl_bitmask_t *bitmask_def, const char *output_dir, const char *prefix, const char *bitmask_name);
-extern char *resolve_package(const idl_node_t *node, const char *prefix);
+extern int generate_java_record(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *class_name);
+extern int generate_java_enum(const idl_enum_t *enum_def, const java_generator_config_t *config, const char *enum_name);
+extern int generate_java_typedef(const idl_typedef_t *typedef_def, const java_generator_config_t *config);
+extern int generate_java_union(const idl_union_t *union_def, const java_generator_config_t *config, const char *union_name);
+extern int generate_java_bitmask(const idl_bitmask_t *bitmask_def, const java_generator_config_t *config, const char *bitmask_name);
+extern int generate_java_instance_cache(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *class_name);
+extern int generate_java_native_struct(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *struct_name);
+extern int generate_java_native_union(const idl_union_t *union_def, const java_generator_config_t *config, const char *union_name);
+extern int generate_java_runtime(const java_generator_config_t *config);
+extern int java_output_begin(const char *output_dir, bool track_owners);
+extern int java_output_end(bool complete);
+extern void java_output_set_owner(const void *owner);
+extern int java_deps_write(const idl_pstate_t *pstate, const java_generator_config_t *config, const char *deps_path);
+extern java_arena_t *java_arena_create(void);
+extern void java_arena_destroy(java_arena_t *arena);
+extern void java_arena_set_current(java_arena_t *arena);
+extern java_arena_t *java_arena_current(void);
+extern const char *resolve_package(const idl_node_t *node, const char *prefix);
+extern bool is_topic_type(const idl_node_t *node);
+extern bool cdr_struct_has_key(const idl_struct_t *struct_def);
+extern void java_set_inline_typedefs(bool enabled);
+
+/* Types collected for parallel emission, in AST order */
+typedef struct work_list {
+    idl_node_t **nodes;
+    size_t count;
+    size_t capacity;
+    atomic_size_t next;     /* next node a worker takes */
+} work_list_t;
 
 typedef struct generator_state {
-    const char *output_dir;
-    const char *package_prefix;
-    bool use_arrays_for_sequences;
-    bool disable_cdr;
-    bool generate_records;
-    int errors;
-    int struct_count;
-    int enum_count;
+    java_generator_config_t config;
+    atomic_int errors;
+    atomic_int struct_count;
+    atomic_int enum_count;
     bool in_module;
     char current_module_name[64];
+    work_list_t *work;      /* collect instead of generate, java-jobs > 1 */
 } generator_state_t;
 
 static const char *java_package_prefix = NULL;
 static int java_use_arrays_flag = 0;
 static int java_disable_cdr_flag = 0;
+static int java_records_flag = 0;
+static int java_inline_typedefs_flag = 0;
+static int java_native_layout_flag = 0;
+static const char *java_cdr_encoding = NULL;
+static const char *java_jobs = NULL;
+static const char *java_deps_file = NULL;
 
-static void process_node(idl_node_t *node, generator_state_t *state) {
-    if (!node) return;
-    
+/* Generates the classes of one struct, enum, union, bitmask or typedef */
+static void generate_node(idl_node_t *node, generator_state_t *state) {
     idl_mask_t mask = idl_mask(node);
     
     if (mask & IDL_STRUCT) {
@@ -73,7 +101,13 @@ static void process_node(idl_node_t *node, generator_state_t *state) {
         printf("Found struct: %s\n", struct_name);
         fflush(stdout);
         
-        int result = generate_java_record(struct_def, state->output_dir, state->package_prefix, state->disable_cdr, struct_name);
+        int result = generate_java_record(struct_def, &state->config, struct_name);
+        if (result == 0 && is_topic_type(node) && cdr_struct_has_key(struct_def)) {
+            result = generate_java_instance_cache(struct_def, &state->config, struct_name);
+        }
+        if (result == 0 && state->config.native_layout) {
+            result = generate_java_native_struct(struct_def, &state->config, struct_name);
+        }
         if (result != 0) {
             fprintf(stderr, "Error generating struct: %s\n", struct_name);
             state->errors++;
@@ -94,7 +128,7 @@ static void process_node(idl_node_t *node, generator_state_t *state) {
         
         printf("Found enum: %s\n", enum_name);
         
-        if (generate_java_enum(enum_def, state->output_dir, state->package_prefix, enum_name) != 0) {
+        if (generate_java_enum(enum_def, &state->config, enum_name) != 0) {
             fprintf(stderr, "Error generating enum: %s\n", enum_name);
             state->errors++;
         }
@@ -109,7 +143,11 @@ static void process_node(idl_node_t *node, generator_state_t *state) {
         
         printf("Found union: %s\n", union_name);
         
-        if (generate_java_union(union_def, state->output_dir, state->package_prefix, union_name) != 0) {
+        int result = generate_java_union(union_def, &state->config, union_name);
+        if (result == 0 && state->config.native_layout) {
+            result = generate_java_native_union(union_def, &state->config, union_name);
+        }
+        if (result != 0) {
             fprintf(stderr, "Error generating union: %s\n", union_name);
             state->errors++;
         }
@@ -124,7 +162,7 @@ static void process_node(idl_node_t *node, generator_state_t *state) {
         
         printf("Found bitmask: %s\n", bitmask_name);
         
-        if (generate_java_bitmask(bitmask_def, state->output_dir, state->package_prefix, bitmask_name) != 0) {
+        if (generate_java_bitmask(bitmask_def, &state->config, bitmask_name) != 0) {
             fprintf(stderr, "Error generating bitmask: %s\n", bitmask_name);
             state->errors++;
         }
@@ -134,11 +172,41 @@ static void process_node(idl_node_t *node, generator_state_t *state) {
         
         printf("Found typedef\n");
         
-        if (generate_java_typedef(typedef_def, state->output_dir, state->package_prefix) != 0) {
+        if (generate_java_typedef(typedef_def, &state->config) != 0) {
             fprintf(stderr, "Error generating typedef\n");
             state->errors++;
         }
     }
+}
+
+static int work_list_add(work_list_t *work, idl_node_t *node) {
+    if (work->count == work->capacity) {
+        size_t capacity = work->capacity ? 2 * work->capacity : 64;
+        idl_node_t **nodes = realloc(work->nodes, capacity * sizeof(*nodes));
+        if (!nodes) return -1;
+        work->nodes = nodes;
+        work->capacity = capacity;
+    }
+    work->nodes[work->count++] = node;
+    return 0;
+}
+
+static void process_node(idl_node_t *node, generator_state_t *state) {
+    if (!node) return;
+    
+    idl_mask_t mask = idl_mask(node);
+    
+    /* forward declarations carry IDL_STRUCT or IDL_UNION too; their definition is generated */
+    if ((mask & (IDL_STRUCT | IDL_ENUM | IDL_UNION | IDL_BITMASK | IDL_TYPEDEF)) && !(mask & IDL_FORWARD)) {
+        if (!state->work) {
+            java_output_set_owner(node);
+            generate_node(node, state);
+            java_output_set_owner(NULL);
+        } else if (work_list_add(state->work, node) != 0) {
+            fprintf(stderr, "Error: out of memory collecting types\n");
+            state->errors++;
+        }
+    }
     else if (mask & IDL_MODULE) {
         idl_module_t *module = (idl_module_t *)node;
         
@@ -170,17 +238,106 @@ static void process_node(idl_node_t *node, generator_state_t *state) {
     }
 }
 
-static int generate_types(const idl_pstate_t *pstate, generator_state_t *state) {
+/* Workers allocate from an arena of their own, released when they run out of types */
+static void *generate_worker(void *arg) {
+    generator_state_t *state = arg;
+    work_list_t *work = state->work;
+    java_arena_t *previous = java_arena_current();
+    java_arena_t *arena = java_arena_create();
+    if (!arena) {
+        fprintf(stderr, "Error: out of memory\n");
+        state->errors++;
+        return NULL;
+    }
+    java_arena_set_current(arena);
+    size_t index;
+    while ((index = atomic_fetch_add(&work->next, 1)) < work->count) {
+        java_output_set_owner(work->nodes[index]);
+        generate_node(work->nodes[index], state);
+    }
+    java_output_set_owner(NULL);
+    java_arena_set_current(previous);
+    java_arena_destroy(arena);
+    return NULL;
+}
+
+/*
+ * java-jobs > 1: the types are collected first and then generated by a pool
+ * of threads taking them in AST order. Every type writes its own files and
+ * builds them in its own string builders, so only the counters and the
+ * per-package classes written through java_write_class() are shared, and the
+ * output is the same as with a single job.
+ */
+static void generate_parallel(idl_node_t *root, generator_state_t *state, long jobs) {
+    work_list_t work = { .nodes = NULL, .count = 0, .capacity = 0 };
+    atomic_init(&work.next, 0);
+    state->work = &work;
+    process_node(root, state);
+    
+    if ((size_t)jobs > work.count) jobs = work.count > 0 ? (long)work.count : 1;
+    pthread_t *threads = calloc((size_t)jobs, sizeof(*threads));
+    long started = 0;
+    if (threads) {
+        for (; started < jobs; started++) {
+            if (pthread_create(&threads[started], NULL, generate_worker, state) != 0) break;
+        }
+    }
+    /* fewer threads than asked for only means less parallelism */
+    if (started == 0) generate_worker(state);
+    for (long i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    free(threads);
+    free(work.nodes);
+    state->work = NULL;
+}
+
+static int generate_types(const idl_pstate_t *pstate, generator_state_t *state, long jobs) {
     if (!pstate || !pstate->root) {
         fprintf(stderr, "Error: No AST to process\n");
         return -1;
     }
     
-    process_node((idl_node_t *)pstate->root, state);
+    if (jobs > 1) {
+        generate_parallel((idl_node_t *)pstate->root, state, jobs);
+    } else {
+        process_node((idl_node_t *)pstate->root, state);
+    }
     
-    printf("Found %d structs and %d enums\n", state->struct_count, state->enum_count);
+    printf("Found %d structs and %d enums\n", atomic_load(&state->struct_count), atomic_load(&state->enum_count));
     
-    return state->errors;
+    return atomic_load(&state->errors);
+}
+
+static int parse_cdr_format(const char *name, java_cdr_format_t *format) {
+    if (!name || strcmp(name, "packed") == 0) {
+        *format = JAVA_CDR_PACKED;
+    } else if (strcmp(name, "xcdr1") == 0) {
+        *format = JAVA_CDR_XCDR1;
+    } else if (strcmp(name, "xcdr2") == 0) {
+        *format = JAVA_CDR_XCDR2;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/* java-jobs: number of generator threads, 0 for one per online CPU */
+static int parse_jobs(const char *value, long *jobs) {
+    if (!value) {
+        *jobs = 1;
+        return 0;
+    }
+    char *end;
+    long n = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || n < 0 || n > 1024) return -1;
+    if (n == 0) {
+        n = sysconf(_SC_NPROCESSORS_ONLN);
+        if (n < 1) n = 1;
+    }
+    *jobs = n;
+    return 0;
 }
 
 static const idlc_option_t **generator_options(void) {
@@ -209,6 +366,54 @@ static const idlc_option_t **generator_options(void) {
             .argument = NULL,
             .help = "Disable CDR serialization code generation"
         },
+        {
+            .type = IDLC_FLAG,
+            .store = { .flag = &java_records_flag },
+            .option = 0,
+            .suboption = "java-records",
+            .argument = NULL,
+            .help = "Generate plain final classes instead of JNA Structures"
+        },
+        {
+            .type = IDLC_FLAG,
+            .store = { .flag = &java_inline_typedefs_flag },
+            .option = 0,
+            .suboption = "java-inline-typedefs",
+            .argument = NULL,
+            .help = "Use the aliased type for typedef members instead of alias classes"
+        },
+        {
+            .type = IDLC_FLAG,
+            .store = { .flag = &java_native_layout_flag },
+            .option = 0,
+            .suboption = "java-native-layout",
+            .argument = NULL,
+            .help = "Also generate <Type>Native JNA Structures with the C layout of idlc -l c"
+        },
+        {
+            .type = IDLC_STRING,
+            .store = { .string = &java_cdr_encoding },
+            .option = 0,
+            .suboption = "java-cdr",
+            .argument = "<packed|xcdr1|xcdr2>",
+            .help = "CDR encoding of the generated codec (default: packed)"
+        },
+        {
+            .type = IDLC_STRING,
+            .store = { .string = &java_jobs },
+            .option = 0,
+            .suboption = "java-jobs",
+            .argument = "<n>",
+            .help = "Generate types on n threads, 0 for one per CPU (default: 1)"
+        },
+        {
+            .type = IDLC_STRING,
+            .store = { .string = &java_deps_file },
+            .option = 0,
+            .suboption = "java-deps",
+            .argument = "<file>",
+            .help = "Write the type and file dependency graph as JSON to file"
+        },
         { .type = 0 }
     };
     
@@ -216,6 +421,12 @@ static const idlc_option_t **generator_options(void) {
         &options[0],
         &options[1],
         &options[2],
+        &options[3],
+        &options[4],
+        &options[5],
+        &options[6],
+        &options[7],
+        &options[8],
         NULL
     };
     
@@ -233,29 +444,69 @@ int generate(const idl_pstate_t *pstate, const idlc_generator_config_t *config)
         output_dir = ".";
     }
     
+    java_cdr_format_t cdr_format;
+    if (parse_cdr_format(java_cdr_encoding, &cdr_format) != 0) {
+        fprintf(stderr, "Error: unknown java-cdr encoding '%s' (expected packed, xcdr1 or xcdr2)\n", java_cdr_encoding);
+        return -1;
+    }
+    
+    long jobs;
+    if (parse_jobs(java_jobs, &jobs) != 0) {
+        fprintf(stderr, "Error: invalid java-jobs value '%s' (expected 0 to 1024)\n", java_jobs);
+        return -1;
+    }
+    
     generator_state_t state = {
-        .output_dir = output_dir,
-        .package_prefix = java_package_prefix,
-        .use_arrays_for_sequences = (java_use_arrays_flag != 0),
-        .disable_cdr = (java_disable_cdr_flag != 0),
-        .generate_records = true,
+        .config = {
+            .output_dir = output_dir,
+            .package_prefix = java_package_prefix,
+            .use_arrays_for_sequences = (java_use_arrays_flag != 0),
+            .disable_cdr = (java_disable_cdr_flag != 0),
+            .generate_records = (java_records_flag != 0),
+            .inline_typedefs = (java_inline_typedefs_flag != 0),
+            .native_layout = (java_native_layout_flag != 0),
+            .cdr_format = cdr_format
+        },
         .errors = 0,
         .struct_count = 0,
         .enum_count = 0,
         .in_module = false,
-        .current_module_name = ""
+        .current_module_name = "",
+        .work = NULL
     };
     
-    mkdir(state.output_dir, 0755);
+    mkdir(state.config.output_dir, 0755);
+    java_set_inline_typedefs(state.config.inline_typedefs);
+    
+    printf("Generating Java code to: %s\n", state.config.output_dir);
     
-    printf("Generating Java code to: %s\n", state.output_dir);
+    java_arena_t *arena = java_arena_create();
+    if (!arena || java_output_begin(state.config.output_dir, java_deps_file != NULL) != 0) {
+        java_arena_destroy(arena);
+        fprintf(stderr, "Error: out of memory\n");
+        return -1;
+    }
+    java_arena_set_current(arena);
     
-    int ret = generate_types(pstate, &state);
+    int ret = generate_types(pstate, &state, jobs);
+    if (ret == 0 && generate_java_runtime(&state.config) != 0) {
+        fprintf(stderr, "Error generating the CDR runtime\n");
+        ret = ++state.errors;
+    }
+    if (ret == 0 && java_deps_file && java_deps_write(pstate, &state.config, java_deps_file) != 0) {
+        fprintf(stderr, "Error writing the dependency graph: %s\n", java_deps_file);
+        ret = ++state.errors;
+    }
+    if (java_output_end(ret == 0) != 0 && ret == 0) {
+        ret = ++state.errors;
+    }
+    java_arena_set_current(NULL);
+    java_arena_destroy(arena);
     
     if (ret == 0) {
         printf("Java code generation completed successfully\n");
     } else {
-        fprintf(stderr, "Java code generation completed with %d errors\n", state.errors);
+        fprintf(stderr, "Java code generation completed with %d errors\n", atomic_load(&state.errors));
     }
     
     return ret;
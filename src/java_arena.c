@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * Per-run arena. Type names, packages and the struct member tables are bump
+ * allocated from large chunks and released all at once when the run ends,
+ * instead of being malloc'd and freed at every call site. Strings go through
+ * an intern table, so the same Java type name built for every member that
+ * uses it is stored once and compares equal by pointer.
+ *
+ * Each thread allocates from its own current arena: generate() sets one up
+ * for the calling thread and every java-jobs worker has its own, so the
+ * arenas need no locking. Nothing allocated by a worker outlives it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "idlc_java.h"
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGN _Alignof(max_align_t)
+
+typedef struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;
+    size_t used;
+    _Alignas(max_align_t) char data[];
+} arena_chunk_t;
+
+typedef struct intern_slot {
+    const char *str;    /* NULL if free */
+    uint64_t hash;
+} intern_slot_t;
+
+struct java_arena {
+    arena_chunk_t *chunks;      /* current chunk first */
+    intern_slot_t *slots;
+    size_t slot_count;          /* power of two, at least twice interned */
+    size_t interned;
+};
+
+static _Thread_local java_arena_t *current_arena = NULL;
+
+static uint64_t fnv1a(const char *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+java_arena_t *java_arena_create(void) {
+    return calloc(1, sizeof(java_arena_t));
+}
+
+void java_arena_destroy(java_arena_t *arena) {
+    if (!arena) return;
+    arena_chunk_t *chunk = arena->chunks;
+    while (chunk) {
+        arena_chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena->slots);
+    free(arena);
+}
+
+/* Makes arena the one this thread allocates from, NULL for none */
+void java_arena_set_current(java_arena_t *arena) {
+    current_arena = arena;
+}
+
+java_arena_t *java_arena_current(void) {
+    return current_arena;
+}
+
+/* size bytes from the current arena, aligned for any type; NULL without one or out of memory */
+void *java_arena_alloc(size_t size) {
+    java_arena_t *arena = current_arena;
+    if (!arena) return NULL;
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    arena_chunk_t *chunk = arena->chunks;
+    if (!chunk || chunk->size - chunk->used < size) {
+        /* oversized requests get a chunk of their own behind the current one */
+        size_t chunk_size = size > ARENA_CHUNK_SIZE / 4 ? size : ARENA_CHUNK_SIZE;
+        arena_chunk_t *fresh = malloc(sizeof(*fresh) + chunk_size);
+        if (!fresh) return NULL;
+        fresh->size = chunk_size;
+        fresh->used = 0;
+        if (chunk && chunk_size != ARENA_CHUNK_SIZE) {
+            fresh->next = chunk->next;
+            chunk->next = fresh;
+        } else {
+            fresh->next = chunk;
+            arena->chunks = fresh;
+        }
+        chunk = fresh;
+    }
+    void *p = chunk->data + chunk->used;
+    chunk->used += size;
+    return p;
+}
+
+static intern_slot_t *find_slot(intern_slot_t *slots, size_t slot_count, const char *str, size_t len, uint64_t hash) {
+    size_t mask = slot_count - 1;
+    size_t i = hash & mask;
+    while (slots[i].str && (slots[i].hash != hash || strncmp(slots[i].str, str, len) != 0 || slots[i].str[len] != '\0')) {
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static int grow_slots(java_arena_t *arena) {
+    size_t slot_count = arena->slot_count ? 2 * arena->slot_count : 256;
+    intern_slot_t *slots = calloc(slot_count, sizeof(*slots));
+    if (!slots) return -1;
+    for (size_t i = 0; i < arena->slot_count; i++) {
+        const intern_slot_t *old = &arena->slots[i];
+        if (old->str) *find_slot(slots, slot_count, old->str, strlen(old->str), old->hash) = *old;
+    }
+    free(arena->slots);
+    arena->slots = slots;
+    arena->slot_count = slot_count;
+    return 0;
+}
+
+static const char *intern(const char *str, size_t len) {
+    java_arena_t *arena = current_arena;
+    if (!arena) return NULL;
+    if (2 * (arena->interned + 1) > arena->slot_count && grow_slots(arena) != 0) return NULL;
+
+    uint64_t hash = fnv1a(str, len);
+    intern_slot_t *slot = find_slot(arena->slots, arena->slot_count, str, len, hash);
+    if (!slot->str) {
+        char *copy = java_arena_alloc(len + 1);
+        if (!copy) return NULL;
+        memcpy(copy, str, len);
+        copy[len] = '\0';
+        slot->str = copy;
+        slot->hash = hash;
+        arena->interned++;
+    }
+    return slot->str;
+}
+
+/* The current arena's copy of str, shared by every caller interning the same text */
+const char *java_intern(const char *str) {
+    return str ? intern(str, strlen(str)) : NULL;
+}
+
+const char *java_internf(const char *format, ...) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, format);
+    int len = vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+    if (len < 0) return NULL;
+    if ((size_t)len < sizeof(buf)) return intern(buf, (size_t)len);
+
+    char *tmp = malloc((size_t)len + 1);
+    if (!tmp) return NULL;
+    va_start(ap, format);
+    vsnprintf(tmp, (size_t)len + 1, format, ap);
+    va_end(ap);
+    const char *result = intern(tmp, (size_t)len);
+    free(tmp);
+    return result;
+}
@@ -0,0 +1,871 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * Type-directed emitters for the Java CDR codec. Each emitter produces the
+ * statements that size, write or read one value of an IDL type, recursing into
+ * sequence elements and typedef aliases. The same emitters serve the packed
+ * legacy encoding and the aligned XCDR1/XCDR2 encodings; the format decides
+ * alignment, string termination, enum widths and DHEADERs.
+ *
+ * Generated locals are suffixed with the nesting depth (len, len1, ...) so
+ * nested sequences never shadow each other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include "idlc_java.h"
+
+typedef struct string_builder string_builder_t;
+
+extern int sb_append(string_builder_t *sb, const char *str);
+extern int sb_appendf(string_builder_t *sb, const char *format, ...);
+
+extern const char *java_type_name(const idl_type_spec_t *type_spec, bool boxed);
+extern const char *java_default_value(idl_type_t type);
+extern uint32_t cdr_primitive_size(idl_type_t type);
+extern uint32_t cdr_max_align(java_cdr_format_t format);
+extern uint32_t cdr_enum_size(const idl_enum_t *enum_def, java_cdr_format_t format);
+extern uint32_t cdr_bitmask_size(const idl_bitmask_t *bitmask_def);
+extern const idl_type_spec_t *java_resolve_alias(const idl_type_spec_t *type_spec);
+
+static void emit(java_codec_t *codec, int indent, const char *format, ...) {
+    char tmp[1024];
+    char *line = tmp;
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(tmp, sizeof(tmp), format, args);
+    va_end(args);
+    if (len < 0) return;
+    if ((size_t)len >= sizeof(tmp)) {
+        line = malloc(len + 1);
+        if (!line) return;
+        va_start(args, format);
+        vsnprintf(line, len + 1, format, args);
+        va_end(args);
+    }
+
+    sb_appendf(codec->sb, "%*s%s\n", indent, "", line);
+    if (line != tmp) free(line);
+}
+
+/* base name of a generated local at the given nesting depth */
+static const char *local_name(char *buf, size_t size, const char *base, int depth) {
+    if (depth == 0) {
+        snprintf(buf, size, "%s", base);
+    } else {
+        snprintf(buf, size, "%s%d", base, depth);
+    }
+    return buf;
+}
+
+/* Aliased type of a typedef declarator */
+const idl_type_spec_t *codec_typedef_alias(const idl_type_spec_t *type_spec) {
+    const idl_node_t *parent = ((const idl_node_t *)type_spec)->parent;
+    if (!parent || !(idl_mask(parent) & IDL_TYPEDEF)) return NULL;
+    return ((const idl_typedef_t *)parent)->type_spec;
+}
+
+/* Type a typedef chain ends in */
+const idl_type_spec_t *codec_unalias(const idl_type_spec_t *type_spec) {
+    while (type_spec && idl_type(type_spec) == IDL_TYPEDEF) {
+        type_spec = codec_typedef_alias(type_spec);
+    }
+    return type_spec;
+}
+
+void codec_init(java_codec_t *codec, string_builder_t *sb, java_cdr_format_t format, bool use_arrays) {
+    codec->sb = sb;
+    codec->format = format;
+    codec->use_arrays = use_arrays;
+    codec->key_only = false;
+    codec->known_align = 1;
+    codec->pending = 0;
+}
+
+static bool is_packed(const java_codec_t *codec) {
+    return codec->format == JAVA_CDR_PACKED;
+}
+
+static uint32_t natural_align(const java_codec_t *codec, uint32_t size) {
+    uint32_t max_align = cdr_max_align(codec->format);
+    return size < max_align ? size : max_align;
+}
+
+/* Track the alignment of the stream position after `size` more bytes */
+static void advance(java_codec_t *codec, uint32_t size) {
+    if (size == 0) return;
+    uint32_t low_bit = size & (~size + 1);
+    if (low_bit < codec->known_align) codec->known_align = low_bit;
+}
+
+/* ByteBuffer accessor suffix for an integer of the given width */
+const char *codec_width_accessor(uint32_t width) {
+    switch (width) {
+        case 1: return "";
+        case 2: return "Short";
+        case 8: return "Long";
+        default: return "Int";
+    }
+}
+
+/* Cast narrowing an int/long value to the given width */
+const char *codec_width_cast(uint32_t width) {
+    switch (width) {
+        case 1: return "(byte) ";
+        case 2: return "(short) ";
+        case 4: return "(int) ";
+        default: return "";
+    }
+}
+
+static uint32_t enum_width(const java_codec_t *codec, const idl_type_spec_t *type_spec) {
+    return cdr_enum_size((const idl_enum_t *)type_spec, codec->format);
+}
+
+/* Bitmasks are written at their @bit_bound width in every format */
+static uint32_t bitmask_width(const java_codec_t *codec, const idl_type_spec_t *type_spec) {
+    return cdr_bitmask_size((const idl_bitmask_t *)type_spec);
+}
+
+/* Encoded size of a value of constant size (primitive, enum, bitmask), else 0 */
+static uint32_t constant_size(const java_codec_t *codec, const idl_type_spec_t *type_spec) {
+    idl_type_t type = idl_type(type_spec);
+    if (type == IDL_ENUM) return enum_width(codec, type_spec);
+    if (type == IDL_BITMASK) return bitmask_width(codec, type_spec);
+    return cdr_primitive_size(type);
+}
+
+/* ByteBuffer view used for bulk transfer of a primitive array, NULL if none */
+static const char *buffer_view_name(idl_type_t type) {
+    switch (type) {
+        case IDL_SHORT: return "Short";
+        case IDL_USHORT: return "Char";
+        case IDL_LONG:
+        case IDL_ULONG: return "Int";
+        case IDL_LLONG:
+        case IDL_ULLONG: return "Long";
+        case IDL_FLOAT: return "Float";
+        case IDL_DOUBLE: return "Double";
+        default: return NULL;
+    }
+}
+
+/* ByteBuffer accessor suffix for a primitive: put<X>/get<X> */
+static const char *primitive_accessor(idl_type_t type) {
+    switch (type) {
+        case IDL_SHORT: return "Short";
+        case IDL_USHORT: return "Char";
+        case IDL_LONG:
+        case IDL_ULONG: return "Int";
+        case IDL_LLONG:
+        case IDL_ULLONG: return "Long";
+        case IDL_FLOAT: return "Float";
+        case IDL_DOUBLE: return "Double";
+        default: return "";
+    }
+}
+
+/* Element type of a sequence, with the alias resolved when typedefs are inlined */
+static const idl_type_spec_t *element_type(const idl_sequence_t *seq) {
+    return java_resolve_alias(seq->type_spec);
+}
+
+/* True if the sequence is emitted as a Java primitive array (java-use-arrays) */
+static bool is_primitive_array(const java_codec_t *codec, const idl_sequence_t *seq) {
+    return codec->use_arrays && cdr_primitive_size(idl_type(element_type(seq))) > 0;
+}
+
+/* XCDR2 puts a DHEADER in front of sequences of anything but primitives */
+static bool sequence_has_dheader(const java_codec_t *codec, const idl_sequence_t *seq) {
+    if (codec->format != JAVA_CDR_XCDR2) return false;
+    return cdr_primitive_size(idl_type(codec_unalias(seq->type_spec))) == 0;
+}
+
+/*
+ * EMHEADER length code of a mutable member, picked like the C serializer
+ * does: 0-3 for 1/2/4/8-byte values, 5-7 when the value starts with a
+ * length or DHEADER that gives its size, else 4 with a NEXTINT.
+ */
+uint32_t codec_length_code(const java_codec_t *codec, const idl_type_spec_t *type_spec) {
+    type_spec = codec_unalias(java_resolve_alias(type_spec));
+    if (!type_spec) return 4;
+
+    switch (idl_type(type_spec)) {
+        case IDL_STRING:
+            return 5;
+        case IDL_SEQUENCE: {
+            const idl_sequence_t *seq = (const idl_sequence_t *)type_spec;
+            if (sequence_has_dheader(codec, seq)) return 5;
+            switch (constant_size(codec, codec_unalias(seq->type_spec))) {
+                case 1: return 5;
+                case 4: return 6;
+                case 8: return 7;
+                default: return 4;
+            }
+        }
+        default:
+            switch (constant_size(codec, type_spec)) {
+                case 1: return 0;
+                case 2: return 1;
+                case 4: return 2;
+                case 8: return 3;
+                default: return 4;
+            }
+    }
+}
+
+/*
+ * True if the XCDR codecs can encode a value of the type. Array typedefs
+ * cannot: their Java holder carries a single element, where the stream
+ * carries every element of every dimension.
+ */
+bool codec_type_encodable(const idl_type_spec_t *type_spec) {
+    while (type_spec) {
+        idl_type_t type = idl_type(type_spec);
+        if (type == IDL_TYPEDEF) {
+            if (idl_is_array(type_spec)) return false;
+            type_spec = codec_typedef_alias(type_spec);
+        } else if (type == IDL_SEQUENCE) {
+            type_spec = ((const idl_sequence_t *)type_spec)->type_spec;
+        } else {
+            break;
+        }
+    }
+    return true;
+}
+
+/* Expression for the value wrapped by a typedef instance, defaulted if null */
+static char *alias_value_expr(const idl_type_spec_t *type_spec, const char *expr) {
+    const idl_type_spec_t *alias = codec_typedef_alias(type_spec);
+    const char *fallback = java_default_value(idl_type(alias));
+    size_t len = 2 * strlen(expr) + strlen(fallback) + 32;
+    char *value = malloc(len);
+    snprintf(value, len, "(%s != null ? %s.value : %s)", expr, expr, fallback);
+    return value;
+}
+
+void codec_size_flush(java_codec_t *codec, int indent) {
+    if (codec->pending == 0) return;
+    emit(codec, indent, "%s += %u;", is_packed(codec) ? "size" : "pos", codec->pending);
+    codec->pending = 0;
+}
+
+/* The packed size is order-independent, so constants are only flushed at loop ends */
+static void size_sync(java_codec_t *codec, int indent) {
+    if (!is_packed(codec)) codec_size_flush(codec, indent);
+}
+
+void codec_size_align(java_codec_t *codec, int indent, uint32_t align) {
+    if (is_packed(codec) || align <= codec->known_align) return;
+    codec_size_flush(codec, indent);
+    emit(codec, indent, "pos = (pos + %u) & ~%u;", align - 1, align - 1);
+    codec->known_align = align;
+}
+
+void codec_size_add(java_codec_t *codec, uint32_t size) {
+    codec->pending += size;
+    advance(codec, size);
+}
+
+void codec_write_align(java_codec_t *codec, int indent, uint32_t align) {
+    if (is_packed(codec) || align <= codec->known_align) return;
+    emit(codec, indent, "CdrWriter.writePadding(buffer, %u);", align);
+    codec->known_align = align;
+}
+
+void codec_read_align(java_codec_t *codec, int indent, uint32_t align) {
+    if (is_packed(codec) || align <= codec->known_align) return;
+    emit(codec, indent, "CdrReader.skipPadding(buffer, %u);", align);
+    codec->known_align = align;
+}
+
+/* Alignment after a sequence whose elements have constant size elem_size */
+static uint32_t align_after_sequence(const java_codec_t *codec, uint32_t elem_size) {
+    if (elem_size == 0) return 1;
+    uint32_t align = elem_size < 4 ? elem_size : 4;
+    return is_packed(codec) ? 1 : align;
+}
+
+/* ---- size ---------------------------------------------------------------- */
+
+static void size_sequence(java_codec_t *codec, const idl_sequence_t *seq, const char *expr, int indent, int depth) {
+    char elem[32];
+    bool array = is_primitive_array(codec, seq);
+    uint32_t elem_size = constant_size(codec, element_type(seq));
+
+    local_name(elem, sizeof(elem), "elem", depth);
+
+    if (sequence_has_dheader(codec, seq)) {
+        codec_size_align(codec, indent, 4);
+        codec_size_add(codec, 4);
+    }
+    codec_size_align(codec, indent, 4);
+    codec_size_add(codec, 4);
+
+    if (elem_size > 0) {
+        uint32_t align = natural_align(codec, elem_size);
+        char count[256];
+        snprintf(count, sizeof(count), array ? "%s.length" : "%s.size()", expr);
+        size_sync(codec, indent);
+        if (align > codec->known_align) {
+            /* XCDR1 aligns 8-byte elements, but only if there are any */
+            emit(codec, indent, "if (%s != null && %s > 0) pos = ((pos + %u) & ~%u) + %s * %u;",
+                 expr, count, align - 1, align - 1, count, elem_size);
+        } else {
+            emit(codec, indent, "if (%s != null) %s += %s * %u;", expr, is_packed(codec) ? "size" : "pos", count, elem_size);
+        }
+        codec->known_align = align_after_sequence(codec, elem_size);
+        return;
+    }
+
+    /* constants inside the loop are per element, keep them apart from ours */
+    const char *elem_type = java_type_name(element_type(seq), true);
+    size_sync(codec, indent);
+    uint32_t saved = codec->pending;
+    codec->pending = 0;
+
+    emit(codec, indent, "if (%s != null) {", expr);
+    emit(codec, indent + 4, "for (%s %s : %s) {", elem_type, elem, expr);
+    codec->known_align = 1;
+    codec_emit_size(codec, element_type(seq), elem, indent + 8, depth + 1);
+    codec_size_flush(codec, indent + 8);
+    emit(codec, indent + 4, "}");
+    emit(codec, indent, "}");
+
+    codec->pending = saved;
+    codec->known_align = 1;
+}
+
+void codec_emit_size(java_codec_t *codec, const idl_type_spec_t *type_spec, const char *expr, int indent, int depth) {
+    type_spec = java_resolve_alias(type_spec);
+    idl_type_t type = idl_type(type_spec);
+    uint32_t size = cdr_primitive_size(type);
+    const char *var = is_packed(codec) ? "size" : "pos";
+
+    if (size > 0) {
+        codec_size_align(codec, indent, natural_align(codec, size));
+        codec_size_add(codec, size);
+        return;
+    }
+
+    switch (type) {
+        case IDL_STRING:
+            codec_size_align(codec, indent, 4);
+            codec_size_add(codec, is_packed(codec) ? 4 : 5);
+            size_sync(codec, indent);
+            emit(codec, indent, "if (%s != null) %s += CdrWriter.utf8Length(%s);", expr, var, expr);
+            codec->known_align = 1;
+            break;
+        case IDL_WSTRING:
+            if (is_packed(codec)) {
+                /* legacy encoding only carries wstrings inside sequences, as UTF-8 */
+                if (depth == 0) break;
+                codec_size_add(codec, 4);
+                emit(codec, indent, "if (%s != null) size += CdrWriter.utf8Length(%s);", expr, expr);
+                break;
+            }
+            codec_size_align(codec, indent, 4);
+            codec_size_add(codec, 4);
+            size_sync(codec, indent);
+            emit(codec, indent, "if (%s != null) pos += %s.length() * 2;", expr, expr);
+            codec->known_align = 2;
+            break;
+        case IDL_SEQUENCE:
+            size_sequence(codec, (const idl_sequence_t *)type_spec, expr, indent, depth);
+            break;
+        case IDL_STRUCT:
+        case IDL_UNION: {
+            if (is_packed(codec)) {
+                emit(codec, indent, "if (%s != null) size += %s.getSerializedSize();", expr, expr);
+                break;
+            }
+            const char *type_name = java_type_name(type_spec, false);
+            codec_size_flush(codec, indent);
+            emit(codec, indent, "pos = (%s != null ? %s : new %s()).%s(pos);", expr, expr, type_name,
+                 codec->key_only ? "keySerializedEnd" : "serializedEnd");
+            codec->known_align = 1;
+            break;
+        }
+        case IDL_ENUM:
+        case IDL_BITMASK: {
+            uint32_t width = constant_size(codec, type_spec);
+            codec_size_align(codec, indent, natural_align(codec, width));
+            codec_size_add(codec, width);
+            break;
+        }
+        case IDL_TYPEDEF: {
+            /* legacy encoding skips typedef members */
+            if (is_packed(codec)) break;
+            char *value = alias_value_expr(type_spec, expr);
+            codec_emit_size(codec, codec_typedef_alias(type_spec), value, indent, depth);
+            free(value);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/* ---- write --------------------------------------------------------------- */
+
+/* Packed strings are length-prefixed with -1 for null; XCDR ones count and write the NUL */
+static void write_string(java_codec_t *codec, const char *expr, int indent) {
+    codec_write_align(codec, indent, 4);
+    emit(codec, indent, "CdrWriter.%s(buffer, %s);", is_packed(codec) ? "writePackedString" : "writeString", expr);
+    codec->known_align = 1;
+}
+
+static void write_primitive_array(java_codec_t *codec, const idl_sequence_t *seq, const char *expr, const char *count, int indent, int depth) {
+    idl_type_t elem_type = idl_type(element_type(seq));
+    uint32_t elem_size = cdr_primitive_size(elem_type);
+    const char *view = buffer_view_name(elem_type);
+    char elem[32];
+    local_name(elem, sizeof(elem), "elem", depth);
+
+    if (view) {
+        emit(codec, indent, "buffer.as%sBuffer().put(%s);", view, expr);
+        emit(codec, indent, "buffer.position(buffer.position() + %s * %u);", count, elem_size);
+    } else if (elem_type == IDL_BOOL) {
+        emit(codec, indent, "for (boolean %s : %s) {", elem, expr);
+        emit(codec, indent + 4, "buffer.put(%s ? (byte) 1 : (byte) 0);", elem);
+        emit(codec, indent, "}");
+    } else {
+        emit(codec, indent, "buffer.put(%s);", expr);
+    }
+}
+
+static void write_sequence(java_codec_t *codec, const idl_sequence_t *seq, const char *expr, int indent, int depth) {
+    char elem[32], count[32], dheader[32];
+    bool array = is_primitive_array(codec, seq);
+    uint32_t elem_size = constant_size(codec, element_type(seq));
+    uint32_t elem_align = natural_align(codec, elem_size ? elem_size : 1);
+    const char *elem_type = java_type_name(element_type(seq), true);
+
+    local_name(elem, sizeof(elem), "elem", depth);
+    local_name(count, sizeof(count), "count", depth);
+    local_name(dheader, sizeof(dheader), "seqHeader", depth);
+
+    if (is_packed(codec)) {
+        emit(codec, indent, "if (%s != null) {", expr);
+        emit(codec, indent + 4, "buffer.putInt(%s.%s);", expr, array ? "length" : "size()");
+        if (array) {
+            char length[256];
+            snprintf(length, sizeof(length), "%s.length", expr);
+            write_primitive_array(codec, seq, expr, length, indent + 4, depth);
+        } else {
+            emit(codec, indent + 4, "for (%s %s : %s) {", elem_type, elem, expr);
+            codec_emit_write(codec, element_type(seq), elem, indent + 8, depth + 1);
+            emit(codec, indent + 4, "}");
+        }
+        emit(codec, indent, "} else {");
+        emit(codec, indent + 4, "buffer.putInt(-1);");
+        emit(codec, indent, "}");
+        return;
+    }
+
+    bool has_dheader = sequence_has_dheader(codec, seq);
+    emit(codec, indent, "{");
+    if (has_dheader) {
+        codec_write_align(codec, indent + 4, 4);
+        emit(codec, indent + 4, "int %s = CdrWriter.beginLength(buffer);", dheader);
+    }
+    codec_write_align(codec, indent + 4, 4);
+    emit(codec, indent + 4, "int %s = %s != null ? %s.%s : 0;", count, expr, expr, array ? "length" : "size()");
+    emit(codec, indent + 4, "buffer.putInt(%s);", count);
+    emit(codec, indent + 4, "if (%s > 0) {", count);
+    if (elem_size > 0) {
+        /* constant-size elements stay aligned once the first one is */
+        codec->known_align = 4;
+        codec_write_align(codec, indent + 8, elem_align);
+    } else {
+        codec->known_align = 1;
+    }
+    if (array) {
+        write_primitive_array(codec, seq, expr, count, indent + 8, depth);
+    } else {
+        emit(codec, indent + 8, "for (%s %s : %s) {", elem_type, elem, expr);
+        codec->known_align = elem_size > 0 ? elem_align : 1;
+        codec_emit_write(codec, element_type(seq), elem, indent + 12, depth + 1);
+        emit(codec, indent + 8, "}");
+    }
+    emit(codec, indent + 4, "}");
+    if (has_dheader) {
+        emit(codec, indent + 4, "CdrWriter.endLength(buffer, %s);", dheader);
+    }
+    emit(codec, indent, "}");
+    codec->known_align = align_after_sequence(codec, elem_size);
+}
+
+void codec_emit_write(java_codec_t *codec, const idl_type_spec_t *type_spec, const char *expr, int indent, int depth) {
+    type_spec = java_resolve_alias(type_spec);
+    idl_type_t type = idl_type(type_spec);
+    uint32_t size = cdr_primitive_size(type);
+
+    if (size > 0) {
+        codec_write_align(codec, indent, natural_align(codec, size));
+        if (type == IDL_BOOL) {
+            emit(codec, indent, "buffer.put(%s ? (byte) 1 : (byte) 0);", expr);
+        } else {
+            emit(codec, indent, "buffer.put%s(%s);", primitive_accessor(type), expr);
+        }
+        advance(codec, size);
+        return;
+    }
+
+    switch (type) {
+        case IDL_STRING:
+            write_string(codec, expr, indent);
+            break;
+        case IDL_WSTRING: {
+            if (is_packed(codec)) {
+                if (depth > 0) write_string(codec, expr, indent);
+                break;
+            }
+            /* UTF-16 code units, length in bytes, no terminator */
+            char chars[32];
+            local_name(chars, sizeof(chars), "chars", depth);
+            codec_write_align(codec, indent, 4);
+            emit(codec, indent, "{");
+            emit(codec, indent + 4, "String %s = %s != null ? %s : \"\";", chars, expr, expr);
+            emit(codec, indent + 4, "buffer.putInt(%s.length() * 2);", chars);
+            emit(codec, indent + 4, "buffer.asCharBuffer().put(%s);", chars);
+            emit(codec, indent + 4, "buffer.position(buffer.position() + %s.length() * 2);", chars);
+            emit(codec, indent, "}");
+            codec->known_align = 2;
+            break;
+        }
+        case IDL_SEQUENCE:
+            write_sequence(codec, (const idl_sequence_t *)type_spec, expr, indent, depth);
+            break;
+        case IDL_STRUCT:
+        case IDL_UNION: {
+            if (is_packed(codec)) {
+                emit(codec, indent, "if (%s != null) {", expr);
+                emit(codec, indent + 4, "%s.serializeInto(buffer);", expr);
+                emit(codec, indent, "}");
+                break;
+            }
+            /* CDR has no null: an unset member goes out as its default */
+            const char *type_name = java_type_name(type_spec, false);
+            emit(codec, indent, "(%s != null ? %s : new %s()).%s(buffer);", expr, expr, type_name,
+                 codec->key_only ? "serializeKey" : "serializeInto");
+            codec->known_align = 1;
+            break;
+        }
+        case IDL_ENUM: {
+            uint32_t width = enum_width(codec, type_spec);
+            codec_write_align(codec, indent, natural_align(codec, width));
+            emit(codec, indent, "buffer.put%s(%s%s.getValue());", codec_width_accessor(width), width == 4 ? "" : codec_width_cast(width), expr);
+            advance(codec, width);
+            break;
+        }
+        case IDL_BITMASK: {
+            uint32_t width = bitmask_width(codec, type_spec);
+            codec_write_align(codec, indent, natural_align(codec, width));
+            emit(codec, indent, "buffer.put%s(%s);", codec_width_accessor(width), expr);
+            advance(codec, width);
+            break;
+        }
+        case IDL_TYPEDEF: {
+            if (is_packed(codec)) {
+                if (depth > 0) {
+                    const char *type_name = java_type_name(type_spec, false);
+                    emit(codec, indent, "// TODO: serialize %s element", type_name);
+                }
+                break;
+            }
+            char *value = alias_value_expr(type_spec, expr);
+            codec_emit_write(codec, codec_typedef_alias(type_spec), value, indent, depth);
+            free(value);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/* ---- read ---------------------------------------------------------------- */
+
+static void read_string(java_codec_t *codec, const char *target, int indent) {
+    codec_read_align(codec, indent, 4);
+    emit(codec, indent, "%s = CdrReader.%s(buffer);", target, is_packed(codec) ? "readPackedString" : "readString");
+    codec->known_align = 1;
+}
+
+/* Expression reading one value of constant size, NULL for other types */
+static char *read_expr(java_codec_t *codec, const idl_type_spec_t *type_spec) {
+    idl_type_t type = idl_type(type_spec);
+    char buf[512];
+
+    if (type == IDL_BOOL) {
+        snprintf(buf, sizeof(buf), "buffer.get() != 0");
+    } else if (cdr_primitive_size(type) > 0) {
+        snprintf(buf, sizeof(buf), "buffer.get%s()", primitive_accessor(type));
+    } else if (type == IDL_ENUM) {
+        uint32_t width = enum_width(codec, type_spec);
+        const char *type_name = java_type_name(type_spec, false);
+        snprintf(buf, sizeof(buf), "%s.fromValue(buffer.get%s()%s)", type_name, codec_width_accessor(width),
+                 width == 1 ? " & 0xff" : width == 2 ? " & 0xffff" : "");
+    } else if (type == IDL_BITMASK) {
+        uint32_t width = bitmask_width(codec, type_spec);
+        snprintf(buf, sizeof(buf), "buffer.get%s()", codec_width_accessor(width));
+    } else {
+        return NULL;
+    }
+    return strdup(buf);
+}
+
+static void read_primitive_array(java_codec_t *codec, const idl_sequence_t *seq, const char *target, const char *len, int indent, int depth) {
+    idl_type_t elem_type = idl_type(element_type(seq));
+    const char *view = buffer_view_name(elem_type);
+    char index[32];
+    local_name(index, sizeof(index), "i", depth);
+
+    if (view) {
+        emit(codec, indent, "buffer.as%sBuffer().get(%s);", view, target);
+        emit(codec, indent, "buffer.position(buffer.position() + %s * %u);", len, cdr_primitive_size(elem_type));
+    } else if (elem_type == IDL_BOOL) {
+        emit(codec, indent, "for (int %s = 0; %s < %s; %s++) {", index, index, len, index);
+        emit(codec, indent + 4, "%s[%s] = buffer.get() != 0;", target, index);
+        emit(codec, indent, "}");
+    } else {
+        emit(codec, indent, "buffer.get(%s);", target);
+    }
+}
+
+/*
+ * Element types decoded into an existing object: the list keeps its first
+ * elements across reads and deserializeFrom() refills them in place.
+ */
+static bool is_reusable_element(java_codec_t *codec, const idl_type_spec_t *type_spec) {
+    switch (idl_type(type_spec)) {
+        case IDL_STRUCT:
+        case IDL_UNION:
+            return true;
+        case IDL_TYPEDEF:
+            return !is_packed(codec);
+        case IDL_SEQUENCE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ * Read element index of a sequence at the given depth into list. Reusable
+ * elements are taken from the first kept entries of the list and stored back;
+ * everything else is appended to the cleared list.
+ */
+static void read_element(java_codec_t *codec, const idl_type_spec_t *type_spec, const char *list, const char *index, const char *kept, int indent, int depth) {
+    idl_type_t type = idl_type(type_spec);
+    char elem[32];
+    local_name(elem, sizeof(elem), "elem", depth);
+
+    char *expr = read_expr(codec, type_spec);
+    if (expr) {
+        uint32_t size = constant_size(codec, type_spec);
+        codec_read_align(codec, indent, natural_align(codec, size));
+        emit(codec, indent, "%s.add(%s);", list, expr);
+        advance(codec, size);
+        free(expr);
+        return;
+    }
+
+    const char *type_name = java_type_name(type_spec, true);
+    if (!is_reusable_element(codec, type_spec)) {
+        if (type == IDL_TYPEDEF) {
+            emit(codec, indent, "// TODO: deserialize %s element", type_name);
+        } else {
+            emit(codec, indent, "%s %s;", type_name, elem);
+            codec_emit_read(codec, type_spec, elem, indent, depth + 1);
+            emit(codec, indent, "%s.add(%s);", list, elem);
+        }
+        return;
+    }
+
+    emit(codec, indent, "%s %s = %s < %s ? %s.get(%s) : null;", type_name, elem, index, kept, list, index);
+    codec_emit_read(codec, type_spec, elem, indent, depth + 1);
+    emit(codec, indent, "if (%s < %s) {", index, kept);
+    emit(codec, indent + 4, "%s.set(%s, %s);", list, index, elem);
+    emit(codec, indent, "} else {");
+    emit(codec, indent + 4, "%s.add(%s);", list, elem);
+    emit(codec, indent, "}");
+}
+
+/*
+ * Sequences are decoded into the list or array the target already holds:
+ * a primitive array is kept when its length matches, a list goes through
+ * CdrReader.reuseList(), which trims it (or clears it, for elements that are
+ * not reused) and raises its capacity to the decoded length.
+ */
+static void read_sequence(java_codec_t *codec, const idl_sequence_t *seq, const char *target, int indent, int depth) {
+    char len[32], index[32], kept[32];
+    bool array = is_primitive_array(codec, seq);
+    uint32_t elem_size = constant_size(codec, element_type(seq));
+    uint32_t elem_align = natural_align(codec, elem_size ? elem_size : 1);
+
+    local_name(len, sizeof(len), "len", depth);
+    local_name(index, sizeof(index), "i", depth);
+    local_name(kept, sizeof(kept), "kept", depth);
+
+    if (sequence_has_dheader(codec, seq)) {
+        codec_read_align(codec, indent, 4);
+        emit(codec, indent, "buffer.getInt();  // DHEADER");
+        advance(codec, 4);
+    }
+    codec_read_align(codec, indent, 4);
+    emit(codec, indent, "{");
+    emit(codec, indent + 4, "int %s = buffer.getInt();", len);
+
+    if (array) {
+        const char *java_elem = java_type_name(element_type(seq), false);
+        if (is_packed(codec)) {
+            emit(codec, indent + 4, "if (%s >= 0) {", len);
+            emit(codec, indent + 8, "if (%s == null || %s.length != %s) {", target, target, len);
+            emit(codec, indent + 12, "%s = new %s[%s];", target, java_elem, len);
+            emit(codec, indent + 8, "}");
+            read_primitive_array(codec, seq, target, len, indent + 8, depth);
+            emit(codec, indent + 4, "} else {");
+            emit(codec, indent + 8, "%s = null;", target);
+            emit(codec, indent + 4, "}");
+        } else {
+            emit(codec, indent + 4, "if (%s == null || %s.length != %s) {", target, target, len);
+            emit(codec, indent + 8, "%s = new %s[%s];", target, java_elem, len);
+            emit(codec, indent + 4, "}");
+            emit(codec, indent + 4, "if (%s > 0) {", len);
+            codec->known_align = 4;
+            codec_read_align(codec, indent + 8, elem_align);
+            read_primitive_array(codec, seq, target, len, indent + 8, depth);
+            emit(codec, indent + 4, "}");
+        }
+    } else {
+        bool reuse = is_reusable_element(codec, element_type(seq));
+        emit(codec, indent + 4, "%s = CdrReader.reuseList(%s, %s, %s);", target, target, len, reuse ? "true" : "false");
+        if (reuse) {
+            emit(codec, indent + 4, "int %s = %s.size();", kept, target);
+        }
+        int loop_indent = indent + 4;
+        if (elem_size > 0 && elem_align > 4) {
+            emit(codec, indent + 4, "if (%s > 0) {", len);
+            codec->known_align = 4;
+            codec_read_align(codec, indent + 8, elem_align);
+            loop_indent = indent + 8;
+        }
+        emit(codec, loop_indent, "for (int %s = 0; %s < %s; %s++) {", index, index, len, index);
+        codec->known_align = elem_size > 0 ? elem_align : 1;
+        read_element(codec, element_type(seq), target, index, kept, loop_indent + 4, depth);
+        emit(codec, loop_indent, "}");
+        if (loop_indent != indent + 4) {
+            emit(codec, indent + 4, "}");
+        }
+    }
+    emit(codec, indent, "}");
+    codec->known_align = align_after_sequence(codec, elem_size);
+}
+
+void codec_emit_read(java_codec_t *codec, const idl_type_spec_t *type_spec, const char *target, int indent, int depth) {
+    type_spec = java_resolve_alias(type_spec);
+    idl_type_t type = idl_type(type_spec);
+
+    switch (type) {
+        case IDL_STRING:
+            read_string(codec, target, indent);
+            return;
+        case IDL_WSTRING: {
+            if (is_packed(codec)) {
+                if (depth > 0) read_string(codec, target, indent);
+                return;
+            }
+            char len[32], chars[32];
+            local_name(len, sizeof(len), "len", depth);
+            local_name(chars, sizeof(chars), "chars", depth);
+            codec_read_align(codec, indent, 4);
+            emit(codec, indent, "{");
+            emit(codec, indent + 4, "int %s = buffer.getInt();", len);
+            emit(codec, indent + 4, "char[] %s = new char[%s / 2];", chars, len);
+            emit(codec, indent + 4, "buffer.asCharBuffer().get(%s);", chars);
+            emit(codec, indent + 4, "buffer.position(buffer.position() + %s);", len);
+            emit(codec, indent + 4, "%s = new String(%s);", target, chars);
+            emit(codec, indent, "}");
+            codec->known_align = 2;
+            return;
+        }
+        case IDL_SEQUENCE:
+            read_sequence(codec, (const idl_sequence_t *)type_spec, target, indent, depth);
+            return;
+        case IDL_STRUCT:
+        case IDL_UNION: {
+            const char *type_name = java_type_name(type_spec, false);
+            emit(codec, indent, "if (%s == null) {", target);
+            emit(codec, indent + 4, "%s = new %s();", target, type_name);
+            emit(codec, indent, "}");
+            emit(codec, indent, "%s.deserializeFrom(buffer);", target);
+            codec->known_align = 1;
+            return;
+        }
+        case IDL_TYPEDEF: {
+            if (is_packed(codec)) return;
+            const char *type_name = java_type_name(type_spec, false);
+            size_t value_len = strlen(target) + 8;
+            char *value = malloc(value_len);
+            snprintf(value, value_len, "%s.value", target);
+            emit(codec, indent, "if (%s == null) {", target);
+            emit(codec, indent + 4, "%s = new %s();", target, type_name);
+            emit(codec, indent, "}");
+            codec_emit_read(codec, codec_typedef_alias(type_spec), value, indent, depth);
+            free(value);
+            return;
+        }
+        default:
+            break;
+    }
+
+    char *expr = read_expr(codec, type_spec);
+    if (!expr) return;
+    uint32_t size = constant_size(codec, type_spec);
+    codec_read_align(codec, indent, natural_align(codec, size));
+    emit(codec, indent, "%s = %s;", target, expr);
+    advance(codec, size);
+    free(expr);
+}
+
+/* ---- method size --------------------------------------------------------- */
+
+/*
+ * Rough bytecode size of emitted statements, erring on the high side: a
+ * statement loads its operands and stores or pops the result, every call or
+ * cast and every condition costs a 3-byte instruction, and a closing brace
+ * may be the target of a goto.
+ */
+uint32_t codec_bytecode_size(const char *code) {
+    uint32_t size = 0;
+    while (*code) {
+        const char *end = strchr(code, '\n');
+        if (!end) end = code + strlen(code);
+        while (code < end && *code == ' ') code++;
+        if (code < end && strncmp(code, "//", 2) != 0) {
+            size += (*code == '}' || *code == '{') ? 3 : 6;
+            for (const char *c = code; c < end; c++) {
+                if (*c == '(' || *c == '?' || *c == '<' || *c == '>' ||
+                    (c[1] == '=' && (*c == '=' || *c == '!'))) {
+                    size += 3;
+                }
+            }
+        }
+        code = *end ? end + 1 : end;
+    }
+    return size;
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * Dependency graph of a run, written as JSON for java-deps: the include
+ * edges between the IDL files, and for every generated type its source file
+ * and line, the named types it references (members, base, discriminator and
+ * aliased types, through sequences) and the files it generated. Types are
+ * named <package>.<identifier> like the generated classes, file paths are
+ * relative to outputDir. Build tooling can take the reverse closure of a
+ * changed type or IDL file to find the classes to recompile.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "idl/tree.h"
+#include "idlc_java.h"
+
+typedef struct string_builder string_builder_t;
+
+extern string_builder_t *sb_create(void);
+extern void sb_destroy(string_builder_t *sb);
+extern int sb_append(string_builder_t *sb, const char *str);
+extern int sb_appendf(string_builder_t *sb, const char *format, ...);
+extern const char *sb_string(const string_builder_t *sb);
+extern size_t sb_length(const string_builder_t *sb);
+
+extern const char *resolve_package(const idl_node_t *node, const char *prefix);
+extern const char *java_internf(const char *format, ...);
+extern const idl_type_spec_t *java_resolve_forward(const idl_type_spec_t *type_spec);
+extern int java_output_owned_files(const void *owner, void (*fn)(const char *path, void *arg), void *arg);
+
+/* Referenced type names of one definition, without duplicates */
+typedef struct deps_refs {
+    const char **names;     /* interned */
+    size_t count;
+    size_t capacity;
+    const char *prefix;
+    bool failed;
+} deps_refs_t;
+
+typedef struct deps_files {
+    string_builder_t *sb;
+    size_t count;
+} deps_files_t;
+
+static void append_json_string(string_builder_t *sb, const char *str) {
+    sb_append(sb, "\"");
+    for (const char *p = str; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\') {
+            sb_appendf(sb, "\\%c", c);
+        } else if (c < 0x20) {
+            sb_appendf(sb, "\\u%04x", c);
+        } else {
+            sb_appendf(sb, "%c", c);
+        }
+    }
+    sb_append(sb, "\"");
+}
+
+static const char *qualified_name(const idl_node_t *scope, const char *identifier, const char *prefix) {
+    const char *package = resolve_package(scope, prefix);
+    return package ? java_internf("%s.%s", package, identifier) : NULL;
+}
+
+/* Typedefs generate their first declarator, the other definitions their name */
+static const char *definition_name(const idl_node_t *node) {
+    const idl_name_t *name;
+    if (idl_mask(node) & IDL_TYPEDEF) {
+        const idl_declarator_t *declarator = ((const idl_typedef_t *)node)->declarators;
+        name = declarator ? declarator->name : NULL;
+    } else {
+        name = idl_name(node);
+    }
+    return name && name->identifier ? name->identifier : NULL;
+}
+
+static const char *definition_kind(const idl_node_t *node) {
+    idl_mask_t mask = idl_mask(node);
+    if (mask & IDL_STRUCT) return "struct";
+    if (mask & IDL_UNION) return "union";
+    if (mask & IDL_ENUM) return "enum";
+    if (mask & IDL_BITMASK) return "bitmask";
+    return "typedef";
+}
+
+static const char *node_source(const idl_node_t *node) {
+    const idl_position_t *first = &node->symbol.location.first;
+    if (first->source && first->source->path && first->source->path->name) return first->source->path->name;
+    if (first->file && first->file->name) return first->file->name;
+    return NULL;
+}
+
+static void add_name(deps_refs_t *refs, const idl_node_t *scope, const char *identifier) {
+    const char *name = qualified_name(scope, identifier, refs->prefix);
+    if (!name) {
+        refs->failed = true;
+        return;
+    }
+    for (size_t i = 0; i < refs->count; i++) {
+        if (refs->names[i] == name) return;
+    }
+    if (refs->count == refs->capacity) {
+        size_t capacity = refs->capacity ? 2 * refs->capacity : 8;
+        const char **names = realloc(refs->names, capacity * sizeof(*names));
+        if (!names) {
+            refs->failed = true;
+            return;
+        }
+        refs->names = names;
+        refs->capacity = capacity;
+    }
+    refs->names[refs->count++] = name;
+}
+
+/* Named types type_spec refers to; aliases count as the typedef, not what it aliases */
+static void add_reference(deps_refs_t *refs, const idl_type_spec_t *type_spec) {
+    type_spec = java_resolve_forward(type_spec);
+    if (!type_spec) return;
+    const idl_node_t *node = (const idl_node_t *)type_spec;
+    idl_mask_t mask = idl_mask(node);
+    if (mask & IDL_SEQUENCE) {
+        add_reference(refs, ((const idl_sequence_t *)type_spec)->type_spec);
+    } else if (idl_type(type_spec) == IDL_TYPEDEF ||
+               (mask & (IDL_STRUCT | IDL_UNION | IDL_ENUM | IDL_BITMASK))) {
+        const idl_name_t *name = idl_name(type_spec);
+        if (name && name->identifier) add_name(refs, node, name->identifier);
+    }
+}
+
+static void collect_references(deps_refs_t *refs, const idl_node_t *node) {
+    idl_mask_t mask = idl_mask(node);
+    if (mask & IDL_STRUCT) {
+        const idl_struct_t *struct_def = (const idl_struct_t *)node;
+        if (struct_def->inherit_spec) add_reference(refs, struct_def->inherit_spec->base);
+        const idl_member_t *member = struct_def->members;
+        while (member) {
+            add_reference(refs, member->type_spec);
+            member = (const idl_member_t *)member->node.next;
+        }
+    } else if (mask & IDL_UNION) {
+        const idl_union_t *union_def = (const idl_union_t *)node;
+        if (union_def->switch_type_spec) add_reference(refs, union_def->switch_type_spec->type_spec);
+        const idl_case_t *case_def = union_def->cases;
+        while (case_def) {
+            add_reference(refs, case_def->type_spec);
+            case_def = (const idl_case_t *)case_def->node.next;
+        }
+    } else if (mask & IDL_TYPEDEF) {
+        add_reference(refs, ((const idl_typedef_t *)node)->type_spec);
+    }
+}
+
+static void append_file(const char *path, void *arg) {
+    deps_files_t *files = arg;
+    sb_append(files->sb, files->count++ ? ", " : "");
+    append_json_string(files->sb, path);
+}
+
+static int append_type(string_builder_t *sb, const idl_node_t *node, const char *prefix, bool *first) {
+    const char *identifier = definition_name(node);
+    if (!identifier) return 0;
+    const char *name = qualified_name(node, identifier, prefix);
+    deps_refs_t refs = { .names = NULL, .count = 0, .capacity = 0, .prefix = prefix, .failed = false };
+    collect_references(&refs, node);
+
+    int result = name && !refs.failed ? 0 : -1;
+    if (result == 0) {
+        const char *source = node_source(node);
+        sb_append(sb, *first ? "\n" : ",\n");
+        *first = false;
+        sb_append(sb, "    {\n      \"name\": ");
+        append_json_string(sb, name);
+        sb_appendf(sb, ",\n      \"kind\": \"%s\",\n      \"source\": ", definition_kind(node));
+        if (source) {
+            append_json_string(sb, source);
+        } else {
+            sb_append(sb, "null");
+        }
+        sb_appendf(sb, ",\n      \"line\": %u,\n      \"references\": [", (unsigned)node->symbol.location.first.line);
+        for (size_t i = 0; i < refs.count; i++) {
+            sb_append(sb, i ? ", " : "");
+            append_json_string(sb, refs.names[i]);
+        }
+        sb_append(sb, "],\n      \"files\": [");
+        deps_files_t files = { .sb = sb, .count = 0 };
+        result = java_output_owned_files(node, append_file, &files);
+        sb_append(sb, "]\n    }");
+    }
+
+    free(refs.names);
+    return result;
+}
+
+/* The definitions generate_node() is given, in the same order */
+static int append_types(string_builder_t *sb, const idl_node_t *node, const char *prefix, bool *first) {
+    for (; node; node = node->next) {
+        idl_mask_t mask = idl_mask(node);
+        if (mask & IDL_FORWARD) continue;
+        if (mask & (IDL_STRUCT | IDL_ENUM | IDL_UNION | IDL_BITMASK | IDL_TYPEDEF)) {
+            if (append_type(sb, node, prefix, first) != 0) return -1;
+        } else if (mask & IDL_MODULE) {
+            const idl_module_t *module = (const idl_module_t *)node;
+            if (append_types(sb, (const idl_node_t *)module->definitions, prefix, first) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+static void append_includes(string_builder_t *sb, const idl_source_t *source, bool *first) {
+    for (; source; source = source->next) {
+        for (const idl_source_t *include = source->includes; include; include = include->next) {
+            if (!source->path || !include->path) continue;
+            sb_append(sb, *first ? "\n" : ",\n");
+            *first = false;
+            sb_append(sb, "    { \"from\": ");
+            append_json_string(sb, source->path->name);
+            sb_append(sb, ", \"to\": ");
+            append_json_string(sb, include->path->name);
+            sb_append(sb, " }");
+        }
+        append_includes(sb, source->includes, first);
+    }
+}
+
+/*
+ * Whether path already holds exactly content. The graph may live outside the
+ * output directory, so it is compared on disk rather than via the manifest.
+ */
+static bool file_holds(const char *path, const char *content, size_t size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    char buf[4096];
+    size_t offset = 0, n;
+    bool same = true;
+    while (same && (n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        same = offset + n <= size && memcmp(buf, content + offset, n) == 0;
+        offset += n;
+    }
+    fclose(f);
+    return same && offset == size;
+}
+
+/*
+ * Writes the graph of this run to deps_path. Must be called after the types
+ * are generated and before java_output_end(), which drops the file owners.
+ */
+int java_deps_write(const idl_pstate_t *pstate, const java_generator_config_t *config, const char *deps_path) {
+    if (!pstate || !config || !deps_path) return -1;
+
+    string_builder_t *sb = sb_create();
+    if (!sb) return -1;
+
+    bool first = true;
+    sb_append(sb, "{\n  \"version\": 1,\n  \"outputDir\": ");
+    append_json_string(sb, config->output_dir);
+    sb_append(sb, ",\n  \"includes\": [");
+    append_includes(sb, pstate->sources, &first);
+    sb_append(sb, first ? "],\n" : "\n  ],\n");
+
+    first = true;
+    sb_append(sb, "  \"types\": [");
+    int result = append_types(sb, pstate->root, config->package_prefix, &first);
+    sb_append(sb, first ? "]\n}\n" : "\n  ]\n}\n");
+
+    if (result == 0 && file_holds(deps_path, sb_string(sb), sb_length(sb))) {
+        /* unchanged: keep the mtime that build tooling compares against */
+    } else if (result == 0) {
+        FILE *f = fopen(deps_path, "w");
+        if (f) {
+            fwrite(sb_string(sb), 1, sb_length(sb), f);
+            fclose(f);
+            printf("  Created: %s\n", deps_path);
+        } else {
+            fprintf(stderr, "  Error: Could not create file: %s\n", deps_path);
+            result = -1;
+        }
+    }
+    sb_destroy(sb);
+    return result;
+}
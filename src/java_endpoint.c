@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * Typed endpoints of a topic struct: <Type>Writer and <Type>Reader exchange
+ * <Type>Native samples with libddsc through dds_write() and loaned
+ * dds_take(), the topic being created from <Type>Native.Descriptor. The
+ * calls go through Ddsc, a per-package class bound with JNA direct mapping
+ * (Native.register), which avoids the reflection and argument boxing of
+ * interface-mapped libraries on every write and take.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "idlc_java.h"
+
+typedef struct string_builder string_builder_t;
+
+extern string_builder_t *sb_create(void);
+extern void sb_destroy(string_builder_t *sb);
+extern int sb_append(string_builder_t *sb, const char *str);
+extern int sb_appendf(string_builder_t *sb, const char *format, ...);
+
+extern const char *resolve_package(const idl_node_t *node, const char *prefix);
+extern char *java_package_path(const java_generator_config_t *config, const char *package);
+extern int java_write_class(const char *package_path, const char *class_name, const string_builder_t *sb);
+
+/* Ddsc: the direct-mapped libddsc functions, shared by every endpoint in the package */
+static int write_ddsc_class(const char *package_path, const char *package) {
+    string_builder_t *sb = sb_create();
+    if (!sb) return -1;
+    sb_appendf(sb, "package %s;\n\n", package);
+    sb_append(sb, "import com.sun.jna.Native;\n");
+    sb_append(sb, "import com.sun.jna.Pointer;\n\n");
+    sb_append(sb, "/** libddsc functions used by the generated readers and writers, bound by JNA direct mapping. */\n");
+    sb_append(sb, "public final class Ddsc {\n");
+    sb_append(sb, "    public static final int DDS_DOMAIN_DEFAULT = -1;\n\n");
+    sb_append(sb, "    static {\n");
+    sb_append(sb, "        Native.register(\"ddsc\");\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    private Ddsc() { }\n\n");
+    sb_append(sb, "    public static native int dds_create_participant(int domain, Pointer qos, Pointer listener);\n");
+    sb_append(sb, "    public static native int dds_create_topic(int participant, DdsTopicDescriptor descriptor, String name, Pointer qos, Pointer listener);\n");
+    sb_append(sb, "    public static native int dds_create_writer(int participant, int topic, Pointer qos, Pointer listener);\n");
+    sb_append(sb, "    public static native int dds_create_reader(int participant, int topic, Pointer qos, Pointer listener);\n");
+    sb_append(sb, "    public static native int dds_write(int writer, Pointer data);\n");
+    sb_append(sb, "    public static native int dds_take(int reader, Pointer buf, Pointer si, long bufsz, int maxs);\n");
+    sb_append(sb, "    public static native int dds_return_loan(int reader, Pointer buf, int bufsz);\n");
+    sb_append(sb, "    public static native int dds_delete(int entity);\n");
+    sb_append(sb, "    public static native String dds_strretcode(int ret);\n\n");
+    sb_append(sb, "    /** ret, or an exception if it is a negative dds_return_t */\n");
+    sb_append(sb, "    public static int check(int ret) {\n");
+    sb_append(sb, "        if (ret < 0) {\n");
+    sb_append(sb, "            throw new IllegalStateException(dds_strretcode(ret));\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        return ret;\n");
+    sb_append(sb, "    }\n");
+    sb_append(sb, "}\n");
+    int result = java_write_class(package_path, "Ddsc", sb);
+    sb_destroy(sb);
+    return result;
+}
+
+/* DdsSampleInfo: dds_sample_info_t */
+static int write_sample_info_class(const char *package_path, const char *package) {
+    string_builder_t *sb = sb_create();
+    if (!sb) return -1;
+    sb_appendf(sb, "package %s;\n\n", package);
+    sb_append(sb, "import com.sun.jna.Pointer;\n");
+    sb_append(sb, "import com.sun.jna.Structure;\n\n");
+    sb_append(sb, "/** dds_sample_info_t of a taken sample. */\n");
+    sb_append(sb, "@Structure.FieldOrder({\"sample_state\", \"view_state\", \"instance_state\", \"valid_data\", \"source_timestamp\",\n");
+    sb_append(sb, "        \"instance_handle\", \"publication_handle\", \"disposed_generation_count\", \"no_writers_generation_count\",\n");
+    sb_append(sb, "        \"sample_rank\", \"generation_rank\", \"absolute_generation_rank\"})\n");
+    sb_append(sb, "public class DdsSampleInfo extends Structure {\n");
+    sb_append(sb, "    public int sample_state;\n");
+    sb_append(sb, "    public int view_state;\n");
+    sb_append(sb, "    public int instance_state;\n");
+    sb_append(sb, "    public byte valid_data;\n");
+    sb_append(sb, "    public long source_timestamp;\n");
+    sb_append(sb, "    public long instance_handle;\n");
+    sb_append(sb, "    public long publication_handle;\n");
+    sb_append(sb, "    public int disposed_generation_count;\n");
+    sb_append(sb, "    public int no_writers_generation_count;\n");
+    sb_append(sb, "    public int sample_rank;\n");
+    sb_append(sb, "    public int generation_rank;\n");
+    sb_append(sb, "    public int absolute_generation_rank;\n\n");
+    sb_append(sb, "    public DdsSampleInfo() {\n");
+    sb_append(sb, "        super();\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    public DdsSampleInfo(Pointer p) {\n");
+    sb_append(sb, "        super(p);\n");
+    sb_append(sb, "        read();\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** False for samples that only carry an instance state change */\n");
+    sb_append(sb, "    public boolean validData() {\n");
+    sb_append(sb, "        return valid_data != 0;\n");
+    sb_append(sb, "    }\n");
+    sb_append(sb, "}\n");
+    int result = java_write_class(package_path, "DdsSampleInfo", sb);
+    sb_destroy(sb);
+    return result;
+}
+
+static void append_descriptor(string_builder_t *sb, const char *struct_name) {
+    sb_appendf(sb, "    private static final DdsTopicDescriptor DESCRIPTOR = %sNative.Descriptor.create();\n", struct_name);
+}
+
+/* The topic and the reader or writer created on it */
+static void append_topic_fields(string_builder_t *sb, const char *entity) {
+    sb_append(sb, "    private final int topic;\n");
+    sb_appendf(sb, "    private final int %s;\n", entity);
+}
+
+/* Creates the topic, then the entity with create_fn, deleting the topic if that fails */
+static void append_create(string_builder_t *sb, const char *entity, const char *create_fn) {
+    sb_append(sb, "        topic = Ddsc.check(Ddsc.dds_create_topic(participant, DESCRIPTOR, topicName, null, null));\n");
+    sb_appendf(sb, "        int handle = Ddsc.%s(participant, topic, null, null);\n", create_fn);
+    sb_append(sb, "        if (handle < 0) {\n");
+    sb_append(sb, "            Ddsc.dds_delete(topic);\n");
+    sb_append(sb, "            Ddsc.check(handle);\n");
+    sb_append(sb, "        }\n");
+    sb_appendf(sb, "        %s = handle;\n", entity);
+}
+
+static void append_close(string_builder_t *sb, const char *entity, const char *before) {
+    sb_append(sb, "    @Override\n");
+    sb_append(sb, "    public void close() {\n");
+    if (before) sb_append(sb, before);
+    sb_appendf(sb, "        Ddsc.dds_delete(%s);\n", entity);
+    sb_append(sb, "        Ddsc.dds_delete(topic);\n");
+    sb_append(sb, "    }\n");
+}
+
+static void generate_writer(string_builder_t *sb, const char *package, const char *struct_name) {
+    sb_appendf(sb, "package %s;\n\n", package);
+    sb_appendf(sb, "/** Writes %sNative samples with dds_write(). */\n", struct_name);
+    sb_appendf(sb, "public final class %sWriter implements AutoCloseable {\n", struct_name);
+    append_descriptor(sb, struct_name);
+    sb_append(sb, "\n");
+    sb_append(sb, "    /** Per-thread sample for sample(), so that writing needs no allocation */\n");
+    sb_appendf(sb, "    private static final ThreadLocal<%sNative> SAMPLE = ThreadLocal.withInitial(%sNative::new);\n\n",
+               struct_name, struct_name);
+    append_topic_fields(sb, "writer");
+    sb_append(sb, "\n");
+    sb_appendf(sb, "    public %sWriter(int participant, String topicName) {\n", struct_name);
+    append_create(sb, "writer", "dds_create_writer");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** This thread's reusable sample: fill it in and pass it to write() */\n");
+    sb_appendf(sb, "    public %sNative sample() {\n", struct_name);
+    sb_append(sb, "        return SAMPLE.get();\n");
+    sb_append(sb, "    }\n\n");
+    sb_appendf(sb, "    public void write(%sNative sample) {\n", struct_name);
+    sb_append(sb, "        sample.write();\n");
+    sb_append(sb, "        Ddsc.check(Ddsc.dds_write(writer, sample.getPointer()));\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    public int handle() {\n");
+    sb_append(sb, "        return writer;\n");
+    sb_append(sb, "    }\n\n");
+    append_close(sb, "writer", NULL);
+    sb_append(sb, "}\n");
+}
+
+static void generate_reader(string_builder_t *sb, const char *package, const char *struct_name) {
+    sb_appendf(sb, "package %s;\n\n", package);
+    sb_append(sb, "import com.sun.jna.Memory;\n");
+    sb_append(sb, "import com.sun.jna.Native;\n");
+    sb_append(sb, "import com.sun.jna.Pointer;\n\n");
+    sb_appendf(sb, "/** Takes %sNative samples with dds_take(), in batches loaned from the reader. */\n", struct_name);
+    sb_appendf(sb, "public final class %sReader implements AutoCloseable {\n", struct_name);
+    append_descriptor(sb, struct_name);
+    sb_append(sb, "\n");
+    append_topic_fields(sb, "reader");
+    sb_append(sb, "    private final int capacity;\n");
+    sb_append(sb, "    private final Memory loans;             // void *buf[capacity]\n");
+    sb_append(sb, "    private final DdsSampleInfo[] infos;    // contiguous dds_sample_info_t[capacity]\n");
+    sb_append(sb, "    private int loaned;\n\n");
+    sb_appendf(sb, "    public %sReader(int participant, String topicName, int capacity) {\n", struct_name);
+    append_create(sb, "reader", "dds_create_reader");
+    sb_append(sb, "        this.capacity = capacity;\n");
+    sb_append(sb, "        loans = new Memory((long) capacity * Native.POINTER_SIZE);\n");
+    sb_append(sb, "        infos = (DdsSampleInfo[]) new DdsSampleInfo().toArray(capacity);\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /**\n");
+    sb_append(sb, "     * Takes up to min(samples.length, capacity) samples. samples[i] is rebound\n");
+    sb_append(sb, "     * to the i-th loaned sample (allocated if null) and stays valid until the\n");
+    sb_append(sb, "     * next take() or returnLoan(); info(i) describes it.\n");
+    sb_append(sb, "     */\n");
+    sb_appendf(sb, "    public int take(%sNative[] samples) {\n", struct_name);
+    sb_append(sb, "        returnLoan();\n");
+    sb_append(sb, "        int max = Math.min(samples.length, capacity);\n");
+    sb_append(sb, "        loans.setPointer(0, null);  // null buf[0]: loan the samples\n");
+    sb_append(sb, "        int count = Ddsc.check(Ddsc.dds_take(reader, loans, infos[0].getPointer(), max, max));\n");
+    sb_append(sb, "        loaned = count;\n");
+    sb_append(sb, "        for (int i = 0; i < count; i++) {\n");
+    sb_append(sb, "            infos[i].read();\n");
+    sb_append(sb, "            Pointer p = loans.getPointer((long) i * Native.POINTER_SIZE);\n");
+    sb_append(sb, "            if (samples[i] == null) {\n");
+    sb_appendf(sb, "                samples[i] = new %sNative(p);\n", struct_name);
+    sb_append(sb, "            } else {\n");
+    sb_append(sb, "                samples[i].view(p);\n");
+    sb_append(sb, "            }\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        return count;\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    public DdsSampleInfo info(int index) {\n");
+    sb_append(sb, "        return infos[index];\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** Returns the samples of the last take() to the reader */\n");
+    sb_append(sb, "    public void returnLoan() {\n");
+    sb_append(sb, "        if (loaned > 0) {\n");
+    sb_append(sb, "            Ddsc.check(Ddsc.dds_return_loan(reader, loans, loaned));\n");
+    sb_append(sb, "            loaned = 0;\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    public int handle() {\n");
+    sb_append(sb, "        return reader;\n");
+    sb_append(sb, "    }\n\n");
+    append_close(sb, "reader", "        returnLoan();\n");
+    sb_append(sb, "}\n");
+}
+
+int generate_java_endpoints(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *struct_name) {
+    if (!struct_def || !config || !config->output_dir || !struct_name) return -1;
+
+    const char *package = resolve_package((const idl_node_t *)struct_def, config->package_prefix);
+    char *package_path = java_package_path(config, package);
+    string_builder_t *writer = sb_create();
+    string_builder_t *reader = sb_create();
+    int result = -1;
+    if (package_path && writer && reader) {
+        char class_name[256];
+        generate_writer(writer, package, struct_name);
+        generate_reader(reader, package, struct_name);
+        snprintf(class_name, sizeof(class_name), "%sWriter", struct_name);
+        result = java_write_class(package_path, class_name, writer);
+        if (result == 0) {
+            snprintf(class_name, sizeof(class_name), "%sReader", struct_name);
+            result = java_write_class(package_path, class_name, reader);
+        }
+        if (result == 0) result = write_ddsc_class(package_path, package);
+        if (result == 0) result = write_sample_info_class(package_path, package);
+    }
+
+    sb_destroy(writer);
+    sb_destroy(reader);
+    free(package_path);
+    return result;
+}
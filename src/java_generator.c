@@ -26,8 +26,9 @@ extern int sb_append(string_builder_t *sb, const char *str);
 extern int sb_appendf(string_builder_t *sb, const char *format, ...);
 extern const char *sb_string(const string_builder_t *sb);
 
-extern char *resolve_package(const idl_node_t *node, const char *prefix);
-extern char *java_type_name(const idl_type_spec_t *type_spec, bool boxed);
+extern const char *resolve_package(const idl_node_t *node, const char *prefix);
+extern const char *java_type_name(const idl_type_spec_t *type_spec, bool boxed);
+extern const char *java_internf(const char *format, ...);
 extern const char *java_default_value(idl_type_t type);
 
 int generate_types_for_module(const idl_module_t *module, const char *output_dir, const char *prefix) {
@@ -64,32 +65,26 @@ int validate_idl(const idl_pstate_t *pstate) {
     return warnings;
 }
 
-char *get_type_description(const idl_type_spec_t *type_spec) {
-    if (!type_spec) return strdup("unknown");
+const char *get_type_description(const idl_type_spec_t *type_spec) {
+    if (!type_spec) return "unknown";
     
     idl_mask_t mask = idl_mask(type_spec);
     
     if (mask & IDL_BASE_TYPE) {
-        return strdup("primitive");
+        return "primitive";
     } else if (mask & IDL_STRING) {
-        return strdup("string");
+        return "string";
     } else if (mask & IDL_SEQUENCE) {
-        return strdup("sequence");
+        return "sequence";
     } else if (mask & IDL_STRUCT) {
         const idl_struct_t *s = (const idl_struct_t *)type_spec;
-        const char *name = s->name ? idl_identifier(s->name) : "anonymous";
-        char *desc = malloc(strlen(name) + 20);
-        sprintf(desc, "struct %s", name);
-        return desc;
+        return java_internf("struct %s", s->name ? idl_identifier(s->name) : "anonymous");
     } else if (mask & IDL_ENUM) {
         const idl_enum_t *e = (const idl_enum_t *)type_spec;
-        const char *name = e->name ? idl_identifier(e->name) : "anonymous";
-        char *desc = malloc(strlen(name) + 20);
-        sprintf(desc, "enum %s", name);
-        return desc;
+        return java_internf("enum %s", e->name ? idl_identifier(e->name) : "anonymous");
     }
     
-    return strdup("complex");
+    return "complex";
 }
 
 void print_statistics(const idl_pstate_t *pstate) {
@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * Per-topic last-value cache: <Type>InstanceCache maps the key of a sample to
+ * the latest sample, using open addressing with linear probing over plain
+ * arrays. If every key member is a primitive the keys are kept in primitive
+ * columns and looked up without touching the samples; otherwise the slot
+ * stores the key hash and compares with keyEquals().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <sys/stat.h>
+#include "idlc_java.h"
+
+typedef struct string_builder string_builder_t;
+
+extern string_builder_t *sb_create(void);
+extern void sb_destroy(string_builder_t *sb);
+extern int sb_append(string_builder_t *sb, const char *str);
+extern int sb_appendf(string_builder_t *sb, const char *format, ...);
+extern const char *sb_string(const string_builder_t *sb);
+
+extern const char *resolve_package(const idl_node_t *node, const char *prefix);
+extern const char *java_type_name(const idl_type_spec_t *type_spec, bool boxed);
+extern char *java_key_hash_expr(const idl_type_spec_t *type_spec, const char *expr, bool use_arrays);
+extern char *java_key_equals_expr(const idl_type_spec_t *type_spec, const char *a, const char *b, bool use_arrays);
+extern uint32_t cdr_primitive_size(idl_type_t type);
+extern java_struct_ir_t *java_struct_ir_build(const idl_struct_t *struct_def, java_cdr_format_t format, bool use_arrays);
+extern int java_write_file(const char *file_path, const string_builder_t *sb);
+
+typedef struct key_columns {
+    const java_member_ir_t **members;
+    size_t count;
+    bool primitive;     /* all key members are primitives */
+} key_columns_t;
+
+/* "int x, int y" */
+static void append_key_params(string_builder_t *sb, const key_columns_t *keys) {
+    for (size_t i = 0; i < keys->count; i++) {
+        const char *type_name = java_type_name(keys->members[i]->type_spec, false);
+        sb_appendf(sb, "%s%s %s", i > 0 ? ", " : "", type_name, keys->members[i]->name);
+    }
+}
+
+/* "prefix.x, prefix.y", or the bare names if prefix is NULL */
+static void append_key_args(string_builder_t *sb, const key_columns_t *keys, const char *prefix, const char *suffix) {
+    for (size_t i = 0; i < keys->count; i++) {
+        const char *name = keys->members[i]->name;
+        sb_appendf(sb, "%s%s%s%s%s", i > 0 ? ", " : "", prefix ? prefix : "", prefix ? "." : "", name, suffix ? suffix : "");
+    }
+}
+
+static void generate_fields(string_builder_t *sb, const key_columns_t *keys, const char *class_name) {
+    if (keys->primitive) {
+        for (size_t i = 0; i < keys->count; i++) {
+            const char *type_name = java_type_name(keys->members[i]->type_spec, false);
+            sb_appendf(sb, "    private %s[] %sKeys;\n", type_name, keys->members[i]->name);
+        }
+    } else {
+        sb_append(sb, "    private int[] hashes;\n");
+    }
+    sb_appendf(sb, "    private %s[] values;\n", class_name);
+    sb_append(sb, "    private int size;\n\n");
+}
+
+static void generate_constructors(string_builder_t *sb, const key_columns_t *keys, const char *class_name) {
+    sb_appendf(sb, "    public %sInstanceCache() {\n", class_name);
+    sb_append(sb, "        this(16);\n");
+    sb_append(sb, "    }\n\n");
+
+    sb_appendf(sb, "    public %sInstanceCache(int expectedSize) {\n", class_name);
+    sb_append(sb, "        int capacity = 4;\n");
+    sb_append(sb, "        while (capacity < expectedSize * 2) {\n");
+    sb_append(sb, "            capacity <<= 1;\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        allocate(capacity);\n");
+    sb_append(sb, "    }\n\n");
+
+    sb_append(sb, "    private void allocate(int capacity) {\n");
+    if (keys->primitive) {
+        for (size_t i = 0; i < keys->count; i++) {
+            const char *type_name = java_type_name(keys->members[i]->type_spec, false);
+            sb_appendf(sb, "        %sKeys = new %s[capacity];\n", keys->members[i]->name, type_name);
+        }
+    } else {
+        sb_append(sb, "        hashes = new int[capacity];\n");
+    }
+    sb_appendf(sb, "        values = new %s[capacity];\n", class_name);
+    sb_append(sb, "    }\n\n");
+}
+
+/*
+ * indexOf() returns the slot holding the key, or -(free slot) - 1. The
+ * primitive variant hashes the key columns exactly like keyHashCode().
+ */
+static void generate_lookup(string_builder_t *sb, const key_columns_t *keys, const char *class_name) {
+    if (keys->primitive) {
+        sb_append(sb, "    private static int hash(");
+        append_key_params(sb, keys);
+        sb_append(sb, ") {\n");
+        sb_append(sb, "        int h = 1;\n");
+        for (size_t i = 0; i < keys->count; i++) {
+            char *hash = java_key_hash_expr(keys->members[i]->type_spec, keys->members[i]->name, false);
+            sb_appendf(sb, "        h = 31 * h + %s;\n", hash);
+            free(hash);
+        }
+        sb_append(sb, "        return h ^ (h >>> 16);\n");
+        sb_append(sb, "    }\n\n");
+
+        sb_append(sb, "    private int slotHash(int slot) {\n");
+        sb_append(sb, "        return hash(");
+        append_key_args(sb, keys, NULL, "Keys[slot]");
+        sb_append(sb, ");\n");
+        sb_append(sb, "    }\n\n");
+
+        sb_append(sb, "    private int indexOf(");
+        append_key_params(sb, keys);
+        sb_append(sb, ") {\n");
+        sb_append(sb, "        int mask = values.length - 1;\n");
+        sb_append(sb, "        for (int i = hash(");
+        append_key_args(sb, keys, NULL, NULL);
+        sb_append(sb, ") & mask; ; i = (i + 1) & mask) {\n");
+        sb_append(sb, "            if (values[i] == null) {\n");
+        sb_append(sb, "                return -i - 1;\n");
+        sb_append(sb, "            }\n");
+        sb_append(sb, "            if (");
+        for (size_t i = 0; i < keys->count; i++) {
+            const char *name = keys->members[i]->name;
+            char column[256];
+            snprintf(column, sizeof(column), "%sKeys[i]", name);
+            char *equals = java_key_equals_expr(keys->members[i]->type_spec, column, name, false);
+            sb_appendf(sb, "%s%s", i > 0 ? " && " : "", equals);
+            free(equals);
+        }
+        sb_append(sb, ") {\n");
+        sb_append(sb, "                return i;\n");
+        sb_append(sb, "            }\n");
+        sb_append(sb, "        }\n");
+        sb_append(sb, "    }\n\n");
+    } else {
+        sb_append(sb, "    private static int hash(int h) {\n");
+        sb_append(sb, "        return h ^ (h >>> 16);\n");
+        sb_append(sb, "    }\n\n");
+
+        sb_append(sb, "    private int slotHash(int slot) {\n");
+        sb_append(sb, "        return hashes[slot];\n");
+        sb_append(sb, "    }\n\n");
+
+        sb_appendf(sb, "    private int indexOf(%s key, int h) {\n", class_name);
+        sb_append(sb, "        int mask = values.length - 1;\n");
+        sb_append(sb, "        for (int i = h & mask; ; i = (i + 1) & mask) {\n");
+        sb_append(sb, "            if (values[i] == null) {\n");
+        sb_append(sb, "                return -i - 1;\n");
+        sb_append(sb, "            }\n");
+        sb_append(sb, "            if (hashes[i] == h && values[i].keyEquals(key)) {\n");
+        sb_append(sb, "                return i;\n");
+        sb_append(sb, "            }\n");
+        sb_append(sb, "        }\n");
+        sb_append(sb, "    }\n\n");
+    }
+}
+
+/* Lookup of a sample's key, as the argument list of indexOf() */
+static void append_sample_lookup(string_builder_t *sb, const key_columns_t *keys, const char *sample) {
+    if (keys->primitive) {
+        append_key_args(sb, keys, sample, NULL);
+    } else {
+        sb_appendf(sb, "%s, hash(%s.keyHashCode())", sample, sample);
+    }
+}
+
+static void generate_accessors(string_builder_t *sb, const key_columns_t *keys, const char *class_name) {
+    sb_append(sb, "    public int size() {\n");
+    sb_append(sb, "        return size;\n");
+    sb_append(sb, "    }\n\n");
+
+    /* get */
+    sb_appendf(sb, "    public %s get(%s key) {\n", class_name, class_name);
+    sb_append(sb, "        int i = indexOf(");
+    append_sample_lookup(sb, keys, "key");
+    sb_append(sb, ");\n");
+    sb_append(sb, "        return i >= 0 ? values[i] : null;\n");
+    sb_append(sb, "    }\n\n");
+
+    if (keys->primitive) {
+        sb_appendf(sb, "    public %s get(", class_name);
+        append_key_params(sb, keys);
+        sb_append(sb, ") {\n");
+        sb_append(sb, "        int i = indexOf(");
+        append_key_args(sb, keys, NULL, NULL);
+        sb_append(sb, ");\n");
+        sb_append(sb, "        return i >= 0 ? values[i] : null;\n");
+        sb_append(sb, "    }\n\n");
+    }
+
+    /* put */
+    sb_append(sb, "    /** Stores sample as the latest value of its instance and returns the previous one. */\n");
+    sb_appendf(sb, "    public %s put(%s sample) {\n", class_name, class_name);
+    if (!keys->primitive) {
+        sb_append(sb, "        int h = hash(sample.keyHashCode());\n");
+        sb_append(sb, "        int i = indexOf(sample, h);\n");
+    } else {
+        sb_append(sb, "        int i = indexOf(");
+        append_sample_lookup(sb, keys, "sample");
+        sb_append(sb, ");\n");
+    }
+    sb_append(sb, "        if (i >= 0) {\n");
+    sb_appendf(sb, "            %s previous = values[i];\n", class_name);
+    sb_append(sb, "            values[i] = sample;\n");
+    sb_append(sb, "            return previous;\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        if ((size + 1) * 2 > values.length) {\n");
+    sb_append(sb, "            rehash(values.length * 2);\n");
+    if (!keys->primitive) {
+        sb_append(sb, "            i = indexOf(sample, h);\n");
+    } else {
+        sb_append(sb, "            i = indexOf(");
+        append_sample_lookup(sb, keys, "sample");
+        sb_append(sb, ");\n");
+    }
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        i = -i - 1;\n");
+    if (keys->primitive) {
+        for (size_t k = 0; k < keys->count; k++) {
+            const char *name = keys->members[k]->name;
+            sb_appendf(sb, "        %sKeys[i] = sample.%s;\n", name, name);
+        }
+    } else {
+        sb_append(sb, "        hashes[i] = h;\n");
+    }
+    sb_append(sb, "        values[i] = sample;\n");
+    sb_append(sb, "        size++;\n");
+    sb_append(sb, "        return null;\n");
+    sb_append(sb, "    }\n\n");
+
+    /* remove */
+    sb_appendf(sb, "    public %s remove(%s key) {\n", class_name, class_name);
+    sb_append(sb, "        return removeAt(indexOf(");
+    append_sample_lookup(sb, keys, "key");
+    sb_append(sb, "));\n");
+    sb_append(sb, "    }\n\n");
+
+    sb_append(sb, "    public void clear() {\n");
+    sb_append(sb, "        java.util.Arrays.fill(values, null);\n");
+    sb_append(sb, "        size = 0;\n");
+    sb_append(sb, "    }\n\n");
+
+    /* Backward-shift deletion keeps every probe chain unbroken without tombstones */
+    sb_appendf(sb, "    private %s removeAt(int i) {\n", class_name);
+    sb_append(sb, "        if (i < 0) {\n");
+    sb_append(sb, "            return null;\n");
+    sb_append(sb, "        }\n");
+    sb_appendf(sb, "        %s previous = values[i];\n", class_name);
+    sb_append(sb, "        int mask = values.length - 1;\n");
+    sb_append(sb, "        for (int j = (i + 1) & mask; values[j] != null; j = (j + 1) & mask) {\n");
+    sb_append(sb, "            int home = slotHash(j) & mask;\n");
+    sb_append(sb, "            if (((j - home) & mask) >= ((j - i) & mask)) {\n");
+    if (keys->primitive) {
+        for (size_t k = 0; k < keys->count; k++) {
+            const char *name = keys->members[k]->name;
+            sb_appendf(sb, "                %sKeys[i] = %sKeys[j];\n", name, name);
+        }
+    } else {
+        sb_append(sb, "                hashes[i] = hashes[j];\n");
+    }
+    sb_append(sb, "                values[i] = values[j];\n");
+    sb_append(sb, "                i = j;\n");
+    sb_append(sb, "            }\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        values[i] = null;\n");
+    sb_append(sb, "        size--;\n");
+    sb_append(sb, "        return previous;\n");
+    sb_append(sb, "    }\n\n");
+
+    /* rehash */
+    sb_append(sb, "    private void rehash(int capacity) {\n");
+    if (keys->primitive) {
+        for (size_t k = 0; k < keys->count; k++) {
+            const char *type_name = java_type_name(keys->members[k]->type_spec, false);
+            const char *name = keys->members[k]->name;
+            sb_appendf(sb, "        %s[] old%c%sKeys = %sKeys;\n", type_name, toupper((unsigned char)name[0]), name + 1, name);
+        }
+    } else {
+        sb_append(sb, "        int[] oldHashes = hashes;\n");
+    }
+    sb_appendf(sb, "        %s[] oldValues = values;\n", class_name);
+    sb_append(sb, "        allocate(capacity);\n");
+    sb_append(sb, "        int mask = capacity - 1;\n");
+    sb_append(sb, "        for (int j = 0; j < oldValues.length; j++) {\n");
+    sb_append(sb, "            if (oldValues[j] == null) {\n");
+    sb_append(sb, "                continue;\n");
+    sb_append(sb, "            }\n");
+    if (keys->primitive) {
+        sb_append(sb, "            int i = hash(");
+        for (size_t k = 0; k < keys->count; k++) {
+            const char *name = keys->members[k]->name;
+            sb_appendf(sb, "%sold%c%sKeys[j]", k > 0 ? ", " : "", toupper((unsigned char)name[0]), name + 1);
+        }
+        sb_append(sb, ") & mask;\n");
+    } else {
+        sb_append(sb, "            int i = oldHashes[j] & mask;\n");
+    }
+    sb_append(sb, "            while (values[i] != null) {\n");
+    sb_append(sb, "                i = (i + 1) & mask;\n");
+    sb_append(sb, "            }\n");
+    if (keys->primitive) {
+        for (size_t k = 0; k < keys->count; k++) {
+            const char *name = keys->members[k]->name;
+            sb_appendf(sb, "            %sKeys[i] = old%c%sKeys[j];\n", name, toupper((unsigned char)name[0]), name + 1);
+        }
+    } else {
+        sb_append(sb, "            hashes[i] = oldHashes[j];\n");
+    }
+    sb_append(sb, "            values[i] = oldValues[j];\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "    }\n");
+}
+
+int generate_java_instance_cache(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *class_name) {
+    if (!struct_def || !config || !config->output_dir || !class_name) return -1;
+
+    const char *output_dir = config->output_dir;
+    java_struct_ir_t *ir = java_struct_ir_build(struct_def, config->cdr_format, config->use_arrays_for_sequences);
+    if (!ir) return -1;
+    key_columns_t keys = { ir->keys, ir->key_count, true };
+    if (keys.count == 0) return 0;
+    for (size_t i = 0; i < keys.count; i++) {
+        if (cdr_primitive_size(keys.members[i]->kind) == 0) keys.primitive = false;
+    }
+
+    const char *package = resolve_package((const idl_node_t *)struct_def, config->package_prefix);
+    string_builder_t *sb = sb_create();
+    if (!sb) {
+        return -1;
+    }
+
+    sb_appendf(sb, "package %s;\n\n", package);
+    sb_appendf(sb, "/** Latest %s sample per instance, looked up by key. Keys of cached samples must not change. */\n", class_name);
+    sb_appendf(sb, "public final class %sInstanceCache {\n\n", class_name);
+    generate_fields(sb, &keys, class_name);
+    generate_constructors(sb, &keys, class_name);
+    generate_lookup(sb, &keys, class_name);
+    generate_accessors(sb, &keys, class_name);
+    sb_append(sb, "}\n");
+
+    char package_path[512];
+    if (strcmp(output_dir, ".") == 0) {
+        snprintf(package_path, sizeof(package_path), "%s", package);
+    } else {
+        snprintf(package_path, sizeof(package_path), "%s/%s", output_dir, package);
+    }
+    for (char *p = package_path; *p; p++) {
+        if (*p == '.') {
+            *p = '\0';
+            mkdir(package_path, 0755);
+            *p = '/';
+        }
+    }
+    mkdir(package_path, 0755);
+
+    char file_path[768];
+    snprintf(file_path, sizeof(file_path), "%s/%sInstanceCache.java", package_path, class_name);
+    if (java_write_file(file_path, sb) != 0) {
+        sb_destroy(sb);
+        return -1;
+    }
+
+    sb_destroy(sb);
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * Member table of a struct, resolved once per generated type. The field
+ * declarations, describeType(), the codecs, the key API, the instance cache
+ * and toString() all read their names, Java types, CDR layouts, ids and key
+ * membership from here instead of walking struct_def->members and resolving
+ * aliases and type names on every pass, so they cannot disagree on any of
+ * them. The table lives in the run's arena.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "idlc_java.h"
+
+extern const char *java_field_type_name(const idl_type_spec_t *type_spec, bool use_arrays);
+extern const idl_type_spec_t *java_resolve_alias(const idl_type_spec_t *type_spec);
+extern uint32_t cdr_align(uint32_t offset, uint32_t align);
+extern bool cdr_type_layout(const idl_type_spec_t *type_spec, java_cdr_format_t format, cdr_layout_t *layout);
+extern bool cdr_struct_layout(const idl_struct_t *struct_def, java_cdr_format_t format, cdr_layout_t *layout);
+extern void *java_arena_alloc(size_t size);
+
+static const char *member_name(const idl_member_t *member) {
+    if (member->declarators && member->declarators->name && member->declarators->name->identifier) {
+        return member->declarators->name->identifier;
+    }
+    return "field";
+}
+
+/* Typedef name a member keeps as a comment when its field has the aliased type */
+static const char *member_alias(const idl_member_t *member) {
+    if (idl_type(member->type_spec) != IDL_TYPEDEF || java_resolve_alias(member->type_spec) == member->type_spec) {
+        return NULL;
+    }
+    const idl_name_t *alias = idl_name(member->type_spec);
+    return alias && alias->identifier ? alias->identifier : "typedef";
+}
+
+static int compare_key_ids(const void *a, const void *b) {
+    const java_member_ir_t *ma = *(const java_member_ir_t *const *)a;
+    const java_member_ir_t *mb = *(const java_member_ir_t *const *)b;
+    return ma->id < mb->id ? -1 : ma->id > mb->id ? 1 : 0;
+}
+
+java_struct_ir_t *java_struct_ir_build(const idl_struct_t *struct_def, java_cdr_format_t format, bool use_arrays) {
+    if (!struct_def) return NULL;
+
+    size_t count = 0;
+    for (const idl_node_t *node = (const idl_node_t *)struct_def->members; node; node = node->next) {
+        count++;
+    }
+
+    size_t size = sizeof(java_struct_ir_t) + count * (sizeof(java_member_ir_t) + sizeof(java_member_ir_t *));
+    java_struct_ir_t *ir = java_arena_alloc(size);
+    if (!ir) return NULL;
+    memset(ir, 0, size);
+    ir->struct_def = struct_def;
+    ir->members = (java_member_ir_t *)(ir + 1);
+    ir->count = count;
+    ir->keys = (const java_member_ir_t **)(ir->members + count);
+    cdr_struct_layout(struct_def, format, &ir->layout);
+
+    uint32_t offset = 0;
+    java_member_ir_t *m = ir->members;
+    for (const idl_member_t *member = struct_def->members; member; member = (const idl_member_t *)member->node.next, m++) {
+        m->member = member;
+        m->name = member_name(member);
+        m->type_spec = member->type_spec;
+        m->kind = member->type_spec ? idl_type(java_resolve_alias(member->type_spec)) : 0;
+        m->alias = member_alias(member);
+        m->java_type = java_field_type_name(member->type_spec, use_arrays);
+        if (!m->java_type) return NULL;
+        cdr_type_layout(member->type_spec, format, &m->layout);
+        offset = cdr_align(offset, m->layout.align);
+        m->offset = offset;
+        offset += m->layout.size;
+        m->id = member->declarators ? member->declarators->id.value & 0x0fffffffu : 0;
+        m->key = member->key.value;
+        m->optional = member->optional.value;
+        if (m->key) ir->has_key = true;
+    }
+
+    /* Same order as cdr_key_members(), which the C-layout emitters walk */
+    for (size_t i = 0; i < count; i++) {
+        if (!ir->has_key || ir->members[i].key) ir->keys[ir->key_count++] = &ir->members[i];
+    }
+    qsort(ir->keys, ir->key_count, sizeof(*ir->keys), compare_key_ids);
+    return ir;
+}
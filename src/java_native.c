@@ -0,0 +1,538 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * Native-layout mapping (java-native-layout): <Type>Native is a JNA Structure
+ * whose fields mirror the C struct idlc -l c generates for the same struct or
+ * union, so samples can be handed to dds_write() and loaned samples from
+ * dds_take() read in place, without the CDR codec. Strings are char* Pointers,
+ * bounded strings and arrays are inline arrays, sequences are DdsSequence
+ * (dds_sequence_t), nested structs are embedded by value and unions are a
+ * _d/_u pair around a JNA Union.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/stat.h>
+#include "idlc_java.h"
+
+typedef struct string_builder string_builder_t;
+
+extern string_builder_t *sb_create(void);
+extern void sb_destroy(string_builder_t *sb);
+extern int sb_append(string_builder_t *sb, const char *str);
+extern int sb_appendf(string_builder_t *sb, const char *format, ...);
+extern const char *sb_string(const string_builder_t *sb);
+
+extern const char *resolve_package(const idl_node_t *node, const char *prefix);
+extern const char *java_internf(const char *format, ...);
+extern const char *java_bitmask_type(const idl_bitmask_t *bitmask_def, bool boxed);
+extern const idl_type_spec_t *codec_typedef_alias(const idl_type_spec_t *type_spec);
+extern int64_t case_label_value(const idl_const_expr_t *const_expr);
+extern bool is_topic_type(const idl_node_t *node);
+extern bool generate_topic_descriptor(string_builder_t *sb, const idl_struct_t *struct_def);
+extern int generate_java_endpoints(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *struct_name);
+extern int java_write_file(const char *file_path, const string_builder_t *sb);
+
+/* Java type of one C field: type[count] inline if count > 0 */
+typedef struct native_field {
+    const char *type;
+    uint32_t count;
+    bool sequence;      /* DdsSequence needed in the package */
+} native_field_t;
+
+static const char *get_member_name(const idl_member_t *member) {
+    if (member->declarators && member->declarators->name && member->declarators->name->identifier) {
+        return member->declarators->name->identifier;
+    }
+    return "unknown";
+}
+
+static const char *type_identifier(const idl_type_spec_t *type_spec) {
+    const idl_name_t *name = NULL;
+    if (idl_mask(type_spec) & IDL_STRUCT) {
+        name = ((const idl_struct_t *)type_spec)->name;
+    } else if (idl_mask(type_spec) & IDL_UNION) {
+        name = ((const idl_union_t *)type_spec)->name;
+    }
+    return name && name->identifier ? name->identifier : "Object";
+}
+
+/* Element count of an array declarator (all dimensions), 0 if it is not an array */
+static uint32_t array_count(const idl_declarator_t *declarator) {
+    if (!declarator || !idl_is_array(declarator)) return 0;
+    uint32_t count = 1;
+    for (const idl_node_t *dim = (const idl_node_t *)declarator->const_expr; dim; dim = dim->next) {
+        count *= ((const idl_literal_t *)dim)->value.uint32;
+    }
+    return count;
+}
+
+static uint32_t multiply(uint32_t count, uint32_t by) {
+    return (count ? count : 1) * by;
+}
+
+/* <Type>Native, qualified when it lives in another package */
+static const char *native_class_name(const idl_type_spec_t *type_spec, const char *package, const char *prefix) {
+    const char *type_package = resolve_package((const idl_node_t *)type_spec, prefix);
+    const char *name = type_identifier(type_spec);
+    if (strcmp(type_package, package) == 0) {
+        return java_internf("%sNative", name);
+    }
+    return java_internf("%s.%sNative", type_package, name);
+}
+
+/* Java mapping of a C field of this type; typedefs are resolved, collecting their array dimensions */
+static void native_field(const idl_type_spec_t *type_spec, uint32_t count, const char *package,
+                         const java_generator_config_t *config, native_field_t *field) {
+    while (type_spec && idl_type(type_spec) == IDL_TYPEDEF) {
+        uint32_t dims = array_count((const idl_declarator_t *)type_spec);
+        if (dims) count = multiply(count, dims);
+        type_spec = codec_typedef_alias(type_spec);
+    }
+
+    field->count = count;
+    field->sequence = false;
+    const char *type = "Pointer";
+    switch (type_spec ? idl_type(type_spec) : 0) {
+        case IDL_BOOL:
+        case IDL_CHAR:
+        case IDL_OCTET:
+        case IDL_INT8:
+        case IDL_UINT8:
+            type = "byte";      /* C bool is one byte, unlike a JNA boolean */
+            break;
+        case IDL_SHORT:
+        case IDL_USHORT:
+        case IDL_INT16:
+        case IDL_UINT16:
+            type = "short";
+            break;
+        case IDL_LONG:
+        case IDL_ULONG:
+        case IDL_INT32:
+        case IDL_UINT32:
+        case IDL_ENUM:
+            type = "int";
+            break;
+        case IDL_LLONG:
+        case IDL_ULLONG:
+        case IDL_INT64:
+        case IDL_UINT64:
+            type = "long";
+            break;
+        case IDL_FLOAT:
+            type = "float";
+            break;
+        case IDL_DOUBLE:
+            type = "double";
+            break;
+        case IDL_WCHAR:
+            type = "int";       /* wchar_t, 4 bytes on Linux and macOS */
+            break;
+        case IDL_STRING: {
+            uint32_t maximum = ((const idl_string_t *)type_spec)->maximum;
+            if (maximum > 0) {
+                type = "byte";  /* char[maximum + 1] */
+                field->count = multiply(count, maximum + 1);
+            }
+            break;
+        }
+        case IDL_BITMASK:
+            type = java_bitmask_type((const idl_bitmask_t *)type_spec, false);
+            break;
+        case IDL_SEQUENCE:
+            type = "DdsSequence";
+            field->sequence = true;
+            break;
+        case IDL_STRUCT:
+        case IDL_UNION:
+            field->type = native_class_name(type_spec, package, config->package_prefix);
+            return;
+        default:
+            break;
+    }
+    field->type = type;
+}
+
+static void append_field(string_builder_t *sb, const native_field_t *field, const char *name, int indent) {
+    if (field->count > 0) {
+        sb_appendf(sb, "%*spublic %s[] %s = new %s[%u];\n", indent, "", field->type, name, field->type, field->count);
+    } else {
+        sb_appendf(sb, "%*spublic %s %s;\n", indent, "", field->type, name);
+    }
+}
+
+/* Field of a member: @optional and @external members are pointers in C */
+static bool append_member_field(string_builder_t *sb, const idl_type_spec_t *type_spec, const idl_declarator_t *declarator,
+                                bool pointer, const char *package, const java_generator_config_t *config, int indent) {
+    const char *name = declarator && declarator->name && declarator->name->identifier ? declarator->name->identifier : "unknown";
+    if (pointer) {
+        sb_appendf(sb, "%*spublic Pointer %s;\n", indent, "", name);
+        return false;
+    }
+    native_field_t field;
+    native_field(type_spec, array_count(declarator), package, config, &field);
+    append_field(sb, &field, name, indent);
+    return field.sequence;
+}
+
+static void append_constructors(string_builder_t *sb, const char *class_name) {
+    sb_appendf(sb, "    public %s() {\n", class_name);
+    sb_append(sb, "        super();\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** View of a native sample, e.g. one loaned by dds_take() */\n");
+    sb_appendf(sb, "    public %s(Pointer p) {\n", class_name);
+    sb_append(sb, "        super(p);\n");
+    sb_append(sb, "        read();\n");
+    sb_append(sb, "    }\n\n");
+
+    sb_appendf(sb, "    public static class ByValue extends %s implements Structure.ByValue {\n", class_name);
+    sb_append(sb, "    }\n\n");
+    sb_appendf(sb, "    public static class ByReference extends %s implements Structure.ByReference {\n", class_name);
+    sb_append(sb, "        public ByReference() {\n");
+    sb_append(sb, "        }\n\n");
+    sb_append(sb, "        public ByReference(Pointer p) {\n");
+    sb_append(sb, "            super(p);\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "    }\n");
+}
+
+/* Directory of a Java package under the output directory, created if missing; NULL if out of memory */
+char *java_package_path(const java_generator_config_t *config, const char *package) {
+    size_t len = strlen(config->output_dir) + strlen(package) + 2;
+    char *path = malloc(len);
+    if (!path) return NULL;
+    if (strcmp(config->output_dir, ".") == 0) {
+        snprintf(path, len, "%s", package);
+    } else {
+        snprintf(path, len, "%s/%s", config->output_dir, package);
+    }
+    for (char *p = path; *p; p++) {
+        if (*p == '.') {
+            *p = '\0';
+            mkdir(path, 0755);
+            *p = '/';
+        }
+    }
+    mkdir(path, 0755);
+    return path;
+}
+
+/* Writes <package_path>/<class_name>.java */
+int java_write_class(const char *package_path, const char *class_name, const string_builder_t *sb) {
+    char file_path[768];
+    snprintf(file_path, sizeof(file_path), "%s/%s.java", package_path, class_name);
+    return java_write_file(file_path, sb);
+}
+
+/* DdsSequence: dds_sequence_t, shared by every sequence member in the package */
+static int write_sequence_class(const char *package_path, const char *package) {
+    string_builder_t *sb = sb_create();
+    if (!sb) return -1;
+    sb_appendf(sb, "package %s;\n\n", package);
+    sb_append(sb, "import com.sun.jna.Pointer;\n");
+    sb_append(sb, "import com.sun.jna.Structure;\n\n");
+    sb_append(sb, "/** dds_sequence_t: _buffer holds _length elements in their native layout. */\n");
+    sb_append(sb, "@Structure.FieldOrder({\"_maximum\", \"_length\", \"_buffer\", \"_release\"})\n");
+    sb_append(sb, "public class DdsSequence extends Structure {\n");
+    sb_append(sb, "    public int _maximum;\n");
+    sb_append(sb, "    public int _length;\n");
+    sb_append(sb, "    public Pointer _buffer;\n");
+    sb_append(sb, "    public byte _release;\n\n");
+    append_constructors(sb, "DdsSequence");
+    sb_append(sb, "}\n");
+    int result = java_write_class(package_path, "DdsSequence", sb);
+    sb_destroy(sb);
+    return result;
+}
+
+/* DdsTopicDescriptor: dds_topic_descriptor_t filled from the Descriptor constants of a topic type */
+static int write_descriptor_class(const char *package_path, const char *package) {
+    string_builder_t *sb = sb_create();
+    if (!sb) return -1;
+    sb_appendf(sb, "package %s;\n\n", package);
+    sb_append(sb, "import com.sun.jna.Memory;\n");
+    sb_append(sb, "import com.sun.jna.Native;\n");
+    sb_append(sb, "import com.sun.jna.Pointer;\n");
+    sb_append(sb, "import com.sun.jna.Structure;\n");
+    sb_append(sb, "import java.nio.charset.StandardCharsets;\n");
+    sb_append(sb, "import java.util.ArrayList;\n");
+    sb_append(sb, "import java.util.List;\n\n");
+    sb_append(sb, "/** dds_topic_descriptor_t, for passing a generated <Type>Native.Descriptor to dds_create_topic(). */\n");
+    sb_append(sb, "@Structure.FieldOrder({\"m_size\", \"m_align\", \"m_flagset\", \"m_nkeys\", \"m_typename\", \"m_keys\", \"m_nops\", \"m_ops\", \"m_meta\",\n");
+    sb_append(sb, "        \"type_information_data\", \"type_information_sz\", \"type_mapping_data\", \"type_mapping_sz\", \"restrict_data_representation\"})\n");
+    sb_append(sb, "public class DdsTopicDescriptor extends Structure {\n");
+    sb_append(sb, "    public int m_size;\n");
+    sb_append(sb, "    public int m_align;\n");
+    sb_append(sb, "    public int m_flagset;\n");
+    sb_append(sb, "    public int m_nkeys;\n");
+    sb_append(sb, "    public Pointer m_typename;\n");
+    sb_append(sb, "    public Pointer m_keys;\n");
+    sb_append(sb, "    public int m_nops;\n");
+    sb_append(sb, "    public Pointer m_ops;\n");
+    sb_append(sb, "    public Pointer m_meta;\n");
+    sb_append(sb, "    public Pointer type_information_data;\n");
+    sb_append(sb, "    public int type_information_sz;\n");
+    sb_append(sb, "    public Pointer type_mapping_data;\n");
+    sb_append(sb, "    public int type_mapping_sz;\n");
+    sb_append(sb, "    public int restrict_data_representation;\n\n");
+    sb_append(sb, "    /** Native memory the descriptor points into, alive as long as the descriptor */\n");
+    sb_append(sb, "    private final List<Memory> memory = new ArrayList<>();\n\n");
+    sb_append(sb, "    public DdsTopicDescriptor(String typeName, int size, int align, int flagset, String[] keyNames,\n");
+    sb_append(sb, "                              int[] keyOffsets, int[] keyIndices, int nops, int[] ops) {\n");
+    sb_append(sb, "        m_size = size;\n");
+    sb_append(sb, "        m_align = align;\n");
+    sb_append(sb, "        m_flagset = flagset;\n");
+    sb_append(sb, "        m_typename = string(typeName);\n");
+    sb_append(sb, "        m_nkeys = keyNames.length;\n");
+    sb_append(sb, "        if (keyNames.length > 0) {\n");
+    sb_append(sb, "            int entry = Native.POINTER_SIZE + 8;  // dds_key_descriptor_t\n");
+    sb_append(sb, "            Memory keys = allocate((long) entry * keyNames.length);\n");
+    sb_append(sb, "            for (int i = 0; i < keyNames.length; i++) {\n");
+    sb_append(sb, "                keys.setPointer((long) i * entry, string(keyNames[i]));\n");
+    sb_append(sb, "                keys.setInt((long) i * entry + Native.POINTER_SIZE, keyOffsets[i]);\n");
+    sb_append(sb, "                keys.setInt((long) i * entry + Native.POINTER_SIZE + 4, keyIndices[i]);\n");
+    sb_append(sb, "            }\n");
+    sb_append(sb, "            m_keys = keys;\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        m_nops = nops;\n");
+    sb_append(sb, "        Memory program = allocate(4L * ops.length);\n");
+    sb_append(sb, "        program.write(0, ops, 0, ops.length);\n");
+    sb_append(sb, "        m_ops = program;\n");
+    sb_append(sb, "        write();\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    private Memory allocate(long size) {\n");
+    sb_append(sb, "        Memory block = new Memory(size);\n");
+    sb_append(sb, "        memory.add(block);\n");
+    sb_append(sb, "        return block;\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    private Pointer string(String value) {\n");
+    sb_append(sb, "        byte[] bytes = value.getBytes(StandardCharsets.UTF_8);\n");
+    sb_append(sb, "        Memory block = allocate(bytes.length + 1);\n");
+    sb_append(sb, "        block.write(0, bytes, 0, bytes.length);\n");
+    sb_append(sb, "        block.setByte(bytes.length, (byte) 0);\n");
+    sb_append(sb, "        return block;\n");
+    sb_append(sb, "    }\n");
+    sb_append(sb, "}\n");
+    int result = java_write_class(package_path, "DdsTopicDescriptor", sb);
+    sb_destroy(sb);
+    return result;
+}
+
+static int write_native_class(const java_generator_config_t *config, const char *class_name, const char *package,
+                              const string_builder_t *sb, bool uses_sequence, bool uses_descriptor) {
+    char *package_path = java_package_path(config, package);
+    if (!package_path) return -1;
+    int result = java_write_class(package_path, class_name, sb);
+    if (result == 0 && uses_sequence) {
+        result = write_sequence_class(package_path, package);
+    }
+    if (result == 0 && uses_descriptor) {
+        result = write_descriptor_class(package_path, package);
+    }
+    free(package_path);
+    return result;
+}
+
+static void append_header(string_builder_t *sb, const char *package) {
+    sb_appendf(sb, "package %s;\n\n", package);
+    sb_append(sb, "import com.sun.jna.Pointer;\n");
+    sb_append(sb, "import com.sun.jna.Structure;\n\n");
+}
+
+int generate_java_native_struct(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *struct_name) {
+    if (!struct_def || !config || !config->output_dir || !struct_name) return -1;
+
+    const char *package = resolve_package((const idl_node_t *)struct_def, config->package_prefix);
+    string_builder_t *sb = sb_create();
+    string_builder_t *fields = sb_create();
+    if (!sb || !fields) {
+        sb_destroy(sb);
+        sb_destroy(fields);
+        return -1;
+    }
+
+    char class_name[256];
+    snprintf(class_name, sizeof(class_name), "%sNative", struct_name);
+
+    /* idlc -l c embeds the base struct as the first member, named parent */
+    bool uses_sequence = false;
+    sb_append(sb, "@Structure.FieldOrder({");
+    const char *separator = "";
+    if (struct_def->inherit_spec && struct_def->inherit_spec->base) {
+        const char *base = native_class_name(struct_def->inherit_spec->base, package, config->package_prefix);
+        sb_append(sb, "\"parent\"");
+        sb_appendf(fields, "    public %s parent;\n", base);
+        separator = ", ";
+    }
+    for (const idl_member_t *member = struct_def->members; member; ) {
+        sb_appendf(sb, "%s\"%s\"", separator, get_member_name(member));
+        separator = ", ";
+        if (append_member_field(fields, member->type_spec, member->declarators,
+                                member->optional.value || member->external.value, package, config, 4)) {
+            uses_sequence = true;
+        }
+
+        idl_node_t *next_node = (idl_node_t *)member;
+        if (!next_node->next) break;
+        member = (const idl_member_t *)next_node->next;
+    }
+    sb_append(sb, "})\n");
+
+    string_builder_t *out = sb_create();
+    append_header(out, package);
+    sb_appendf(out, "/** C layout of %s as generated by idlc -l c. */\n", struct_name);
+    sb_append(out, sb_string(sb));
+    sb_appendf(out, "public class %s extends Structure {\n", class_name);
+    sb_append(out, sb_string(fields));
+    sb_append(out, "\n");
+    append_constructors(out, class_name);
+    bool uses_descriptor = false;
+    if (is_topic_type((const idl_node_t *)struct_def)) {
+        sb_append(out, "\n");
+        sb_append(out, "    /** Rebinds this sample to native memory, e.g. the next sample loaned by dds_take() */\n");
+        sb_append(out, "    public void view(Pointer p) {\n");
+        sb_append(out, "        useMemory(p);\n");
+        sb_append(out, "        read();\n");
+        sb_append(out, "    }\n");
+        uses_descriptor = generate_topic_descriptor(out, struct_def);
+    }
+    sb_append(out, "}\n");
+
+    int result = write_native_class(config, class_name, package, out, uses_sequence, uses_descriptor);
+    if (result == 0 && uses_descriptor) {
+        result = generate_java_endpoints(struct_def, config, struct_name);
+    }
+    sb_destroy(out);
+    sb_destroy(fields);
+    sb_destroy(sb);
+    return result;
+}
+
+/* Java literal of a label compared against a native _d of the given type */
+static void append_label(string_builder_t *sb, int64_t value, const char *discrim_type) {
+    if (strcmp(discrim_type, "long") == 0) {
+        sb_appendf(sb, "%lldL", (long long)value);
+    } else if (value > INT32_MAX) {
+        sb_appendf(sb, "(int) %lldL", (long long)value);
+    } else {
+        sb_appendf(sb, "%lld", (long long)value);
+    }
+}
+
+/*
+ * selectBranch(): JNA only reads and writes the active field of a Union, so
+ * the branch selected by _d is set before every write() and after read().
+ */
+static void append_branch_selection(string_builder_t *sb, const idl_union_t *union_def, const char *discrim_type) {
+    sb_append(sb, "    private void selectBranch() {\n");
+    const char *keyword = "if";
+    const char *default_name = NULL;
+    for (const idl_case_t *case_def = union_def->cases; case_def; ) {
+        const char *name = case_def->declarator && case_def->declarator->name ? case_def->declarator->name->identifier : NULL;
+        if (name && idl_is_default_case(case_def)) {
+            default_name = name;
+        } else if (name) {
+            sb_appendf(sb, "        %s (", keyword);
+            const char *separator = "";
+            for (const idl_case_label_t *label = case_def->labels; label; ) {
+                sb_appendf(sb, "%s_d == ", separator);
+                append_label(sb, case_label_value(label->const_expr), discrim_type);
+                separator = " || ";
+                idl_node_t *next_label = (idl_node_t *)label;
+                if (!next_label->next) break;
+                label = (const idl_case_label_t *)next_label->next;
+            }
+            sb_append(sb, ") {\n");
+            sb_appendf(sb, "            _u.setType(\"%s\");\n", name);
+            keyword = "} else if";
+        }
+
+        idl_node_t *next_node = (idl_node_t *)case_def;
+        if (!next_node->next) break;
+        case_def = (const idl_case_t *)next_node->next;
+    }
+    if (default_name) {
+        if (strcmp(keyword, "if") == 0) {
+            sb_appendf(sb, "        _u.setType(\"%s\");\n", default_name);
+        } else {
+            sb_append(sb, "        } else {\n");
+            sb_appendf(sb, "            _u.setType(\"%s\");\n", default_name);
+            sb_append(sb, "        }\n");
+        }
+    } else if (strcmp(keyword, "if") != 0) {
+        sb_append(sb, "        }\n");
+    }
+    sb_append(sb, "    }\n\n");
+
+    sb_append(sb, "    @Override\n");
+    sb_append(sb, "    public void read() {\n");
+    sb_append(sb, "        super.read();\n");
+    sb_append(sb, "        selectBranch();\n");
+    sb_append(sb, "        _u.read();\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    @Override\n");
+    sb_append(sb, "    public void write() {\n");
+    sb_append(sb, "        selectBranch();\n");
+    sb_append(sb, "        super.write();\n");
+    sb_append(sb, "    }\n\n");
+}
+
+int generate_java_native_union(const idl_union_t *union_def, const java_generator_config_t *config, const char *union_name) {
+    if (!union_def || !config || !config->output_dir || !union_name) return -1;
+
+    const char *package = resolve_package((const idl_node_t *)union_def, config->package_prefix);
+    string_builder_t *sb = sb_create();
+    if (!sb) {
+        return -1;
+    }
+
+    char class_name[256];
+    snprintf(class_name, sizeof(class_name), "%sNative", union_name);
+
+    native_field_t discrim = { NULL, 0, false };
+    if (union_def->switch_type_spec) {
+        native_field(union_def->switch_type_spec->type_spec, 0, package, config, &discrim);
+    } else {
+        discrim.type = "int";
+    }
+
+    append_header(sb, package);
+    sb_appendf(sb, "/** C layout of %s as generated by idlc -l c: the discriminator _d and the union _u. */\n", union_name);
+    sb_append(sb, "@Structure.FieldOrder({\"_d\", \"_u\"})\n");
+    sb_appendf(sb, "public class %s extends Structure {\n", class_name);
+    sb_appendf(sb, "    public %s _d;\n", discrim.type);
+    sb_append(sb, "    public _U _u;\n\n");
+
+    bool uses_sequence = false;
+    sb_append(sb, "    public static class _U extends com.sun.jna.Union {\n");
+    for (const idl_case_t *case_def = union_def->cases; case_def; ) {
+        if (case_def->declarator &&
+            append_member_field(sb, case_def->type_spec, case_def->declarator, false, package, config, 8)) {
+            uses_sequence = true;
+        }
+        idl_node_t *next_node = (idl_node_t *)case_def;
+        if (!next_node->next) break;
+        case_def = (const idl_case_t *)next_node->next;
+    }
+    sb_append(sb, "    }\n\n");
+
+    append_branch_selection(sb, union_def, discrim.type);
+    append_constructors(sb, class_name);
+    sb_append(sb, "}\n");
+
+    int result = write_native_class(config, class_name, package, sb, uses_sequence, false);
+    sb_destroy(sb);
+    return result;
+}
@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * Write-if-changed output. The output directory holds a manifest with the
+ * FNV-1a hash and size of every file the previous run generated. A file whose
+ * content hashes the same and that still exists is not rewritten, so its
+ * mtime stays put and javac does not recompile it; files the previous run
+ * generated and this one did not are removed at the end. Paths in the
+ * manifest are relative to the output directory.
+ *
+ * Generators call java_write_file() from several threads with java-jobs, so
+ * the table is guarded by a mutex. A path is claimed under the lock before
+ * it is written: per-package classes that many types emit are only written
+ * by the first of them.
+ *
+ * With owner tracking on, every claim also records the type being generated
+ * on the calling thread, so the dependency graph can list the files of each
+ * type, the shared ones included.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "idlc_java.h"
+
+typedef struct string_builder string_builder_t;
+
+extern const char *sb_string(const string_builder_t *sb);
+extern size_t sb_length(const string_builder_t *sb);
+
+#define MANIFEST_NAME ".idlc-java.manifest"
+#define MANIFEST_HEADER "# idlc-java manifest 1"
+
+typedef struct manifest_entry {
+    char *path;         /* relative to the output directory */
+    uint64_t hash;
+    size_t size;
+    bool written;       /* generated by this run */
+} manifest_entry_t;
+
+typedef struct output_owner {
+    const void *owner;  /* definition node that claimed the file */
+    size_t entry;
+    size_t seq;         /* claim order */
+} output_owner_t;
+
+typedef struct manifest {
+    char *output_dir;
+    manifest_entry_t *entries;
+    size_t count;
+    size_t capacity;
+    size_t *slots;      /* open-addressed path index, entry index + 1 or 0 */
+    size_t slot_count;  /* power of two, at least twice count */
+    size_t created;
+    size_t unchanged;
+    bool track_owners;
+    bool owners_failed;     /* out of memory recording an owner */
+    bool owners_sorted;
+    output_owner_t *owners;
+    size_t owner_count;
+    size_t owner_capacity;
+} manifest_t;
+
+static manifest_t *manifest = NULL;
+static pthread_mutex_t manifest_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local const void *current_owner = NULL;
+
+static uint64_t fnv1a(const char *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static size_t *find_slot(const manifest_t *m, const char *path) {
+    size_t mask = m->slot_count - 1;
+    size_t i = fnv1a(path, strlen(path)) & mask;
+    while (m->slots[i] != 0 && strcmp(m->entries[m->slots[i] - 1].path, path) != 0) {
+        i = (i + 1) & mask;
+    }
+    return &m->slots[i];
+}
+
+static manifest_entry_t *find_entry(manifest_t *m, const char *path) {
+    if (m->slot_count == 0) return NULL;
+    size_t slot = *find_slot(m, path);
+    return slot ? &m->entries[slot - 1] : NULL;
+}
+
+static int grow_slots(manifest_t *m) {
+    size_t slot_count = m->slot_count ? 2 * m->slot_count : 128;
+    size_t *slots = calloc(slot_count, sizeof(*slots));
+    if (!slots) return -1;
+    free(m->slots);
+    m->slots = slots;
+    m->slot_count = slot_count;
+    for (size_t i = 0; i < m->count; i++) {
+        *find_slot(m, m->entries[i].path) = i + 1;
+    }
+    return 0;
+}
+
+static manifest_entry_t *add_entry(manifest_t *m, const char *path) {
+    if (2 * (m->count + 1) > m->slot_count && grow_slots(m) != 0) return NULL;
+    if (m->count == m->capacity) {
+        size_t capacity = m->capacity ? 2 * m->capacity : 64;
+        manifest_entry_t *entries = realloc(m->entries, capacity * sizeof(*entries));
+        if (!entries) return NULL;
+        m->entries = entries;
+        m->capacity = capacity;
+    }
+    char *copy = strdup(path);
+    if (!copy) return NULL;
+    manifest_entry_t *entry = &m->entries[m->count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->path = copy;
+    *find_slot(m, copy) = m->count;
+    return entry;
+}
+
+static char *manifest_path(const manifest_t *m) {
+    size_t len = strlen(m->output_dir) + sizeof(MANIFEST_NAME) + 1;
+    char *path = malloc(len);
+    if (path) snprintf(path, len, "%s/%s", m->output_dir, MANIFEST_NAME);
+    return path;
+}
+
+/* Full path of an entry, or a relative path as-is when generating into "." */
+static void entry_file_path(const manifest_t *m, const manifest_entry_t *entry, char *buf, size_t size) {
+    if (strcmp(m->output_dir, ".") == 0) {
+        snprintf(buf, size, "%s", entry->path);
+    } else {
+        snprintf(buf, size, "%s/%s", m->output_dir, entry->path);
+    }
+}
+
+static const char *relative_path(const manifest_t *m, const char *file_path) {
+    size_t len = strlen(m->output_dir);
+    if (strncmp(file_path, m->output_dir, len) == 0 && file_path[len] == '/') {
+        return file_path + len + 1;
+    }
+    return file_path;
+}
+
+/* A missing or unreadable manifest only means every file is written */
+static void load_manifest(manifest_t *m) {
+    char *path = manifest_path(m);
+    FILE *f = path ? fopen(path, "r") : NULL;
+    free(path);
+    if (!f) return;
+
+    char line[1024];
+    if (!fgets(line, sizeof(line), f) || strncmp(line, MANIFEST_HEADER, strlen(MANIFEST_HEADER)) != 0) {
+        fclose(f);
+        return;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long hash, size;
+        int offset;
+        line[strcspn(line, "\n")] = '\0';
+        if (sscanf(line, "%16llx %llu %n", &hash, &size, &offset) != 2 || line[offset] == '\0') continue;
+        manifest_entry_t *entry = add_entry(m, line + offset);
+        if (!entry) break;
+        entry->hash = hash;
+        entry->size = size;
+    }
+    fclose(f);
+}
+
+static void free_manifest(manifest_t *m) {
+    for (size_t i = 0; i < m->count; i++) {
+        free(m->entries[i].path);
+    }
+    free(m->entries);
+    free(m->slots);
+    free(m->owners);
+    free(m->output_dir);
+    free(m);
+}
+
+/*
+ * Starts a run writing into output_dir against the manifest found there.
+ * track_owners records which type generated each file, for
+ * java_output_owned_files().
+ */
+int java_output_begin(const char *output_dir, bool track_owners) {
+    manifest_t *m = calloc(1, sizeof(*m));
+    if (!m) return -1;
+    m->output_dir = strdup(output_dir);
+    if (!m->output_dir) {
+        free(m);
+        return -1;
+    }
+    m->track_owners = track_owners;
+    load_manifest(m);
+    manifest = m;
+    return 0;
+}
+
+static int compare_entries(const void *a, const void *b) {
+    const manifest_entry_t *x = a, *y = b;
+    return strcmp(x->path, y->path);
+}
+
+/*
+ * Ends the run: removes the files only the previous run generated, unless
+ * this run failed and may not have got to them, and saves the manifest.
+ */
+int java_output_end(bool complete) {
+    manifest_t *m = manifest;
+    if (!m) return 0;
+    manifest = NULL;
+
+    size_t removed = 0;
+    char file_path[1024];
+    for (size_t i = 0; i < m->count; i++) {
+        manifest_entry_t *entry = &m->entries[i];
+        if (entry->written || !complete) continue;
+        entry_file_path(m, entry, file_path, sizeof(file_path));
+        if (unlink(file_path) == 0) {
+            printf("  Removed: %s\n", file_path);
+            removed++;
+        }
+    }
+
+    /* Entries are added in the order the jobs finish; sorting keeps the manifest
+     * the same for any job count. The slots and owners are stale from here on. */
+    qsort(m->entries, m->count, sizeof(*m->entries), compare_entries);
+
+    int ret = 0;
+    char *path = manifest_path(m);
+    FILE *f = path ? fopen(path, "w") : NULL;
+    if (f) {
+        fprintf(f, "%s\n", MANIFEST_HEADER);
+        for (size_t i = 0; i < m->count; i++) {
+            const manifest_entry_t *entry = &m->entries[i];
+            if (!entry->written && complete) continue;
+            fprintf(f, "%016llx %llu %s\n", (unsigned long long)entry->hash,
+                    (unsigned long long)entry->size, entry->path);
+        }
+        fclose(f);
+    } else {
+        fprintf(stderr, "  Error: Could not write manifest: %s\n", path ? path : MANIFEST_NAME);
+        ret = -1;
+    }
+    free(path);
+
+    printf("Wrote %zu files, %zu unchanged, %zu removed\n", m->created, m->unchanged, removed);
+    free_manifest(m);
+    return ret;
+}
+
+static void add_owner(manifest_t *m, size_t entry) {
+    if (m->owner_count == m->owner_capacity) {
+        size_t capacity = m->owner_capacity ? 2 * m->owner_capacity : 256;
+        output_owner_t *owners = realloc(m->owners, capacity * sizeof(*owners));
+        if (!owners) {
+            m->owners_failed = true;
+            return;
+        }
+        m->owners = owners;
+        m->owner_capacity = capacity;
+    }
+    output_owner_t *owner = &m->owners[m->owner_count];
+    owner->owner = current_owner;
+    owner->entry = entry;
+    owner->seq = m->owner_count++;
+    m->owners_sorted = false;
+}
+
+/*
+ * Claims file_path for this run. Returns true if it must be written, false
+ * if the file on disk already has this content or another type of this run
+ * wrote it.
+ */
+static bool claim_file(const char *file_path, uint64_t hash, size_t size) {
+    pthread_mutex_lock(&manifest_lock);
+    manifest_t *m = manifest;
+    const char *path = relative_path(m, file_path);
+    manifest_entry_t *entry = find_entry(m, path);
+    bool write;
+    if (!entry) {
+        entry = add_entry(m, path);
+        write = true;
+    } else if (entry->hash != hash || entry->size != size) {
+        write = true;
+    } else if (entry->written) {
+        write = false;
+    } else {
+        struct stat st;
+        write = stat(file_path, &st) != 0 || (size_t)st.st_size != size;
+    }
+    if (entry) {
+        if (!write && !entry->written) m->unchanged++;
+        if (write) m->created++;
+        entry->hash = hash;
+        entry->size = size;
+        entry->written = true;
+        if (m->track_owners && current_owner) add_owner(m, (size_t)(entry - m->entries));
+    }
+    pthread_mutex_unlock(&manifest_lock);
+    return write;
+}
+
+/* Writes sb to file_path unless the file already holds exactly that */
+int java_write_file(const char *file_path, const string_builder_t *sb) {
+    const char *content = sb_string(sb);
+    size_t size = sb_length(sb);
+
+    if (manifest && !claim_file(file_path, fnv1a(content, size), size)) {
+        return 0;
+    }
+
+    FILE *f = fopen(file_path, "w");
+    if (!f) {
+        fprintf(stderr, "  Error: Could not create file: %s\n", file_path);
+        return -1;
+    }
+    fwrite(content, 1, size, f);
+    fclose(f);
+    printf("  Created: %s\n", file_path);
+    return 0;
+}
+
+/* Files claimed on this thread from now on belong to owner, NULL for none */
+void java_output_set_owner(const void *owner) {
+    current_owner = owner;
+}
+
+static int compare_owners(const void *a, const void *b) {
+    const output_owner_t *x = a, *y = b;
+    uintptr_t ox = (uintptr_t)x->owner, oy = (uintptr_t)y->owner;
+    if (ox != oy) return ox < oy ? -1 : 1;
+    return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+/*
+ * Calls fn with the path, relative to the output directory, of every file
+ * owner claimed so far, once each and in the order it claimed them. Returns
+ * -1 if owners were not tracked or not all of them could be recorded.
+ */
+int java_output_owned_files(const void *owner, void (*fn)(const char *path, void *arg), void *arg) {
+    pthread_mutex_lock(&manifest_lock);
+    manifest_t *m = manifest;
+    if (!m || !m->track_owners || m->owners_failed) {
+        pthread_mutex_unlock(&manifest_lock);
+        return -1;
+    }
+    if (!m->owners_sorted) {
+        qsort(m->owners, m->owner_count, sizeof(*m->owners), compare_owners);
+        m->owners_sorted = true;
+    }
+
+    /* first claim of owner */
+    size_t lo = 0, hi = m->owner_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((uintptr_t)m->owners[mid].owner < (uintptr_t)owner) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (size_t i = lo; i < m->owner_count && m->owners[i].owner == owner; i++) {
+        bool seen = false;
+        for (size_t j = lo; j < i && !seen; j++) {
+            seen = m->owners[j].entry == m->owners[i].entry;
+        }
+        if (!seen) fn(m->entries[m->owners[i].entry].path, arg);
+    }
+    pthread_mutex_unlock(&manifest_lock);
+    return 0;
+}
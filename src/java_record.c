@@ -26,20 +26,51 @@ extern int sb_append(string_builder_t *sb, const char *str);
 extern int sb_appendf(string_builder_t *sb, const char *format, ...);
 extern const char *sb_string(const string_builder_t *sb);
 
-extern char *resolve_package(const idl_node_t *node, const char *prefix);
-extern char *java_type_name(const idl_type_spec_t *type_spec, bool boxed);
+extern const char *resolve_package(const idl_node_t *node, const char *prefix);
+extern const char *java_type_name(const idl_type_spec_t *type_spec, bool boxed);
+extern const char *java_bitmask_type(const idl_bitmask_t *bitmask_def, bool boxed);
+extern const idl_type_spec_t *java_resolve_alias(const idl_type_spec_t *type_spec);
+extern const char *java_default_value(idl_type_t type);
+extern char *java_key_hash_expr(const idl_type_spec_t *type_spec, const char *expr, bool use_arrays);
+extern char *java_key_equals_expr(const idl_type_spec_t *type_spec, const char *a, const char *b, bool use_arrays);
+extern uint32_t cdr_primitive_size(idl_type_t type);
+extern uint32_t cdr_align(uint32_t offset, uint32_t align);
+extern uint32_t cdr_max_align(java_cdr_format_t format);
+extern uint32_t cdr_enum_size(const idl_enum_t *enum_def, java_cdr_format_t format);
+extern uint32_t cdr_bitmask_size(const idl_bitmask_t *bitmask_def);
+extern bool cdr_key_supported(const idl_struct_t *struct_def);
+extern bool cdr_key_fits(const idl_struct_t *struct_def, java_cdr_format_t format, uint32_t limit);
+extern void codec_init(java_codec_t *codec, string_builder_t *sb, java_cdr_format_t format, bool use_arrays);
+extern void codec_size_align(java_codec_t *codec, int indent, uint32_t align);
+extern void codec_size_add(java_codec_t *codec, uint32_t size);
+extern void codec_size_flush(java_codec_t *codec, int indent);
+extern void codec_write_align(java_codec_t *codec, int indent, uint32_t align);
+extern void codec_read_align(java_codec_t *codec, int indent, uint32_t align);
+extern void codec_emit_size(java_codec_t *codec, const idl_type_spec_t *type_spec, const char *expr, int indent, int depth);
+extern void codec_emit_write(java_codec_t *codec, const idl_type_spec_t *type_spec, const char *expr, int indent, int depth);
+extern void codec_emit_read(java_codec_t *codec, const idl_type_spec_t *type_spec, const char *target, int indent, int depth);
+extern uint32_t codec_length_code(const java_codec_t *codec, const idl_type_spec_t *type_spec);
+extern bool codec_type_encodable(const idl_type_spec_t *type_spec);
+extern const idl_type_spec_t *codec_typedef_alias(const idl_type_spec_t *type_spec);
+extern const char *codec_width_accessor(uint32_t width);
+extern const char *codec_width_cast(uint32_t width);
+extern uint32_t codec_bytecode_size(const char *code);
+extern java_struct_ir_t *java_struct_ir_build(const idl_struct_t *struct_def, java_cdr_format_t format, bool use_arrays);
+extern const char *java_internf(const char *format, ...);
+extern int java_write_file(const char *file_path, const string_builder_t *sb);
+extern int generate_type_object_constants(string_builder_t *sb, const idl_type_spec_t *type_spec);
 
-static const char *get_member_name(const idl_member_t *member) {
-    if (member->declarators && member->declarators->name && member->declarators->name->identifier) {
-        return member->declarators->name->identifier;
+/* TypeObjects holder of a type; a type the hashes cannot describe gets none rather than a wrong one */
+static void generate_type_objects(string_builder_t *sb, const idl_type_spec_t *type_spec, const char *type_name) {
+    if (generate_type_object_constants(sb, type_spec) != 0) {
+        fprintf(stderr, "  Warning: no TypeObjects for %s (recursive or unsupported type)\n", type_name);
     }
-    return "field";
 }
 
 static idl_type_t resolve_typedef_type(const idl_type_spec_t *type_spec) {
     if (!type_spec) return 0;
     // Use idl_type directly instead of idl_unalias to avoid accessing freed memory
-    return idl_type(type_spec);
+    return idl_type(java_resolve_alias(type_spec));
 }
 
 static const char *dynamic_type_kind(idl_type_t type) {
@@ -66,59 +97,61 @@ static const char *dynamic_type_kind(idl_type_t type) {
     }
 }
 
-static int generate_structure_header(string_builder_t *sb, const char *package, const char *class_name) {
+/*
+ * Opening line of a generated class. By default types extend JNA Structure;
+ * with java-records they are plain final classes, which avoids Structure's
+ * native allocation and reflective field discovery on every instantiation.
+ */
+static void generate_class_declaration(string_builder_t *sb, const char *class_name, bool plain) {
+    if (plain) {
+        sb_appendf(sb, "public final class %s {\n\n", class_name);
+    } else {
+        sb_appendf(sb, "public class %s extends Structure {\n\n", class_name);
+    }
+}
+
+static int generate_structure_header(string_builder_t *sb, const char *package, const char *class_name, bool plain, bool cdr) {
     sb_appendf(sb, "package %s;\n\n", package);
-    sb_append(sb, "import com.sun.jna.Structure;\n");
+    if (!plain) sb_append(sb, "import com.sun.jna.Structure;\n");
     sb_append(sb, "import java.nio.ByteBuffer;\n");
     sb_append(sb, "import java.nio.ByteOrder;\n");
-    sb_append(sb, "import java.nio.charset.StandardCharsets;\n\n");
-    sb_appendf(sb, "public class %s extends Structure {\n\n", class_name);
+    if (cdr) {
+        sb_append(sb, "import org.eclipse.cyclonedds.java.cdr.CdrReader;\n");
+        sb_append(sb, "import org.eclipse.cyclonedds.java.cdr.CdrWriter;\n");
+    }
+    sb_append(sb, "\n");
+    generate_class_declaration(sb, class_name, plain);
     return 0;
 }
 
-static int generate_field_order(string_builder_t *sb, const idl_struct_t *struct_def) {
+static int generate_field_order(string_builder_t *sb, const java_struct_ir_t *ir) {
     sb_append(sb, "    @Structure.FieldOrder({");
-    
-    int count = 0;
-    for (const idl_member_t *member = struct_def->members; member; ) {
-        if (count > 0) sb_append(sb, ", ");
-        sb_appendf(sb, "\"%s\"", get_member_name(member));
-        count++;
-        idl_node_t *next_node = (idl_node_t *)member;
-        if (!next_node->next) break;
-        member = (const idl_member_t *)next_node->next;
+    for (size_t i = 0; i < ir->count; i++) {
+        sb_appendf(sb, "%s\"%s\"", i > 0 ? ", " : "", ir->members[i].name);
     }
-    
     sb_append(sb, "})\n\n");
     return 0;
 }
 
-static int generate_structure_fields(string_builder_t *sb, const idl_struct_t *struct_def) {
-    for (const idl_member_t *member = struct_def->members; member; ) {
-        const char *name = get_member_name(member);
-        char *java_type = java_type_name(member->type_spec, false);
-        sb_appendf(sb, "    public %s %s;\n", java_type, name);
-        free(java_type);
-        idl_node_t *next_node = (idl_node_t *)member;
-        if (!next_node->next) break;
-        member = (const idl_member_t *)next_node->next;
+static int generate_structure_fields(string_builder_t *sb, const java_struct_ir_t *ir) {
+    for (size_t i = 0; i < ir->count; i++) {
+        const java_member_ir_t *m = &ir->members[i];
+        if (m->alias) {
+            sb_appendf(sb, "    public %s %s;  // %s\n", m->java_type, m->name, m->alias);
+        } else {
+            sb_appendf(sb, "    public %s %s;\n", m->java_type, m->name);
+        }
     }
     sb_append(sb, "\n");
     return 0;
 }
 
-static int generate_describe_type(string_builder_t *sb, const idl_struct_t *struct_def, const char *class_name) {
+static int generate_describe_type(string_builder_t *sb, const java_struct_ir_t *ir, const char *class_name) {
     sb_appendf(sb, "    public static DynamicType describeType() {\n");
     sb_appendf(sb, "        DynamicType dt = new DynamicType(\"%s\");\n", class_name);
-    
-    for (const idl_member_t *member = struct_def->members; member; ) {
-        const char *name = get_member_name(member);
-        idl_type_t type = resolve_typedef_type(member->type_spec);
-        const char *kind = dynamic_type_kind(type);
-        sb_appendf(sb, "        dt.addMember(\"%s\", DynamicType.%s);\n", name, kind);
-        idl_node_t *next_node = (idl_node_t *)member;
-        if (!next_node->next) break;
-        member = (const idl_member_t *)next_node->next;
+    for (size_t i = 0; i < ir->count; i++) {
+        const java_member_ir_t *m = &ir->members[i];
+        sb_appendf(sb, "        dt.addMember(\"%s\", DynamicType.%s);\n", m->name, dynamic_type_kind(m->kind));
     }
     
     sb_append(sb, "        return dt;\n");
@@ -126,359 +159,806 @@ static int generate_describe_type(string_builder_t *sb, const idl_struct_t *stru
     return 0;
 }
 
-static int generate_serialize_method(string_builder_t *sb, const idl_struct_t *struct_def, const char *class_name) {
+/* ByteBuffer accessor suffix for a primitive: put<X>/get<X> */
+static const char *buffer_accessor(idl_type_t type) {
+    switch (type) {
+        case IDL_BOOL:
+        case IDL_OCTET:
+        case IDL_CHAR: return "";
+        case IDL_SHORT: return "Short";
+        case IDL_USHORT: return "Char";
+        case IDL_LONG:
+        case IDL_ULONG: return "Int";
+        case IDL_LLONG:
+        case IDL_ULLONG: return "Long";
+        case IDL_FLOAT: return "Float";
+        case IDL_DOUBLE: return "Double";
+        default: return NULL;
+    }
+}
+
+/* "offset" or "offset + N" for an absolute member offset */
+static const char *offset_expr(char *buf, size_t size, uint32_t offset) {
+    if (offset == 0) {
+        snprintf(buf, size, "offset");
+    } else {
+        snprintf(buf, size, "offset + %u", offset);
+    }
+    return buf;
+}
+
+static int generate_fixed_size_constants(string_builder_t *sb, const cdr_layout_t *layout) {
+    if (layout->fixed) {
+        sb_appendf(sb, "    public static final int SERIALIZED_SIZE = %u;\n\n", layout->size);
+    }
+    sb_append(sb, "    public static boolean isFixedSize() {\n");
+    sb_appendf(sb, "        return %s;\n", layout->fixed ? "true" : "false");
+    sb_append(sb, "    }\n\n");
+    return 0;
+}
+
+/* XCDR representation identifier, little-endian variant */
+static uint32_t encapsulation_id(idl_extensibility_t extensibility, java_cdr_format_t format) {
+    if (format == JAVA_CDR_XCDR1) return 0x0001;           /* CDR_LE */
+    switch (extensibility) {
+        case IDL_APPENDABLE: return 0x0009;                /* D_CDR2_LE */
+        case IDL_MUTABLE: return 0x000b;                   /* PL_CDR2_LE */
+        default: return 0x0007;                            /* CDR2_LE */
+    }
+}
+
+static void generate_fixed_member_write(string_builder_t *sb, const java_member_ir_t *m, const char *at) {
+    const char *name = m->name;
+    idl_type_t type = m->kind;
+
+    if (type == IDL_BOOL) {
+        sb_appendf(sb, "        buffer.put(%s, %s ? (byte) 1 : (byte) 0);\n", at, name);
+    } else if (buffer_accessor(type)) {
+        sb_appendf(sb, "        buffer.put%s(%s, %s);\n", buffer_accessor(type), at, name);
+    } else if (type == IDL_ENUM) {
+        uint32_t width = m->layout.size;
+        sb_appendf(sb, "        buffer.put%s(%s, %s%s.getValue());\n", codec_width_accessor(width), at, width == 4 ? "" : codec_width_cast(width), name);
+    } else if (type == IDL_BITMASK) {
+        uint32_t width = m->layout.size;
+        sb_appendf(sb, "        buffer.put%s(%s, %s);\n", codec_width_accessor(width), at, name);
+    } else if (type == IDL_STRUCT) {
+        sb_appendf(sb, "        (%s != null ? %s : new %s()).writeAt(buffer, %s);\n", name, name, m->java_type, at);
+    }
+}
+
+static void generate_fixed_member_read(string_builder_t *sb, const java_member_ir_t *m, const char *at) {
+    const char *name = m->name;
+    idl_type_t type = m->kind;
+
+    if (type == IDL_BOOL) {
+        sb_appendf(sb, "        %s = buffer.get(%s) != 0;\n", name, at);
+    } else if (buffer_accessor(type)) {
+        sb_appendf(sb, "        %s = buffer.get%s(%s);\n", name, buffer_accessor(type), at);
+    } else if (type == IDL_ENUM) {
+        uint32_t width = m->layout.size;
+        sb_appendf(sb, "        %s = %s.fromValue(buffer.get%s(%s)%s);\n", name, m->java_type, codec_width_accessor(width), at,
+                   width == 1 ? " & 0xff" : width == 2 ? " & 0xffff" : "");
+    } else if (type == IDL_BITMASK) {
+        uint32_t width = m->layout.size;
+        sb_appendf(sb, "        %s = buffer.get%s(%s);\n", name, codec_width_accessor(width), at);
+    } else if (type == IDL_STRUCT) {
+        sb_appendf(sb, "        if (%s == null) {\n", name);
+        sb_appendf(sb, "            %s = new %s();\n", name, m->java_type);
+        sb_append(sb, "        }\n");
+        sb_appendf(sb, "        %s.readAt(buffer, %s);\n", name, at);
+    }
+}
+
+/*
+ * deserialize(buffer, reuse): decodes the serialized form at the buffer's
+ * position into reuse, or into a new instance if it is null, and leaves the
+ * buffer just past it. deserializeFrom() refills the lists, primitive arrays
+ * and nested instances reuse already holds, so a reader that passes the same
+ * sample back for every read allocates only for strings and growth.
+ * Decoding goes through a duplicate, so the caller's byte order is left
+ * alone; past an encapsulated payload it skips the padding the options
+ * field announces, up to the buffer's limit.
+ */
+static int generate_reuse_deserialize(string_builder_t *sb, const char *name, bool encapsulated) {
+    sb_appendf(sb, "    public static %s deserialize(ByteBuffer buffer, %s reuse) {\n", name, name);
+    sb_appendf(sb, "        %s sample = reuse != null ? reuse : new %s();\n", name, name);
+    if (encapsulated) {
+        sb_append(sb, "        int start = buffer.position();\n");
+        sb_append(sb, "        ByteBuffer payload = buffer.duplicate();\n");
+        sb_append(sb, "        payload.position(start + 4);\n");
+        sb_append(sb, "        payload = payload.slice();\n");
+        sb_append(sb, "        payload.order((buffer.get(start + 1) & 1) != 0 ? ByteOrder.LITTLE_ENDIAN : ByteOrder.BIG_ENDIAN);\n");
+        sb_append(sb, "        sample.deserializeFrom(payload);\n");
+        sb_append(sb, "        int end = start + 4 + payload.position() + (buffer.get(start + 3) & 3);\n");
+        sb_append(sb, "        buffer.position(Math.min(end, buffer.limit()));\n");
+    } else {
+        sb_append(sb, "        ByteBuffer payload = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN);\n");
+        sb_append(sb, "        sample.deserializeFrom(payload);\n");
+        sb_append(sb, "        buffer.position(payload.position());\n");
+    }
+    sb_append(sb, "        return sample;\n");
+    sb_append(sb, "    }\n\n");
+    return 0;
+}
+
+/*
+ * Long codec methods are split so that HotSpot keeps compiling them: methods
+ * over 8000 bytes of bytecode (HugeMethodLimit) are left to the interpreter,
+ * and hot callees are only inlined up to 325 bytes (FreqInlineSize). Member
+ * code is rendered one member at a time and its bytecode estimated; once a
+ * method's members exceed SPLIT_METHOD_SIZE, the method calls private helpers
+ * holding at most SPLIT_PART_SIZE each, in member order. The margin below
+ * HugeMethodLimit absorbs the error of the estimate.
+ */
+#define SPLIT_METHOD_SIZE 2000
+#define SPLIT_PART_SIZE 325
+
+/* Code of one member, with the member id for dispatch */
+typedef struct member_chunk {
+    string_builder_t *sb;
+    uint32_t id;
+} member_chunk_t;
+
+/* Per-member code of one codec method, and the helpers it was split into */
+typedef struct member_code {
+    member_chunk_t *chunks;
+    size_t count;
+    size_t capacity;
+    string_builder_t *parts;
+} member_code_t;
+
+/*
+ * Helpers a split method delegates to, numbered from 0. The caller runs
+ * `<assign><name>N(<args>);` for each part. With dispatch set, the members
+ * are cases of a switch on `id`: the caller's switch keeps their labels and
+ * hands each group to the part that decodes it.
+ */
+typedef struct method_parts {
+    const char *name;
+    const char *result;
+    const char *params;
+    const char *args;
+    const char *assign;
+    const char *prologue;
+    const char *epilogue;
+    bool dispatch;
+} method_parts_t;
+
+static void member_code_free(member_code_t *code) {
+    for (size_t i = 0; i < code->count; i++) {
+        sb_destroy(code->chunks[i].sb);
+    }
+    free(code->chunks);
+    if (code->parts) sb_destroy(code->parts);
+    memset(code, 0, sizeof(*code));
+}
+
+/* Start the code of the next member, the codec emits into it; frees the code if out of memory */
+static string_builder_t *member_code_next(member_code_t *code, java_codec_t *codec, uint32_t id) {
+    if (code->count == code->capacity) {
+        size_t capacity = code->capacity ? 2 * code->capacity : 16;
+        member_chunk_t *chunks = realloc(code->chunks, capacity * sizeof(*chunks));
+        if (!chunks) {
+            member_code_free(code);
+            return NULL;
+        }
+        code->chunks = chunks;
+        code->capacity = capacity;
+    }
+    string_builder_t *chunk = sb_create();
+    if (!chunk) {
+        member_code_free(code);
+        return NULL;
+    }
+    code->chunks[code->count].sb = chunk;
+    code->chunks[code->count].id = id;
+    code->count++;
+    if (codec) codec->sb = chunk;
+    return chunk;
+}
+
+static bool member_code_split(const member_code_t *code) {
+    uint32_t size = 0;
+    for (size_t i = 0; i < code->count; i++) {
+        size += codec_bytecode_size(sb_string(code->chunks[i].sb));
+    }
+    return size > SPLIT_METHOD_SIZE;
+}
+
+/* Append code with `dedent` leading spaces removed from every line */
+static void append_dedented(string_builder_t *sb, const char *code, int dedent) {
+    while (*code) {
+        for (int i = 0; i < dedent && *code == ' '; i++) code++;
+        const char *end = strchr(code, '\n');
+        size_t len = end ? (size_t)(end - code) + 1 : strlen(code);
+        sb_appendf(sb, "%.*s", (int)len, code);
+        code += len;
+    }
+}
+
+/* Emit part `index` holding chunks [first, last) and the caller's use of it */
+static void emit_method_part(string_builder_t *sb, const member_code_t *code, const method_parts_t *shape,
+                             int dedent, size_t index, size_t first, size_t last) {
+    if (shape->dispatch) {
+        for (size_t i = first; i < last; i++) {
+            sb_appendf(sb, "                case %u:\n", code->chunks[i].id);
+        }
+        sb_appendf(sb, "                    %s%zu(%s);\n", shape->name, index, shape->args);
+        sb_append(sb, "                    break;\n");
+    } else {
+        sb_appendf(sb, "        %s%s%zu(%s);\n", shape->assign ? shape->assign : "", shape->name, index, shape->args);
+    }
+
+    sb_appendf(code->parts, "    private %s %s%zu(%s) {\n", shape->result, shape->name, index, shape->params);
+    if (shape->prologue) sb_append(code->parts, shape->prologue);
+    for (size_t i = first; i < last; i++) {
+        append_dedented(code->parts, sb_string(code->chunks[i].sb), dedent);
+    }
+    if (shape->epilogue) sb_append(code->parts, shape->epilogue);
+    sb_append(code->parts, "    }\n\n");
+}
+
+/*
+ * Emit the member code of a method: inline into sb, or, once it is too long,
+ * as calls into sb and helper methods kept for close_member_method().
+ * `dedent` shifts dispatch cases from the caller's nesting to that of a
+ * helper. Frees the code and returns -1 if out of memory.
+ */
+static int emit_member_code(string_builder_t *sb, member_code_t *code, const method_parts_t *shape, int dedent) {
+    if (!member_code_split(code)) {
+        for (size_t i = 0; i < code->count; i++) {
+            sb_append(sb, sb_string(code->chunks[i].sb));
+        }
+        return 0;
+    }
+
+    code->parts = sb_create();
+    if (!code->parts) {
+        member_code_free(code);
+        return -1;
+    }
+
+    size_t part = 0, first = 0;
+    uint32_t part_size = 0;
+    for (size_t i = 0; i < code->count; i++) {
+        uint32_t size = codec_bytecode_size(sb_string(code->chunks[i].sb));
+        if (part_size > 0 && part_size + size > SPLIT_PART_SIZE) {
+            emit_method_part(sb, code, shape, dedent, part++, first, i);
+            first = i;
+            part_size = 0;
+        }
+        part_size += size;
+    }
+    if (first < code->count) {
+        emit_method_part(sb, code, shape, dedent, part, first, code->count);
+    }
+    return 0;
+}
+
+/* Close the method the member code went into, followed by its helpers */
+static void close_member_method(string_builder_t *sb, member_code_t *code) {
+    sb_append(sb, "    }\n\n");
+    if (code->parts) sb_append(sb, sb_string(code->parts));
+    member_code_free(code);
+}
+
+/*
+ * Codec for fixed-size structs: every member has a constant offset, so
+ * writeAt()/readAt() are straight-line absolute puts and gets with no
+ * position bookkeeping, and serializeInto()/deserializeFrom() only move the
+ * cursor once by SERIALIZED_SIZE. In the XCDR formats the struct is first
+ * aligned to its largest member; offsets are relative to that point.
+ */
+static int generate_fixed_codec(string_builder_t *sb, const java_struct_ir_t *ir, java_codec_t *codec) {
+    const idl_struct_t *struct_def = ir->struct_def;
+    const cdr_layout_t *layout = &ir->layout;
+    bool encapsulated = codec->format != JAVA_CDR_PACKED;
+    uint32_t padding = (4 - (layout->size & 3)) & 3;
+
+    sb_append(sb, "    public int getSerializedSize() {\n");
+    if (encapsulated) {
+        sb_appendf(sb, "        return %u;\n", 4 + layout->size + padding);
+    } else {
+        sb_append(sb, "        return SERIALIZED_SIZE;\n");
+    }
+    sb_append(sb, "    }\n\n");
+
     sb_append(sb, "    public byte[] serialize() {\n");
-    sb_append(sb, "        ByteBuffer buffer = ByteBuffer.allocate(256);\n");
-    sb_append(sb, "        buffer.order(ByteOrder.LITTLE_ENDIAN);\n\n");
-    
-    for (const idl_member_t *member = struct_def->members; member; ) {
-        const char *name = get_member_name(member);
-        // Resolve typedef to get the underlying type for serialization
-        idl_type_t type = resolve_typedef_type(member->type_spec);
-        
-        switch (type) {
-            case IDL_BOOL:
-            case IDL_OCTET:
-            case IDL_CHAR:
-                sb_appendf(sb, "        buffer.put(%s);\n", name);
-                break;
-            case IDL_SHORT:
-            case IDL_USHORT:
-                sb_appendf(sb, "        buffer.putShort(%s);\n", name);
-                break;
-            case IDL_LONG:
-            case IDL_ULONG:
-                sb_appendf(sb, "        buffer.putInt(%s);\n", name);
-                break;
-            case IDL_LLONG:
-            case IDL_ULLONG:
-                sb_appendf(sb, "        buffer.putLong(%s);\n", name);
-                break;
-            case IDL_FLOAT:
-                sb_appendf(sb, "        buffer.putFloat(%s);\n", name);
-                break;
-            case IDL_DOUBLE:
-                sb_appendf(sb, "        buffer.putDouble(%s);\n", name);
-                break;
-            case IDL_STRING:
-                sb_appendf(sb, "        if (%s != null) {\n", name);
-                sb_appendf(sb, "            byte[] bytes = %s.getBytes(StandardCharsets.UTF_8);\n", name);
-                sb_append(sb, "            buffer.putInt(bytes.length);\n");
-                sb_append(sb, "            buffer.put(bytes);\n");
-                sb_append(sb, "        } else {\n");
-                sb_append(sb, "            buffer.putInt(-1);\n");
-                sb_append(sb, "        }\n");
-                break;
-            case IDL_SEQUENCE: {
-                const idl_sequence_t *seq = (const idl_sequence_t *)member->type_spec;
-                char *elem_type = java_type_name(seq->type_spec, true);
-                idl_type_t elem_idl_type = resolve_typedef_type(seq->type_spec);
-                sb_appendf(sb, "        if (%s != null) {\n", name);
-                sb_appendf(sb, "            buffer.putInt(%s.size());\n", name);
-                sb_appendf(sb, "            for (%s elem : %s) {\n", elem_type, name);
-                // Serialize based on element type
-                switch (elem_idl_type) {
-                    case IDL_BOOL:
-                    case IDL_OCTET:
-                    case IDL_CHAR:
-                        sb_append(sb, "                buffer.put(elem);\n");
-                        break;
-                    case IDL_SHORT:
-                    case IDL_USHORT:
-                        sb_append(sb, "                buffer.putShort(elem);\n");
-                        break;
-                    case IDL_LONG:
-                    case IDL_ULONG:
-                        sb_append(sb, "                buffer.putInt(elem);\n");
-                        break;
-                    case IDL_LLONG:
-                    case IDL_ULLONG:
-                        sb_append(sb, "                buffer.putLong(elem);\n");
-                        break;
-                    case IDL_FLOAT:
-                        sb_append(sb, "                buffer.putFloat(elem);\n");
-                        break;
-                    case IDL_DOUBLE:
-                        sb_append(sb, "                buffer.putDouble(elem);\n");
-                        break;
-                    case IDL_STRING:
-                        sb_append(sb, "                if (elem != null) {\n");
-                        sb_append(sb, "                    byte[] elemBytes = elem.getBytes(StandardCharsets.UTF_8);\n");
-                        sb_append(sb, "                    buffer.putInt(elemBytes.length);\n");
-                        sb_append(sb, "                    buffer.put(elemBytes);\n");
-                        sb_append(sb, "                } else {\n");
-                        sb_append(sb, "                    buffer.putInt(-1);\n");
-                        sb_append(sb, "                }\n");
-                        break;
-                    case IDL_STRUCT:
-                        sb_append(sb, "                if (elem != null) {\n");
-                        sb_append(sb, "                    buffer.put(elem.serialize());\n");
-                        sb_append(sb, "                }\n");
-                        break;
-                    case IDL_ENUM:
-                        sb_append(sb, "                buffer.putInt(elem.getValue());\n");
-                        break;
-                    case IDL_UNION:
-                        sb_append(sb, "                if (elem != null) {\n");
-                        sb_append(sb, "                    buffer.put(elem.serialize());\n");
-                        sb_append(sb, "                }\n");
-                        break;
-                    case IDL_BITMASK:
-                        sb_append(sb, "                buffer.putLong(elem.getValue());\n");
-                        break;
-                    case IDL_WSTRING:
-                        sb_append(sb, "                if (elem != null) {\n");
-                        sb_append(sb, "                    byte[] elemBytes = elem.getBytes(java.nio.charset.StandardCharsets.UTF_8);\n");
-                        sb_append(sb, "                    buffer.putInt(elemBytes.length);\n");
-                        sb_append(sb, "                    buffer.put(elemBytes);\n");
-                        sb_append(sb, "                } else {\n");
-                        sb_append(sb, "                    buffer.putInt(-1);\n");
-                        sb_append(sb, "                }\n");
-                        break;
-                    default:
-                        sb_appendf(sb, "                // TODO: serialize %s element\n", elem_type);
-                        break;
-                }
-                sb_append(sb, "            }\n");
-                sb_append(sb, "        } else {\n");
-                sb_append(sb, "            buffer.putInt(-1);\n");
-                sb_append(sb, "        }\n");
-                free(elem_type);
-                break;
-            }
-            case IDL_STRUCT:
-                sb_appendf(sb, "        if (%s != null) {\n", name);
-                sb_appendf(sb, "            buffer.put(%s.serialize());\n", name);
-                sb_append(sb, "        }\n");
-                break;
-            case IDL_UNION:
-                sb_appendf(sb, "        if (%s != null) {\n", name);
-                sb_appendf(sb, "            buffer.put(%s.serialize());\n", name);
-                sb_append(sb, "        }\n");
-                break;
-            case IDL_ENUM:
-                sb_appendf(sb, "        buffer.putInt(%s.getValue());\n", name);
-                break;
-            default:
-                // Unknown type - skip for now
-                break;
-        }
-        
-        idl_node_t *next_node = (idl_node_t *)member;
-        if (!next_node->next) break;
-        member = (const idl_member_t *)next_node->next;
-    }
-    
-    sb_append(sb, "\n        byte[] result = new byte[buffer.position()];\n");
-    sb_append(sb, "        buffer.flip();\n");
-    sb_append(sb, "        buffer.get(result);\n");
-    sb_append(sb, "        return result;\n");
+    if (encapsulated) {
+        sb_append(sb, "        ByteBuffer buffer = ByteBuffer.allocate(getSerializedSize());\n");
+        sb_appendf(sb, "        buffer.putShort((short) 0x%04x);\n", encapsulation_id(struct_def->extensibility.value, codec->format));
+        sb_appendf(sb, "        buffer.putShort((short) %u);\n", padding);
+        sb_append(sb, "        buffer.order(ByteOrder.LITTLE_ENDIAN);\n");
+        sb_append(sb, "        writeAt(buffer, 4);\n");
+    } else {
+        sb_append(sb, "        ByteBuffer buffer = ByteBuffer.allocate(SERIALIZED_SIZE);\n");
+        sb_append(sb, "        buffer.order(ByteOrder.LITTLE_ENDIAN);\n");
+        sb_append(sb, "        writeAt(buffer, 0);\n");
+    }
+    sb_append(sb, "        return buffer.array();\n");
+    sb_append(sb, "    }\n\n");
+
+    if (encapsulated) {
+        sb_append(sb, "    public int serializedEnd(int pos) {\n");
+        if (layout->align > 1) {
+            sb_appendf(sb, "        return ((pos + %u) & ~%u) + SERIALIZED_SIZE;\n", layout->align - 1, layout->align - 1);
+        } else {
+            sb_append(sb, "        return pos + SERIALIZED_SIZE;\n");
+        }
+        sb_append(sb, "    }\n\n");
+    }
+
+    sb_append(sb, "    public void serializeInto(ByteBuffer buffer) {\n");
+    codec->known_align = 1;
+    codec_write_align(codec, 8, layout->align);
+    sb_append(sb, "        int offset = buffer.position();\n");
+    sb_append(sb, "        writeAt(buffer, offset);\n");
+    sb_append(sb, "        buffer.position(offset + SERIALIZED_SIZE);\n");
+    sb_append(sb, "    }\n\n");
+
+    static const method_parts_t write_parts = {
+        "writeAtPart", "void", "ByteBuffer buffer, int offset", "buffer, offset", NULL, NULL, NULL, false
+    };
+    static const method_parts_t read_parts = {
+        "readAtPart", "void", "ByteBuffer buffer, int offset", "buffer, offset", NULL, NULL, NULL, false
+    };
+    member_code_t code = {0};
+
+    for (size_t i = 0; i < ir->count; i++) {
+        char at[32];
+        string_builder_t *chunk = member_code_next(&code, NULL, 0);
+        if (!chunk) return -1;
+        generate_fixed_member_write(chunk, &ir->members[i], offset_expr(at, sizeof(at), ir->members[i].offset));
+    }
+    sb_append(sb, "    public void writeAt(ByteBuffer buffer, int offset) {\n");
+    if (emit_member_code(sb, &code, &write_parts, 0) != 0) return -1;
+    close_member_method(sb, &code);
+
+    sb_append(sb, "    public void deserialize(byte[] data) {\n");
+    sb_append(sb, "        ByteBuffer buffer = ByteBuffer.wrap(data);\n");
+    if (encapsulated) {
+        sb_append(sb, "        buffer.order((data[1] & 1) != 0 ? ByteOrder.LITTLE_ENDIAN : ByteOrder.BIG_ENDIAN);\n");
+        sb_append(sb, "        readAt(buffer, 4);\n");
+    } else {
+        sb_append(sb, "        buffer.order(ByteOrder.LITTLE_ENDIAN);\n");
+        sb_append(sb, "        readAt(buffer, 0);\n");
+    }
     sb_append(sb, "    }\n\n");
+    generate_reuse_deserialize(sb, struct_def->name->identifier, encapsulated);
+
+    sb_append(sb, "    public void deserializeFrom(ByteBuffer buffer) {\n");
+    codec->known_align = 1;
+    codec_read_align(codec, 8, layout->align);
+    sb_append(sb, "        int offset = buffer.position();\n");
+    sb_append(sb, "        readAt(buffer, offset);\n");
+    sb_append(sb, "        buffer.position(offset + SERIALIZED_SIZE);\n");
+    sb_append(sb, "    }\n\n");
+
+    for (size_t i = 0; i < ir->count; i++) {
+        char at[32];
+        string_builder_t *chunk = member_code_next(&code, NULL, 0);
+        if (!chunk) return -1;
+        generate_fixed_member_read(chunk, &ir->members[i], offset_expr(at, sizeof(at), ir->members[i].offset));
+    }
+    sb_append(sb, "    public void readAt(ByteBuffer buffer, int offset) {\n");
+    if (emit_member_code(sb, &code, &read_parts, 0) != 0) return -1;
+    close_member_method(sb, &code);
     return 0;
 }
 
-static int generate_deserialize_method(string_builder_t *sb, const idl_struct_t *struct_def) {
+static int generate_serialize_method(string_builder_t *sb) {
+    sb_append(sb, "    public byte[] serialize() {\n");
+    sb_append(sb, "        ByteBuffer buffer = ByteBuffer.allocate(getSerializedSize());\n");
+    sb_append(sb, "        buffer.order(ByteOrder.LITTLE_ENDIAN);\n");
+    sb_append(sb, "        serializeInto(buffer);\n");
+    sb_append(sb, "        return buffer.array();\n");
+    sb_append(sb, "    }\n\n");
+    return 0;
+}
+
+static int generate_deserialize_method(string_builder_t *sb, const char *name) {
     sb_append(sb, "    public void deserialize(byte[] data) {\n");
     sb_append(sb, "        ByteBuffer buffer = ByteBuffer.wrap(data);\n");
-    sb_append(sb, "        buffer.order(ByteOrder.LITTLE_ENDIAN);\n\n");
-
-    for (const idl_member_t *member = struct_def->members; member; ) {
-        const char *name = get_member_name(member);
-        // Resolve typedef to get the underlying type for deserialization
-        idl_type_t type = resolve_typedef_type(member->type_spec);
-
-        switch (type) {
-            case IDL_BOOL:
-            case IDL_OCTET:
-            case IDL_CHAR:
-                sb_appendf(sb, "        %s = buffer.get();\n", name);
-                break;
-            case IDL_SHORT:
-            case IDL_USHORT:
-                sb_appendf(sb, "        %s = buffer.getShort();\n", name);
-                break;
-            case IDL_LONG:
-            case IDL_ULONG:
-                sb_appendf(sb, "        %s = buffer.getInt();\n", name);
-                break;
-            case IDL_LLONG:
-            case IDL_ULLONG:
-                sb_appendf(sb, "        %s = buffer.getLong();\n", name);
-                break;
-            case IDL_FLOAT:
-                sb_appendf(sb, "        %s = buffer.getFloat();\n", name);
-                break;
-            case IDL_DOUBLE:
-                sb_appendf(sb, "        %s = buffer.getDouble();\n", name);
-                break;
-            case IDL_STRING:
-                sb_append(sb, "        {\n");
-                sb_append(sb, "            int len = buffer.getInt();\n");
-                sb_append(sb, "            if (len > 0) {\n");
-                sb_appendf(sb, "                %s = new String(buffer.array(), buffer.position(), len, StandardCharsets.UTF_8);\n", name);
-                sb_append(sb, "                buffer.position(buffer.position() + len);\n");
-                sb_append(sb, "            } else {\n");
-                sb_appendf(sb, "                %s = null;\n", name);
-                sb_append(sb, "            }\n");
-                sb_append(sb, "        }\n");
-                break;
-            case IDL_SEQUENCE: {
-                const idl_sequence_t *seq = (const idl_sequence_t *)member->type_spec;
-                char *elem_type = java_type_name(seq->type_spec, true);
-                idl_type_t elem_idl_type = resolve_typedef_type(seq->type_spec);
-                sb_append(sb, "        {\n");
-                sb_append(sb, "            int len = buffer.getInt();\n");
-                sb_appendf(sb, "            %s = new java.util.ArrayList<>();\n", name);
-                sb_append(sb, "            for (int i = 0; i < len; i++) {\n");
-                // Deserialize based on element type
-                switch (elem_idl_type) {
-                    case IDL_BOOL:
-                    case IDL_OCTET:
-                    case IDL_CHAR:
-                        sb_appendf(sb, "                %s.add(buffer.get());\n", name);
-                        break;
-                    case IDL_SHORT:
-                    case IDL_USHORT:
-                        sb_appendf(sb, "                %s.add(buffer.getShort());\n", name);
-                        break;
-                    case IDL_LONG:
-                    case IDL_ULONG:
-                        sb_appendf(sb, "                %s.add(buffer.getInt());\n", name);
-                        break;
-                    case IDL_LLONG:
-                    case IDL_ULLONG:
-                        sb_appendf(sb, "                %s.add(buffer.getLong());\n", name);
-                        break;
-                    case IDL_FLOAT:
-                        sb_appendf(sb, "                %s.add(buffer.getFloat());\n", name);
-                        break;
-                    case IDL_DOUBLE:
-                        sb_appendf(sb, "                %s.add(buffer.getDouble());\n", name);
-                        break;
-                    case IDL_STRING:
-                        sb_appendf(sb, "                int elemLen = buffer.getInt();\n");
-                        sb_appendf(sb, "                if (elemLen > 0) {\n");
-                        sb_appendf(sb, "                    String elemStr = new String(buffer.array(), buffer.position(), elemLen, StandardCharsets.UTF_8);\n");
-                        sb_appendf(sb, "                    buffer.position(buffer.position() + elemLen);\n");
-                        sb_appendf(sb, "                    %s.add(elemStr);\n");
-                        sb_appendf(sb, "                } else {\n");
-                        sb_appendf(sb, "                    %s.add(null);\n");
-                        sb_appendf(sb, "                }\n");
-                        break;
-                    case IDL_STRUCT: {
-                        char *boxed_elem = java_type_name(seq->type_spec, true);
-                        sb_appendf(sb, "                %s elem = new %s();\n", boxed_elem, boxed_elem);
-                        sb_appendf(sb, "                byte[] elemData = new byte[buffer.remaining()];\n");
-                        sb_appendf(sb, "                buffer.get(elemData);\n");
-                        sb_appendf(sb, "                elem.deserialize(elemData);\n");
-                        sb_appendf(sb, "                %s.add(elem);\n", name);
-                        free(boxed_elem);
-                        break;
-                    }
-                    case IDL_ENUM: {
-                        sb_appendf(sb, "                int enumVal = buffer.getInt();\n");
-                        sb_appendf(sb, "                %s elemEnum = %s.valueOf(enumVal);\n", elem_type, elem_type);
-                        sb_appendf(sb, "                %s.add(elemEnum);\n", name);
-                        break;
-                    }
-                    case IDL_UNION: {
-                        char *boxed_elem = java_type_name(seq->type_spec, true);
-                        sb_appendf(sb, "                %s elem = new %s();\n", boxed_elem, boxed_elem);
-                        sb_appendf(sb, "                byte[] elemData = new byte[buffer.remaining()];\n");
-                        sb_appendf(sb, "                buffer.get(elemData);\n");
-                        sb_appendf(sb, "                elem.deserialize(elemData);\n");
-                        sb_appendf(sb, "                %s.add(elem);\n", name);
-                        free(boxed_elem);
-                        break;
-                    }
-                    case IDL_BITMASK: {
-                        sb_appendf(sb, "                long bitmaskVal = buffer.getLong();\n");
-                        sb_appendf(sb, "                %s elemMask = new %s(bitmaskVal);\n", elem_type, elem_type);
-                        sb_appendf(sb, "                %s.add(elemMask);\n", name);
-                        break;
-                    }
-                    case IDL_WSTRING: {
-                        sb_appendf(sb, "                int wstrLen = buffer.getInt();\n");
-                        sb_appendf(sb, "                if (wstrLen > 0) {\n");
-                        sb_appendf(sb, "                    byte[] wstrBytes = new byte[wstrLen];\n");
-                        sb_appendf(sb, "                    buffer.get(wstrBytes);\n");
-                        sb_appendf(sb, "                    String wstr = new String(wstrBytes, java.nio.charset.StandardCharsets.UTF_8);\n");
-                        sb_appendf(sb, "                    %s.add(wstr);\n", name);
-                        sb_appendf(sb, "                } else {\n");
-                        sb_appendf(sb, "                    %s.add(null);\n", name);
-                        sb_appendf(sb, "                }\n");
-                        break;
-                    }
-                    default:
-                        sb_appendf(sb, "                // TODO: deserialize %s element\n", elem_type);
-                        break;
-                }
-                sb_append(sb, "            }\n");
-                sb_append(sb, "        }\n");
-                free(elem_type);
-                break;
-            }
-            case IDL_STRUCT: {
-                char *struct_type = java_type_name(member->type_spec, false);
-                sb_appendf(sb, "        if (%s == null) {\n", name);
-                sb_appendf(sb, "            %s = new %s();\n", name, struct_type);
-                sb_append(sb, "        }\n");
-                sb_appendf(sb, "        byte[] %s_data = new byte[buffer.remaining()];\n", name);
-                sb_appendf(sb, "        buffer.get(%s_data);\n", name);
-                sb_appendf(sb, "        %s.deserialize(%s_data);\n", name, name);
-                free(struct_type);
-                break;
-            }
-            case IDL_UNION: {
-                char *union_type = java_type_name(member->type_spec, false);
-                sb_appendf(sb, "        if (%s == null) {\n", name);
-                sb_appendf(sb, "            %s = new %s();\n", name, union_type);
-                sb_append(sb, "        }\n");
-                sb_appendf(sb, "        byte[] %s_data = new byte[buffer.remaining()];\n", name);
-                sb_appendf(sb, "        buffer.get(%s_data);\n", name);
-                sb_appendf(sb, "        %s.deserialize(%s_data);\n", name, name);
-                free(union_type);
-                break;
-            }
-            case IDL_ENUM: {
-                char *enum_type = java_type_name(member->type_spec, false);
-                sb_appendf(sb, "        int %s_val = buffer.getInt();\n", name);
-                sb_appendf(sb, "        %s = %s.valueOf(%s_val);\n", name, enum_type, name);
-                free(enum_type);
-                break;
-            }
-            default:
-                // Unknown type - skip for now
-                break;
+    sb_append(sb, "        buffer.order(ByteOrder.LITTLE_ENDIAN);\n");
+    sb_append(sb, "        deserializeFrom(buffer);\n");
+    sb_append(sb, "    }\n\n");
+    return generate_reuse_deserialize(sb, name, false);
+}
+
+/*
+ * serialize()/deserialize() for the XCDR formats: a 4-byte encapsulation
+ * header followed by the payload, padded to a multiple of 4 with the padding
+ * count in the options field. The payload is encoded into a slice so that
+ * CDR alignment is relative to its first byte, as in the native serializers.
+ */
+static int generate_encapsulated_methods(string_builder_t *sb, const char *name, uint32_t id) {
+    sb_append(sb, "    public int getSerializedSize() {\n");
+    sb_append(sb, "        int size = serializedEnd(0);\n");
+    sb_append(sb, "        return 4 + size + (-size & 3);\n");
+    sb_append(sb, "    }\n\n");
+
+    sb_append(sb, "    public byte[] serialize() {\n");
+    sb_append(sb, "        int size = serializedEnd(0);\n");
+    sb_append(sb, "        ByteBuffer buffer = ByteBuffer.allocate(4 + size + (-size & 3));\n");
+    sb_appendf(sb, "        buffer.putShort((short) 0x%04x);\n", id);
+    sb_append(sb, "        buffer.putShort((short) (-size & 3));\n");
+    sb_append(sb, "        serializeInto(buffer.slice().order(ByteOrder.LITTLE_ENDIAN));\n");
+    sb_append(sb, "        return buffer.array();\n");
+    sb_append(sb, "    }\n\n");
+
+    sb_append(sb, "    public void deserialize(byte[] data) {\n");
+    sb_append(sb, "        ByteBuffer buffer = ByteBuffer.wrap(data, 4, data.length - 4).slice();\n");
+    sb_append(sb, "        buffer.order((data[1] & 1) != 0 ? ByteOrder.LITTLE_ENDIAN : ByteOrder.BIG_ENDIAN);\n");
+    sb_append(sb, "        deserializeFrom(buffer);\n");
+    sb_append(sb, "    }\n\n");
+    return generate_reuse_deserialize(sb, name, true);
+}
+
+/*
+ * Packed codec: getSerializedSize() starts from the constant part of the
+ * encoding, folded at generation time, and only strings, sequences and nested
+ * types add to it at runtime. serializeInto()/deserializeFrom() work at the
+ * buffer's current position, so nested structs, unions and sequence elements
+ * share the parent's buffer and cursor.
+ */
+static int generate_packed_codec(string_builder_t *sb, const java_struct_ir_t *ir, java_codec_t *codec) {
+    static const method_parts_t size_parts = {
+        "sizePart", "int", "", "", "size += ", "        int size = 0;\n", "        return size;\n", false
+    };
+    static const method_parts_t write_parts = {
+        "serializePart", "void", "ByteBuffer buffer", "buffer", NULL, NULL, NULL, false
+    };
+    static const method_parts_t read_parts = {
+        "deserializePart", "void", "ByteBuffer buffer", "buffer", NULL, NULL, NULL, false
+    };
+    member_code_t code = {0};
+
+    for (size_t i = 0; i < ir->count; i++) {
+        if (!member_code_next(&code, codec, 0)) return -1;
+        codec_emit_size(codec, ir->members[i].type_spec, ir->members[i].name, 8, 0);
+    }
+    codec->sb = sb;
+
+    sb_append(sb, "    public int getSerializedSize() {\n");
+    sb_appendf(sb, "        int size = %u;\n", codec->pending);
+    if (emit_member_code(sb, &code, &size_parts, 0) != 0) return -1;
+    sb_append(sb, "        return size;\n");
+    close_member_method(sb, &code);
+
+    generate_serialize_method(sb);
+
+    for (size_t i = 0; i < ir->count; i++) {
+        if (!member_code_next(&code, codec, 0)) return -1;
+        codec_emit_write(codec, ir->members[i].type_spec, ir->members[i].name, 8, 0);
+    }
+    codec->sb = sb;
+    sb_append(sb, "    public void serializeInto(ByteBuffer buffer) {\n");
+    if (emit_member_code(sb, &code, &write_parts, 0) != 0) return -1;
+    close_member_method(sb, &code);
+
+    generate_deserialize_method(sb, ir->struct_def->name->identifier);
+
+    for (size_t i = 0; i < ir->count; i++) {
+        if (!member_code_next(&code, codec, 0)) return -1;
+        codec_emit_read(codec, ir->members[i].type_spec, ir->members[i].name, 8, 0);
+    }
+    codec->sb = sb;
+    sb_append(sb, "    public void deserializeFrom(ByteBuffer buffer) {\n");
+    if (emit_member_code(sb, &code, &read_parts, 0) != 0) return -1;
+    close_member_method(sb, &code);
+    return 0;
+}
+
+/* EMHEADER1 of a mutable member: must-understand for keys, LC from the member type */
+static uint32_t member_emheader(const java_codec_t *codec, const java_member_ir_t *m) {
+    return (m->key ? 0x80000000u : 0) | (codec_length_code(codec, m->type_spec) << 28) | m->id;
+}
+
+/*
+ * XCDR codec. serializedEnd(pos) returns the stream offset just past this
+ * value when it starts at pos, which is what a parent needs to account for
+ * alignment. Appendable and mutable types (XCDR2 only) are wrapped in a
+ * DHEADER; mutable members additionally carry an EMHEADER (and a NEXTINT for
+ * LC 4), and are read back by member id so that unknown members are skipped.
+ */
+static int generate_xcdr_codec(string_builder_t *sb, const java_struct_ir_t *ir, java_codec_t *codec) {
+    const idl_struct_t *struct_def = ir->struct_def;
+    idl_extensibility_t extensibility = struct_def->extensibility.value;
+    bool has_dheader = codec->format == JAVA_CDR_XCDR2 && extensibility != IDL_FINAL;
+    bool is_mutable = has_dheader && extensibility == IDL_MUTABLE;
+    bool has_nextint = false;
+    for (size_t i = 0; is_mutable && i < ir->count; i++) {
+        if (codec_length_code(codec, ir->members[i].type_spec) == 4) has_nextint = true;
+    }
+    static const method_parts_t end_parts = {
+        "serializedEndPart", "int", "int pos", "pos", "pos = ", NULL, "        return pos;\n", false
+    };
+    method_parts_t write_parts = {
+        "serializePart", "void", "ByteBuffer buffer", "buffer", NULL,
+        has_nextint ? "        int memberLength;\n" : NULL, NULL, false
+    };
+    method_parts_t read_parts = {
+        "deserializePart", "void", has_dheader ? "ByteBuffer buffer, int end" : "ByteBuffer buffer",
+        has_dheader ? "buffer, end" : "buffer", NULL, NULL, NULL, false
+    };
+    if (is_mutable) {
+        read_parts.params = "ByteBuffer buffer, int id";
+        read_parts.args = "buffer, emheader & 0x0fffffff";
+        read_parts.prologue = "        switch (id) {\n";
+        read_parts.epilogue = "            default:\n                break;\n        }\n";
+        read_parts.dispatch = true;
+    }
+    member_code_t code = {0};
+
+    generate_encapsulated_methods(sb, struct_def->name->identifier, encapsulation_id(extensibility, codec->format));
+
+    sb_append(sb, "    public int serializedEnd(int pos) {\n");
+    codec->known_align = 1;
+    codec->pending = 0;
+    if (has_dheader) {
+        codec_size_align(codec, 8, 4);
+        codec_size_add(codec, 4);
+    }
+    for (size_t i = 0; i < ir->count; i++) {
+        if (!member_code_next(&code, codec, 0)) return -1;
+        if (is_mutable) {
+            codec_size_align(codec, 8, 4);
+            codec_size_add(codec, codec_length_code(codec, ir->members[i].type_spec) == 4 ? 8 : 4);
         }
-        
-        idl_node_t *next_node = (idl_node_t *)member;
-        if (!next_node->next) break;
-        member = (const idl_member_t *)next_node->next;
+        codec_emit_size(codec, ir->members[i].type_spec, ir->members[i].name, 8, 0);
     }
-    
+    codec->sb = sb;
+    if (emit_member_code(sb, &code, &end_parts, 0) != 0) return -1;
+    codec_size_flush(codec, 8);
+    sb_append(sb, "        return pos;\n");
+    close_member_method(sb, &code);
+
+    sb_append(sb, "    public void serializeInto(ByteBuffer buffer) {\n");
+    codec->known_align = 1;
+    if (has_dheader) {
+        codec_write_align(codec, 8, 4);
+        sb_append(sb, "        int dheader = CdrWriter.beginLength(buffer);\n");
+    }
+    for (size_t i = 0; i < ir->count; i++) {
+        const java_member_ir_t *m = &ir->members[i];
+        if (!member_code_next(&code, codec, 0)) return -1;
+        bool nextint = is_mutable && codec_length_code(codec, m->type_spec) == 4;
+        if (is_mutable) {
+            codec_write_align(codec, 8, 4);
+            sb_appendf(codec->sb, "        buffer.putInt(0x%08x);  // EMHEADER %s\n", member_emheader(codec, m), m->name);
+            if (nextint) sb_append(codec->sb, "        memberLength = CdrWriter.beginLength(buffer);\n");
+            codec->known_align = 4;
+        }
+        codec_emit_write(codec, m->type_spec, m->name, 8, 0);
+        if (nextint) {
+            sb_append(codec->sb, "        CdrWriter.endLength(buffer, memberLength);\n");
+        }
+    }
+    codec->sb = sb;
+    if (has_nextint && !member_code_split(&code)) {
+        sb_append(sb, "        int memberLength;\n");
+    }
+    if (emit_member_code(sb, &code, &write_parts, 0) != 0) return -1;
+    if (has_dheader) {
+        sb_append(sb, "        CdrWriter.endLength(buffer, dheader);\n");
+    }
+    close_member_method(sb, &code);
+
+    sb_append(sb, "    public void deserializeFrom(ByteBuffer buffer) {\n");
+    codec->known_align = 1;
+    if (has_dheader) {
+        codec_read_align(codec, 8, 4);
+        sb_append(sb, "        int dheader = buffer.getInt();\n");
+        sb_append(sb, "        int end = buffer.position() + dheader;\n");
+    }
+    if (is_mutable) {
+        sb_append(sb, "        while (buffer.position() < end) {\n");
+        codec->known_align = 1;
+        codec_read_align(codec, 12, 4);
+        sb_append(sb, "            int emheader = buffer.getInt();\n");
+        /* memberSize() consumes the NEXTINT of LC 4, so the member starts after it */
+        sb_append(sb, "            int memberSize = CdrReader.memberSize(buffer, emheader);\n");
+        sb_append(sb, "            int memberEnd = buffer.position() + memberSize;\n");
+    }
+    for (size_t i = 0; i < ir->count; i++) {
+        const java_member_ir_t *m = &ir->members[i];
+        const char *name = m->name;
+        uint32_t id = m->id;
+        if (!member_code_next(&code, codec, id)) return -1;
+        if (is_mutable) {
+            sb_appendf(codec->sb, "                case %u: {\n", id);
+            codec->known_align = 4;
+            codec_emit_read(codec, m->type_spec, name, 20, 0);
+            sb_append(codec->sb, "                    break;\n");
+            sb_append(codec->sb, "                }\n");
+        } else if (has_dheader) {
+            /* members appended by a newer writer are skipped, missing ones keep their value */
+            sb_append(codec->sb, "        if (buffer.position() < end) {\n");
+            codec->known_align = 1;
+            codec_emit_read(codec, m->type_spec, name, 12, 0);
+            sb_append(codec->sb, "        }\n");
+        } else {
+            codec_emit_read(codec, m->type_spec, name, 8, 0);
+        }
+    }
+    codec->sb = sb;
+    if (is_mutable) {
+        sb_append(sb, "            switch (emheader & 0x0fffffff) {\n");
+    }
+    if (emit_member_code(sb, &code, &read_parts, is_mutable ? 4 : 0) != 0) return -1;
+    if (is_mutable) {
+        sb_append(sb, "                default:\n");
+        sb_append(sb, "                    break;\n");
+        sb_append(sb, "            }\n");
+        sb_append(sb, "            buffer.position(memberEnd);\n");
+        sb_append(sb, "        }\n");
+    }
+    if (has_dheader) {
+        sb_append(sb, "        buffer.position(end);\n");
+    }
+    close_member_method(sb, &code);
+    return 0;
+}
+
+/*
+ * Key API. serializeKey() writes the key members in member id order as XCDR2
+ * without DHEADER/EMHEADERs, whatever the sample encoding, and nested structs
+ * contribute their own key (all members if they have none).
+ * computeKeyHash() derives the 16-byte DDS keyhash from the big-endian
+ * encoding: zero-padded if the key can never exceed 16 bytes, else its MD5.
+ * Only keyed structs get computeKeyHash(); every struct gets serializeKey()
+ * so that it can be used as a key member.
+ */
+static int generate_key_methods(string_builder_t *sb, const java_struct_ir_t *ir, java_codec_t *codec) {
+    codec->key_only = true;
+
+    sb_append(sb, "    public int keySerializedEnd(int pos) {\n");
+    codec->known_align = 1;
+    codec->pending = 0;
+    for (size_t i = 0; i < ir->key_count; i++) {
+        codec_emit_size(codec, ir->keys[i]->type_spec, ir->keys[i]->name, 8, 0);
+    }
+    codec_size_flush(codec, 8);
+    sb_append(sb, "        return pos;\n");
+    sb_append(sb, "    }\n\n");
+
+    sb_append(sb, "    public void serializeKey(ByteBuffer buffer) {\n");
+    codec->known_align = 1;
+    for (size_t i = 0; i < ir->key_count; i++) {
+        codec_emit_write(codec, ir->keys[i]->type_spec, ir->keys[i]->name, 8, 0);
+    }
+    sb_append(sb, "    }\n\n");
+
+    if (!ir->has_key) return 0;
+
+    sb_append(sb, "    public byte[] computeKeyHash() {\n");
+    if (cdr_key_fits(ir->struct_def, JAVA_CDR_XCDR2, 16)) {
+        sb_append(sb, "        ByteBuffer buffer = ByteBuffer.allocate(16);\n");
+        sb_append(sb, "        serializeKey(buffer);\n");
+        sb_append(sb, "        return buffer.array();\n");
+    } else {
+        sb_append(sb, "        ByteBuffer buffer = ByteBuffer.allocate(keySerializedEnd(0));\n");
+        sb_append(sb, "        serializeKey(buffer);\n");
+        sb_append(sb, "        try {\n");
+        sb_append(sb, "            return java.security.MessageDigest.getInstance(\"MD5\").digest(buffer.array());\n");
+        sb_append(sb, "        } catch (java.security.NoSuchAlgorithmException e) {\n");
+        sb_append(sb, "            throw new IllegalStateException(e);\n");
+        sb_append(sb, "        }\n");
+    }
+    sb_append(sb, "    }\n\n");
+    return 0;
+}
+
+/*
+ * keyHashCode()/keyEquals() look only at the key members, unlike the
+ * content-based equals()/hashCode() inherited from Structure. Like
+ * serializeKey(), a struct without @key members compares all of them.
+ */
+static int generate_key_equality(string_builder_t *sb, const java_struct_ir_t *ir, const char *class_name, bool use_arrays) {
+    sb_append(sb, "    public int keyHashCode() {\n");
+    sb_append(sb, "        int h = 1;\n");
+    for (size_t i = 0; i < ir->key_count; i++) {
+        char *hash = java_key_hash_expr(ir->keys[i]->type_spec, ir->keys[i]->name, use_arrays);
+        sb_appendf(sb, "        h = 31 * h + %s;\n", hash);
+        free(hash);
+    }
+    sb_append(sb, "        return h;\n");
+    sb_append(sb, "    }\n\n");
+
+    sb_appendf(sb, "    public boolean keyEquals(%s other) {\n", class_name);
+    sb_append(sb, "        return other != null");
+    for (size_t i = 0; i < ir->key_count; i++) {
+        const char *name = ir->keys[i]->name;
+        char other[256];
+        snprintf(other, sizeof(other), "other.%s", name);
+        char *equals = java_key_equals_expr(ir->keys[i]->type_spec, name, other, use_arrays);
+        sb_appendf(sb, "\n            && %s", equals);
+        free(equals);
+    }
+    sb_append(sb, ";\n");
+    sb_append(sb, "    }\n\n");
+    return 0;
+}
+
+/*
+ * A union's pair compares the discriminator and every branch: the setters
+ * and deserializeFrom() reset the inactive branches to their defaults.
+ */
+static int generate_union_key_equality(string_builder_t *sb, const idl_union_t *union_def, const char *union_name, const char *discrim_type) {
+    const char *boxed = strcmp(discrim_type, "byte") == 0 ? "Byte" : strcmp(discrim_type, "short") == 0 ? "Short"
+                      : strcmp(discrim_type, "long") == 0 ? "Long" : "Integer";
+    sb_append(sb, "    public int keyHashCode() {\n");
+    sb_appendf(sb, "        int h = 31 + %s.hashCode(_d);\n", boxed);
+    for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
+        if (!case_def->declarator || !case_def->declarator->name) continue;
+        char *hash = java_key_hash_expr(case_def->type_spec, case_def->declarator->name->identifier, false);
+        sb_appendf(sb, "        h = 31 * h + %s;\n", hash);
+        free(hash);
+    }
+    sb_append(sb, "        return h;\n");
+    sb_append(sb, "    }\n\n");
+
+    sb_appendf(sb, "    public boolean keyEquals(%s other) {\n", union_name);
+    sb_append(sb, "        return other != null\n");
+    sb_append(sb, "            && _d == other._d");
+    for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
+        if (!case_def->declarator || !case_def->declarator->name) continue;
+        const char *name = case_def->declarator->name->identifier;
+        char other[256];
+        snprintf(other, sizeof(other), "other.%s", name);
+        char *equals = java_key_equals_expr(case_def->type_spec, name, other, false);
+        sb_appendf(sb, "\n            && %s", equals);
+        free(equals);
+    }
+    sb_append(sb, ";\n");
     sb_append(sb, "    }\n\n");
     return 0;
 }
 
-static int generate_to_string(string_builder_t *sb, const idl_struct_t *struct_def, const char *class_name) {
+/*
+ * The XCDR codecs have no presence flags for @optional members and no
+ * Java field for the elements of an array; rather than put a stream on
+ * the wire that the C serializer would misread, such types fail.
+ */
+static bool xcdr_members_supported(const java_struct_ir_t *ir, const char *class_name) {
+    for (size_t i = 0; i < ir->count; i++) {
+        const java_member_ir_t *m = &ir->members[i];
+        if (m->optional) {
+            fprintf(stderr, "  Error: optional member %s.%s is not supported by the XCDR codec\n", class_name, m->name);
+            return false;
+        }
+        if ((m->member->declarators && idl_is_array(m->member->declarators)) || !codec_type_encodable(m->type_spec)) {
+            fprintf(stderr, "  Error: array member %s.%s is not supported by the XCDR codec\n", class_name, m->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool xcdr_cases_supported(const idl_union_t *union_def, const char *union_name) {
+    for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
+        if ((case_def->declarator && idl_is_array(case_def->declarator)) || !codec_type_encodable(case_def->type_spec)) {
+            fprintf(stderr, "  Error: array case %s.%s is not supported by the XCDR codec\n", union_name,
+                    case_def->declarator && case_def->declarator->name ? case_def->declarator->name->identifier : "case");
+            return false;
+        }
+    }
+    return true;
+}
+
+static int generate_to_string(string_builder_t *sb, const java_struct_ir_t *ir, const char *class_name) {
     sb_append(sb, "    @Override\n");
     sb_append(sb, "    public String toString() {\n");
     sb_appendf(sb, "        return \"%s[\" +\n", class_name);
     
-    int field_count = 0;
-    for (const idl_member_t *member = struct_def->members; member; ) {
-        const char *name = get_member_name(member);
-        if (field_count > 0) {
+    for (size_t i = 0; i < ir->count; i++) {
+        const char *name = ir->members[i].name;
+        if (i > 0) {
             sb_append(sb, " +\n");
             sb_appendf(sb, "            \", %s=\" + %s", name, name);
         } else {
             sb_appendf(sb, "            \"%s=\" + %s", name, name);
         }
-        field_count++;
-        idl_node_t *next_node = (idl_node_t *)member;
-        if (!next_node->next) break;
-        member = (const idl_member_t *)next_node->next;
     }
     
     sb_append(sb, " +\n            \"]\";\n");
@@ -486,29 +966,69 @@ static int generate_to_string(string_builder_t *sb, const idl_struct_t *struct_d
     return 0;
 }
 
-int generate_java_record(const idl_struct_t *struct_def, const char *output_dir, const char *prefix, bool disable_cdr, const char *class_name) {
-    if (!struct_def || !output_dir) return -1;
+int generate_java_record(const idl_struct_t *struct_def, const java_generator_config_t *config, const char *class_name) {
+    if (!struct_def || !config || !config->output_dir) return -1;
     
+    const char *output_dir = config->output_dir;
     const char *actual_class_name = class_name ? class_name : "GeneratedStruct";
-    char *package = resolve_package((const idl_node_t *)struct_def, prefix);
+    java_cdr_format_t format = config->cdr_format;
+
+    if (!config->disable_cdr && format == JAVA_CDR_XCDR1 && struct_def->extensibility.value == IDL_MUTABLE) {
+        fprintf(stderr, "  Error: mutable struct %s cannot be encoded as XCDR1, use -f java-cdr=xcdr2\n", actual_class_name);
+        return -1;
+    }
+
+    java_struct_ir_t *ir = java_struct_ir_build(struct_def, format, config->use_arrays_for_sequences);
+    if (ir && !config->disable_cdr && format != JAVA_CDR_PACKED && !xcdr_members_supported(ir, actual_class_name)) {
+        return -1;
+    }
+    const char *package = resolve_package((const idl_node_t *)struct_def, config->package_prefix);
     
-    string_builder_t *sb = sb_create();
+    string_builder_t *sb = ir ? sb_create() : NULL;
     if (!sb) {
-        free(package);
         return -1;
     }
     
-    generate_structure_header(sb, package, actual_class_name);
-    generate_field_order(sb, struct_def);
-    generate_structure_fields(sb, struct_def);
-    generate_describe_type(sb, struct_def, actual_class_name);
+    generate_structure_header(sb, package, actual_class_name, config->generate_records, !config->disable_cdr);
+    if (!config->generate_records) {
+        generate_field_order(sb, ir);
+    }
+    generate_structure_fields(sb, ir);
+    
+    if (!config->disable_cdr) {
+        generate_fixed_size_constants(sb, &ir->layout);
+    }
     
-    if (!disable_cdr) {
-        generate_serialize_method(sb, struct_def, actual_class_name);
-        generate_deserialize_method(sb, struct_def);
+    generate_type_objects(sb, struct_def, actual_class_name);
+    generate_describe_type(sb, ir, actual_class_name);
+    
+    if (!config->disable_cdr) {
+        java_codec_t codec;
+        codec_init(&codec, sb, format, config->use_arrays_for_sequences);
+        int status;
+        if (ir->layout.fixed) {
+            status = generate_fixed_codec(sb, ir, &codec);
+        } else if (format == JAVA_CDR_PACKED) {
+            status = generate_packed_codec(sb, ir, &codec);
+        } else {
+            status = generate_xcdr_codec(sb, ir, &codec);
+        }
+        if (status != 0) {
+            fprintf(stderr, "  Error: out of memory generating the codec of %s\n", actual_class_name);
+            sb_destroy(sb);
+            return -1;
+        }
+        if (cdr_key_supported(struct_def)) {
+            java_codec_t key_codec;
+            codec_init(&key_codec, sb, JAVA_CDR_XCDR2, config->use_arrays_for_sequences);
+            generate_key_methods(sb, ir, &key_codec);
+        } else if (ir->has_key) {
+            fprintf(stderr, "  Warning: union key members are not supported, no key API for %s\n", actual_class_name);
+        }
     }
     
-    generate_to_string(sb, struct_def, actual_class_name);
+    generate_key_equality(sb, ir, actual_class_name, config->use_arrays_for_sequences);
+    generate_to_string(sb, ir, actual_class_name);
     sb_append(sb, "}\n");
     
     // Create directory structure
@@ -530,52 +1050,154 @@ int generate_java_record(const idl_struct_t *struct_def, const char *output_dir,
     // Write file
     char file_path[768];
     snprintf(file_path, sizeof(file_path), "%s/%s.java", package_path, actual_class_name);
-    FILE *f = fopen(file_path, "w");
-    if (f) {
-        fputs(sb_string(sb), f);
-        fclose(f);
-        printf("  Created: %s\n", file_path);
-    } else {
-        fprintf(stderr, "  Error: Could not create file: %s\n", file_path);
-        free(package);
+    if (java_write_file(file_path, sb) != 0) {
         sb_destroy(sb);
         return -1;
     }
     
-    free(package);
     sb_destroy(sb);
     return 0;
 }
 
-int generate_java_enum(const idl_enum_t *enum_def, const char *output_dir, const char *prefix, const char *enum_name) {
-    if (!enum_def || !output_dir) return -1;
+/* Zero padding in front of a standalone enum or bitmask value in the XCDR formats */
+static void generate_value_padding(string_builder_t *sb, uint32_t width, java_cdr_format_t format) {
+    uint32_t max_align = cdr_max_align(format);
+    uint32_t align = width < max_align ? width : max_align;
+    if (align <= 1) return;
+    sb_appendf(sb, "        while ((buffer.position() & %u) != 0) {\n", align - 1);
+    sb_append(sb, "            buffer.put((byte) 0);\n");
+    sb_append(sb, "        }\n");
+}
+
+static const char *enumerator_name(const idl_enumerator_t *enumerator) {
+    if (enumerator->name && enumerator->name->identifier) {
+        return enumerator->name->identifier;
+    }
+    return "VALUE";
+}
+
+static int compare_enumerator_values(const void *a, const void *b) {
+    int32_t va = (int32_t)(*(const idl_enumerator_t *const *)a)->value.value;
+    int32_t vb = (int32_t)(*(const idl_enumerator_t *const *)b)->value.value;
+    return va < vb ? -1 : va > vb ? 1 : 0;
+}
+
+/* Enumerators ordered by @value. Caller frees the array. */
+static const idl_enumerator_t **sorted_enumerators(const idl_enum_t *enum_def, size_t count) {
+    const idl_enumerator_t **sorted = malloc((count ? count : 1) * sizeof(*sorted));
+    if (!sorted) return NULL;
+    size_t i = 0;
+    for (const idl_enumerator_t *enumerator = enum_def->enumerators; enumerator && i < count;
+         enumerator = (const idl_enumerator_t *)((idl_node_t *)enumerator)->next) {
+        sorted[i++] = enumerator;
+    }
+    qsort(sorted, count, sizeof(*sorted), compare_enumerator_values);
+    return sorted;
+}
+
+static bool enum_in_value_order(const idl_enum_t *enum_def) {
+    const idl_enumerator_t *prev = NULL;
+    for (const idl_enumerator_t *enumerator = enum_def->enumerators; enumerator;
+         enumerator = (const idl_enumerator_t *)((idl_node_t *)enumerator)->next) {
+        if (prev && (int32_t)prev->value.value >= (int32_t)enumerator->value.value) return false;
+        prev = enumerator;
+    }
+    return true;
+}
+
+static bool enum_is_dense(const idl_enumerator_t **sorted, size_t count) {
+    if (count == 0) return true;
+    int64_t span = (int64_t)(int32_t)sorted[count - 1]->value.value - (int32_t)sorted[0]->value.value;
+    return span == (int64_t)count - 1;
+}
+
+/*
+ * Lookup tables behind fromValue(). Contiguous values index a dense array,
+ * sparse values are binary searched in a sorted key column. The array is
+ * VALUES itself when the enumerators are declared in value order.
+ */
+static int generate_enum_value_table(string_builder_t *sb, const idl_enum_t *enum_def, const char *enum_name, size_t count) {
+    const idl_enumerator_t **sorted = sorted_enumerators(enum_def, count);
+    if (!sorted) return -1;
+
+    if (!enum_is_dense(sorted, count)) {
+        sb_append(sb, "    private static final int[] SORTED_VALUES = {");
+        for (size_t i = 0; i < count; i++) {
+            sb_appendf(sb, "%s%d", i ? ", " : "", (int32_t)sorted[i]->value.value);
+        }
+        sb_append(sb, "};\n");
+    }
+    if (!enum_in_value_order(enum_def)) {
+        sb_appendf(sb, "    private static final %s[] BY_VALUE = {", enum_name);
+        for (size_t i = 0; i < count; i++) {
+            sb_appendf(sb, "%s%s", i ? ", " : "", enumerator_name(sorted[i]));
+        }
+        sb_append(sb, "};\n");
+    }
+    free(sorted);
+    return 0;
+}
+
+static void generate_enum_from_value(string_builder_t *sb, const idl_enum_t *enum_def, const char *enum_name, size_t count) {
+    const idl_enumerator_t **sorted = sorted_enumerators(enum_def, count);
+    bool dense = !sorted || enum_is_dense(sorted, count);
+    int32_t min_value = sorted && count ? (int32_t)sorted[0]->value.value : 0;
+    const char *table = enum_in_value_order(enum_def) ? "VALUES" : "BY_VALUE";
+    free(sorted);
+
+    sb_appendf(sb, "    public static %s fromValue(int value) {\n", enum_name);
+    if (dense) {
+        if (min_value == 0) {
+            sb_append(sb, "        int index = value;\n");
+        } else if (min_value > 0) {
+            sb_appendf(sb, "        int index = value - %d;\n", min_value);
+        } else {
+            sb_appendf(sb, "        int index = value + %lld;\n", -(long long)min_value);
+        }
+        sb_appendf(sb, "        if (index >= 0 && index < %s.length) {\n", table);
+        sb_appendf(sb, "            return %s[index];\n", table);
+    } else {
+        sb_append(sb, "        int index = java.util.Arrays.binarySearch(SORTED_VALUES, value);\n");
+        sb_append(sb, "        if (index >= 0) {\n");
+        sb_appendf(sb, "            return %s[index];\n", table);
+    }
+    sb_append(sb, "        }\n");
+    sb_appendf(sb, "        throw new IllegalArgumentException(\"Unknown %s value: \" + value);\n", enum_name);
+    sb_append(sb, "    }\n\n");
+}
+
+int generate_java_enum(const idl_enum_t *enum_def, const java_generator_config_t *config, const char *enum_name) {
+    if (!enum_def || !config || !config->output_dir) return -1;
     
-    char *package = resolve_package((const idl_node_t *)enum_def, prefix);
+    const char *output_dir = config->output_dir;
+    const char *package = resolve_package((const idl_node_t *)enum_def, config->package_prefix);
     const char *actual_enum_name = enum_name ? enum_name : "GeneratedEnum";
     
     string_builder_t *sb = sb_create();
     if (!sb) {
-        free(package);
         return -1;
     }
     
     sb_appendf(sb, "package %s;\n\n", package);
-    sb_append(sb, "import com.sun.jna.Structure;\n\n");
+    if (!config->generate_records) sb_append(sb, "import com.sun.jna.Structure;\n");
+    sb_append(sb, "import java.nio.ByteBuffer;\n\n");
     sb_appendf(sb, "public enum %s {\n", actual_enum_name);
     
     int enum_count = 0;
     for (const idl_enumerator_t *enumerator = enum_def->enumerators; enumerator; 
          enumerator = (const idl_enumerator_t *)((idl_node_t *)enumerator)->next) {
         if (enum_count > 0) sb_append(sb, ",\n");
-        const char *enum_value = "VALUE";
-        if (enumerator->name && enumerator->name->identifier) {
-            enum_value = enumerator->name->identifier;
-        }
-        sb_appendf(sb, "    %s(%d)", enum_value, enum_count);
+        sb_appendf(sb, "    %s(%d)", enumerator_name(enumerator), (int32_t)enumerator->value.value);
         enum_count++;
     }
     
     sb_append(sb, ";\n\n");
+    sb_appendf(sb, "    private static final %s[] VALUES = values();\n", actual_enum_name);
+    if (generate_enum_value_table(sb, enum_def, actual_enum_name, (size_t)enum_count) != 0) {
+        sb_destroy(sb);
+        return -1;
+    }
+    sb_append(sb, "\n");
     sb_append(sb, "    private final int value;\n\n");
     sb_appendf(sb, "    %s(int value) {\n", actual_enum_name);
     sb_append(sb, "        this.value = value;\n");
@@ -583,6 +1205,18 @@ int generate_java_enum(const idl_enum_t *enum_def, const char *output_dir, const
     sb_append(sb, "    public int getValue() {\n");
     sb_append(sb, "        return value;\n");
     sb_append(sb, "    }\n\n");
+    generate_enum_from_value(sb, enum_def, actual_enum_name, (size_t)enum_count);
+    
+    uint32_t width = cdr_enum_size(enum_def, config->cdr_format);
+    sb_append(sb, "    public int getSerializedSize() {\n");
+    sb_appendf(sb, "        return %u;\n", width);
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    public void serializeInto(ByteBuffer buffer) {\n");
+    generate_value_padding(sb, width, config->cdr_format);
+    sb_appendf(sb, "        buffer.put%s(%svalue);\n", codec_width_accessor(width), width == 4 ? "" : codec_width_cast(width));
+    sb_append(sb, "    }\n\n");
+    
+    generate_type_objects(sb, enum_def, actual_enum_name);
     
     sb_append(sb, "    public static DynamicType describeType() {\n");
     sb_appendf(sb, "        DynamicType dt = new DynamicType(\"%s\");\n", actual_enum_name);
@@ -590,11 +1224,7 @@ int generate_java_enum(const idl_enum_t *enum_def, const char *output_dir, const
     
     for (const idl_enumerator_t *enumerator = enum_def->enumerators; enumerator; 
          enumerator = (const idl_enumerator_t *)((idl_node_t *)enumerator)->next) {
-        const char *enum_value = "VALUE";
-        if (enumerator->name && enumerator->name->identifier) {
-            enum_value = enumerator->name->identifier;
-        }
-        sb_appendf(sb, "        dt.addEnumerator(\"%s\");\n", enum_value);
+        sb_appendf(sb, "        dt.addEnumerator(\"%s\");\n", enumerator_name(enumerator));
     }
     
     sb_append(sb, "        return dt;\n");
@@ -619,45 +1249,38 @@ int generate_java_enum(const idl_enum_t *enum_def, const char *output_dir, const
     
     char file_path[768];
     snprintf(file_path, sizeof(file_path), "%s/%s.java", package_path, actual_enum_name);
-    FILE *f = fopen(file_path, "w");
-    if (f) {
-        fputs(sb_string(sb), f);
-        fclose(f);
-        printf("  Created: %s\n", file_path);
-    } else {
-        fprintf(stderr, "  Error: Could not create file: %s\n", file_path);
-        free(package);
+    if (java_write_file(file_path, sb) != 0) {
         sb_destroy(sb);
         return -1;
     }
     
-    free(package);
     sb_destroy(sb);
     return 0;
 }
 
-int generate_java_typedef(const idl_typedef_t *typedef_def, const char *output_dir, const char *prefix) {
-    if (!typedef_def || !output_dir) return -1;
+int generate_java_typedef(const idl_typedef_t *typedef_def, const java_generator_config_t *config) {
+    if (!typedef_def || !config || !config->output_dir) return -1;
     if (!typedef_def->declarators || !typedef_def->declarators->name || !typedef_def->declarators->name->identifier) {
         return 0;
     }
+    if (config->inline_typedefs) return 0;  /* aliases are resolved where they are used */
     
     const char *typedef_name = typedef_def->declarators->name->identifier;
-    char *java_type = java_type_name(typedef_def->type_spec, false);
+    const char *java_type = java_type_name(typedef_def->type_spec, false);
     
-    char *package = resolve_package((const idl_node_t *)typedef_def, prefix);
+    const char *output_dir = config->output_dir;
+    const char *package = resolve_package((const idl_node_t *)typedef_def, config->package_prefix);
     
     string_builder_t *sb = sb_create();
     if (!sb) {
-        free(java_type);
-        free(package);
         return -1;
     }
     
     sb_appendf(sb, "package %s;\n\n", package);
-    sb_append(sb, "import com.sun.jna.Structure;\n\n");
-    sb_appendf(sb, "public class %s extends Structure {\n\n", typedef_name);
+    if (!config->generate_records) sb_append(sb, "import com.sun.jna.Structure;\n\n");
+    generate_class_declaration(sb, typedef_name, config->generate_records);
     sb_appendf(sb, "    public %s value;\n\n", java_type);
+    generate_type_objects(sb, typedef_def->declarators, typedef_name);
     sb_appendf(sb, "    public %s() { }\n\n", typedef_name);
     sb_appendf(sb, "    public %s(%s value) {\n", typedef_name, java_type);
     sb_append(sb, "        this.value = value;\n");
@@ -684,34 +1307,291 @@ int generate_java_typedef(const idl_typedef_t *typedef_def, const char *output_d
     
     char file_path[768];
     snprintf(file_path, sizeof(file_path), "%s/%s.java", package_path, typedef_name);
-    FILE *f = fopen(file_path, "w");
-    if (f) {
-        fputs(sb_string(sb), f);
-        fclose(f);
-        printf("  Created: %s\n", file_path);
-    } else {
-        fprintf(stderr, "  Error: Could not create file: %s\n", file_path);
-        free(java_type);
-        free(package);
+    if (java_write_file(file_path, sb) != 0) {
         sb_destroy(sb);
         return -1;
     }
     
-    free(java_type);
-    free(package);
     sb_destroy(sb);
     return 0;
 }
 
-int generate_java_union(const idl_union_t *union_def, const char *output_dir, const char *prefix, const char *union_name) {
-    if (!union_def || !output_dir) return -1;
+/* Value of a case label: an enumerator or an integer, char or boolean literal */
+int64_t case_label_value(const idl_const_expr_t *const_expr) {
+    if (idl_mask(const_expr) & IDL_ENUMERATOR) {
+        return ((const idl_enumerator_t *)const_expr)->value.value;
+    }
+    const idl_literal_t *literal = (const idl_literal_t *)const_expr;
+    switch (idl_type(const_expr)) {
+        case IDL_BOOL: return literal->value.bln;
+        case IDL_CHAR: return literal->value.chr;
+        case IDL_INT8: return literal->value.int8;
+        case IDL_OCTET:
+        case IDL_UINT8: return literal->value.uint8;
+        case IDL_SHORT:
+        case IDL_INT16: return literal->value.int16;
+        case IDL_USHORT:
+        case IDL_UINT16: return literal->value.uint16;
+        case IDL_LONG:
+        case IDL_INT32: return literal->value.int32;
+        case IDL_ULONG:
+        case IDL_UINT32: return literal->value.uint32;
+        case IDL_LLONG:
+        case IDL_INT64: return literal->value.int64;
+        case IDL_ULLONG:
+        case IDL_UINT64: return (int64_t)literal->value.uint64;
+        default: return 0;
+    }
+}
+
+/* Java literal for a label value compared against a _d of the given Java type */
+static const char *case_label_literal(char *buf, size_t size, int64_t value, const char *discrim_type) {
+    if (strcmp(discrim_type, "long") == 0) {
+        snprintf(buf, size, "%lldL", (long long)value);
+    } else if (strcmp(discrim_type, "byte") == 0 && (value < -128 || value > 127)) {
+        snprintf(buf, size, "(byte) %lld", (long long)value);
+    } else if (strcmp(discrim_type, "short") == 0 && (value < -32768 || value > 32767)) {
+        snprintf(buf, size, "(short) %lld", (long long)value);
+    } else {
+        snprintf(buf, size, "%lld", (long long)value);
+    }
+    return buf;
+}
+
+static bool is_default_case(const idl_case_t *case_def) {
+    for (const idl_case_label_t *label = case_def->labels; label; label = (const idl_case_label_t *)((const idl_node_t *)label)->next) {
+        if (!label->const_expr) return true;
+    }
+    return false;
+}
+
+typedef void (*union_case_emitter_t)(java_codec_t *codec, const idl_case_t *case_def, int indent);
+
+/*
+ * Dispatch on _d: a switch for byte/short/int discriminators and an if-chain
+ * for long ones, which Java cannot switch on. The default case goes last.
+ */
+static void generate_union_dispatch(java_codec_t *codec, const idl_union_t *union_def, const char *discrim_type, union_case_emitter_t emit_case) {
+    string_builder_t *sb = codec->sb;
+    uint32_t known_align = codec->known_align;
+    bool use_if = strcmp(discrim_type, "long") == 0;
+    const idl_case_t *default_case = NULL;
+    bool first = true;
+    char literal[64];
+
+    if (!use_if) sb_append(sb, "        switch (_d) {\n");
+    for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
+        if (!case_def->declarator || !case_def->declarator->name) continue;
+        if (is_default_case(case_def)) {
+            default_case = case_def;
+            continue;
+        }
+        if (use_if) {
+            sb_append(sb, first ? "        if (" : " else if (");
+            int label_count = 0;
+            for (const idl_case_label_t *label = case_def->labels; label; label = (const idl_case_label_t *)((const idl_node_t *)label)->next) {
+                case_label_literal(literal, sizeof(literal), case_label_value(label->const_expr), discrim_type);
+                sb_appendf(sb, "%s_d == %s", label_count++ > 0 ? " || " : "", literal);
+            }
+            sb_append(sb, ") {\n");
+            codec->known_align = known_align;
+            emit_case(codec, case_def, 12);
+            sb_append(sb, "        }");
+        } else {
+            for (const idl_case_label_t *label = case_def->labels; label; label = (const idl_case_label_t *)((const idl_node_t *)label)->next) {
+                case_label_literal(literal, sizeof(literal), case_label_value(label->const_expr), discrim_type);
+                sb_appendf(sb, "            case %s:%s\n", literal, ((const idl_node_t *)label)->next ? "" : " {");
+            }
+            codec->known_align = known_align;
+            emit_case(codec, case_def, 16);
+            sb_append(sb, "                break;\n");
+            sb_append(sb, "            }\n");
+        }
+        first = false;
+    }
+    if (default_case) {
+        codec->known_align = known_align;
+        if (use_if) {
+            sb_append(sb, first ? "        {\n" : " else {\n");
+            emit_case(codec, default_case, 12);
+            sb_append(sb, "        }\n");
+        } else {
+            sb_append(sb, "            default: {\n");
+            emit_case(codec, default_case, 16);
+            sb_append(sb, "                break;\n");
+            sb_append(sb, "            }\n");
+        }
+    } else if (use_if && !first) {
+        sb_append(sb, "\n");
+    }
+    if (!use_if) sb_append(sb, "        }\n");
+    codec->known_align = 1;
+}
+
+static void emit_case_size(java_codec_t *codec, const idl_case_t *case_def, int indent) {
+    codec_emit_size(codec, case_def->type_spec, case_def->declarator->name->identifier, indent, 0);
+    codec_size_flush(codec, indent);
+}
+
+static void emit_case_write(java_codec_t *codec, const idl_case_t *case_def, int indent) {
+    codec_emit_write(codec, case_def->type_spec, case_def->declarator->name->identifier, indent, 0);
+}
+
+/* Reset every branch but the given one, so that a union holds a single live value */
+static void generate_branch_reset(string_builder_t *sb, const idl_case_t *active, int indent) {
+    const idl_union_t *union_def = (const idl_union_t *)((const idl_node_t *)active)->parent;
+    for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
+        if (case_def == active || !case_def->declarator || !case_def->declarator->name) continue;
+        sb_appendf(sb, "%*s%s = %s;\n", indent, "", case_def->declarator->name->identifier,
+                   java_default_value(resolve_typedef_type(case_def->type_spec)));
+    }
+}
+
+static void emit_case_read(java_codec_t *codec, const idl_case_t *case_def, int indent) {
+    codec_emit_read(codec, case_def->type_spec, case_def->declarator->name->identifier, indent, 0);
+    generate_branch_reset(codec->sb, case_def, indent);
+}
+
+/* Encoded width of the discriminator */
+static uint32_t discriminator_size(const idl_union_t *union_def, java_cdr_format_t format) {
+    const idl_type_spec_t *type_spec = union_def->switch_type_spec->type_spec;
+    while (idl_type(type_spec) == IDL_TYPEDEF) type_spec = codec_typedef_alias(type_spec);
+    if (idl_type(type_spec) == IDL_ENUM) return cdr_enum_size((const idl_enum_t *)type_spec, format);
+    uint32_t size = cdr_primitive_size(idl_type(type_spec));
+    return size ? size : 4;
+}
+
+/*
+ * XCDR codec of a union: the discriminator, then only the member selected by
+ * it. Appendable unions get a DHEADER in XCDR2.
+ */
+static int generate_xcdr_union_codec(string_builder_t *sb, const idl_union_t *union_def, const char *discrim_type, java_codec_t *codec) {
+    bool has_dheader = codec->format == JAVA_CDR_XCDR2 && union_def->extensibility.value != IDL_FINAL;
+    uint32_t width = discriminator_size(union_def, codec->format);
+    uint32_t java_width = strcmp(discrim_type, "long") == 0 ? 8 : strcmp(discrim_type, "short") == 0 ? 2 : strcmp(discrim_type, "byte") == 0 ? 1 : 4;
+    uint32_t max_align = cdr_max_align(codec->format);
+    uint32_t align = width < max_align ? width : max_align;
+
+    generate_encapsulated_methods(sb, union_def->name->identifier, encapsulation_id(union_def->extensibility.value, codec->format));
+
+    sb_append(sb, "    public int serializedEnd(int pos) {\n");
+    codec->known_align = 1;
+    codec->pending = 0;
+    if (has_dheader) {
+        codec_size_align(codec, 8, 4);
+        codec_size_add(codec, 4);
+    }
+    codec_size_align(codec, 8, align);
+    codec_size_add(codec, width);
+    codec_size_flush(codec, 8);
+    generate_union_dispatch(codec, union_def, discrim_type, emit_case_size);
+    sb_append(sb, "        return pos;\n");
+    sb_append(sb, "    }\n\n");
+
+    sb_append(sb, "    public void serializeInto(ByteBuffer buffer) {\n");
+    codec->known_align = 1;
+    if (has_dheader) {
+        codec_write_align(codec, 8, 4);
+        sb_append(sb, "        int dheader = CdrWriter.beginLength(buffer);\n");
+    }
+    codec_write_align(codec, 8, align);
+    sb_appendf(sb, "        buffer.put%s(%s_d);\n", codec_width_accessor(width), java_width > width ? codec_width_cast(width) : "");
+    codec->known_align = align;
+    generate_union_dispatch(codec, union_def, discrim_type, emit_case_write);
+    if (has_dheader) {
+        sb_append(sb, "        CdrWriter.endLength(buffer, dheader);\n");
+    }
+    sb_append(sb, "    }\n\n");
+
+    sb_append(sb, "    public void deserializeFrom(ByteBuffer buffer) {\n");
+    codec->known_align = 1;
+    if (has_dheader) {
+        codec_read_align(codec, 8, 4);
+        sb_append(sb, "        int dheader = buffer.getInt();\n");
+        sb_append(sb, "        int end = buffer.position() + dheader;\n");
+    }
+    codec_read_align(codec, 8, align);
+    sb_appendf(sb, "        _d = buffer.get%s()%s;\n", codec_width_accessor(width),
+               java_width > width ? (width == 1 ? " & 0xff" : " & 0xffff") : "");
+    codec->known_align = align;
+    generate_union_dispatch(codec, union_def, discrim_type, emit_case_read);
+    if (has_dheader) {
+        sb_append(sb, "        buffer.position(end);\n");
+    }
+    sb_append(sb, "    }\n\n");
+    return 0;
+}
+
+/*
+ * Packed codec of a union: the discriminator as an int (long for 64-bit
+ * discriminators), then only the member it selects, encoded in place.
+ */
+static int generate_packed_union_codec(string_builder_t *sb, const idl_union_t *union_def, const char *discrim_type, java_codec_t *codec) {
+    bool is_long = strcmp(discrim_type, "long") == 0;
+    bool is_narrow = strcmp(discrim_type, "byte") == 0 || strcmp(discrim_type, "short") == 0;
+
+    sb_append(sb, "    public int getSerializedSize() {\n");
+    sb_appendf(sb, "        int size = %d;\n", is_long ? 8 : 4);
+    codec->known_align = 1;
+    codec->pending = 0;
+    generate_union_dispatch(codec, union_def, discrim_type, emit_case_size);
+    sb_append(sb, "        return size;\n");
+    sb_append(sb, "    }\n\n");
+
+    generate_serialize_method(sb);
+
+    sb_append(sb, "    public void serializeInto(ByteBuffer buffer) {\n");
+    sb_appendf(sb, "        buffer.put%s(_d);\n", is_long ? "Long" : "Int");
+    generate_union_dispatch(codec, union_def, discrim_type, emit_case_write);
+    sb_append(sb, "    }\n\n");
+
+    generate_deserialize_method(sb, union_def->name->identifier);
+
+    sb_append(sb, "    public void deserializeFrom(ByteBuffer buffer) {\n");
+    if (is_narrow) {
+        sb_appendf(sb, "        _d = (%s) buffer.getInt();\n", discrim_type);
+    } else {
+        sb_appendf(sb, "        _d = buffer.get%s();\n", is_long ? "Long" : "Int");
+    }
+    generate_union_dispatch(codec, union_def, discrim_type, emit_case_read);
+    sb_append(sb, "    }\n\n");
+    return 0;
+}
+
+/*
+ * Discriminator value that selects no labelled case, used by the setter of
+ * the default case: the smallest non-negative value not used as a label.
+ */
+int64_t default_discriminator(const idl_union_t *union_def) {
+    int64_t value = 0;
+    bool taken = true;
+    while (taken) {
+        taken = false;
+        for (const idl_case_t *case_def = union_def->cases; case_def && !taken; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
+            for (const idl_case_label_t *label = case_def->labels; label; label = (const idl_case_label_t *)((const idl_node_t *)label)->next) {
+                if (label->const_expr && case_label_value(label->const_expr) == value) {
+                    taken = true;
+                    break;
+                }
+            }
+        }
+        if (taken) value++;
+    }
+    return value;
+}
+
+int generate_java_union(const idl_union_t *union_def, const java_generator_config_t *config, const char *union_name) {
+    if (!union_def || !config || !config->output_dir) return -1;
     
-    char *package = resolve_package((const idl_node_t *)union_def, prefix);
+    const char *output_dir = config->output_dir;
+    const char *package = resolve_package((const idl_node_t *)union_def, config->package_prefix);
     const char *actual_union_name = union_name ? union_name : "GeneratedUnion";
+    if (config->cdr_format != JAVA_CDR_PACKED && !xcdr_cases_supported(union_def, actual_union_name)) {
+        return -1;
+    }
     
     string_builder_t *sb = sb_create();
     if (!sb) {
-        free(package);
         return -1;
     }
     
@@ -728,11 +1608,7 @@ int generate_java_union(const idl_union_t *union_def, const char *output_dir, co
         }
     }
     
-    sb_appendf(sb, "package %s;\n\n", package);
-    sb_append(sb, "import com.sun.jna.Structure;\n");
-    sb_append(sb, "import java.nio.ByteBuffer;\n");
-    sb_append(sb, "import java.nio.ByteOrder;\n\n");
-    sb_appendf(sb, "public class %s extends Structure {\n\n", actual_union_name);
+    generate_structure_header(sb, package, actual_union_name, config->generate_records, true);
     
     // Add discriminator field
     sb_appendf(sb, "    public %s _d;  // union discriminator\n\n", discrim_type);
@@ -742,31 +1618,34 @@ int generate_java_union(const idl_union_t *union_def, const char *output_dir, co
     for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
         if (case_def->declarator && case_def->declarator->name && case_def->declarator->name->identifier) {
             const char *field_name = case_def->declarator->name->identifier;
-            char *field_type = java_type_name(case_def->type_spec, false);
+            const char *field_type = java_type_name(case_def->type_spec, false);
             sb_appendf(sb, "    public %s %s;\n", field_type, field_name);
-            free(field_type);
         }
     }
     sb_append(sb, "\n");
     
-    // Add helper methods for setting cases
+    // Setters select the case through _d and drop the other branches
     sb_append(sb, "    // Set union value based on discriminator\n");
     for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
         if (case_def->declarator && case_def->declarator->name && case_def->declarator->name->identifier) {
             const char *field_name = case_def->declarator->name->identifier;
             // Capitalize first letter
-            char *setter_name = malloc(strlen(field_name) + 4);
-            sprintf(setter_name, "set%c%s", toupper(field_name[0]), field_name + 1);
-            char *field_type = java_type_name(case_def->type_spec, false);
+            const char *setter_name = java_internf("set%c%s", toupper((unsigned char)field_name[0]), field_name + 1);
+            const char *field_type = java_type_name(case_def->type_spec, false);
+            int64_t discriminator = is_default_case(case_def) ? default_discriminator(union_def)
+                                                              : case_label_value(case_def->labels->const_expr);
+            char literal[64];
             sb_appendf(sb, "    public void %s(%s value) {\n", setter_name, field_type);
+            sb_appendf(sb, "        _d = %s;\n", case_label_literal(literal, sizeof(literal), discriminator, discrim_type));
             sb_appendf(sb, "        this.%s = value;\n", field_name);
+            generate_branch_reset(sb, case_def, 8);
             sb_append(sb, "    }\n");
-            free(setter_name);
-            free(field_type);
         }
     }
     sb_append(sb, "\n");
     
+    generate_type_objects(sb, union_def, actual_union_name);
+    
     sb_append(sb, "    public static DynamicType describeType() {\n");
     sb_appendf(sb, "        DynamicType dt = new DynamicType(\"%s\");\n", actual_union_name);
     sb_append(sb, "        dt.setKind(DynamicType.UNION);\n");
@@ -774,45 +1653,14 @@ int generate_java_union(const idl_union_t *union_def, const char *output_dir, co
     sb_append(sb, "        return dt;\n");
     sb_append(sb, "    }\n\n");
     
-    sb_append(sb, "    public byte[] serialize() {\n");
-    sb_append(sb, "        ByteBuffer buffer = ByteBuffer.allocate(256);\n");
-    sb_append(sb, "        buffer.order(ByteOrder.LITTLE_ENDIAN);\n");
-    sb_appendf(sb, "        buffer.put%s(_d);\n", (strcmp(discrim_type, "long") == 0) ? "Long" : "Int");
-    // Serialize all non-null case fields
-    for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
-        if (case_def->declarator && case_def->declarator->name && case_def->declarator->name->identifier) {
-            const char *field_name = case_def->declarator->name->identifier;
-            sb_appendf(sb, "        if (%s != null) {\n", field_name);
-            sb_appendf(sb, "            buffer.put(%s.serialize());\n", field_name);
-            sb_append(sb, "        }\n");
-        }
-    }
-    sb_append(sb, "        byte[] result = new byte[buffer.position()];\n");
-    sb_append(sb, "        buffer.flip();\n");
-    sb_append(sb, "        buffer.get(result);\n");
-    sb_append(sb, "        return result;\n");
-    sb_append(sb, "    }\n\n");
-    
-    sb_append(sb, "    public void deserialize(byte[] data) {\n");
-    sb_append(sb, "        ByteBuffer buffer = ByteBuffer.wrap(data);\n");
-    sb_append(sb, "        buffer.order(ByteOrder.LITTLE_ENDIAN);\n");
-    sb_appendf(sb, "        _d = buffer.get%s();\n", (strcmp(discrim_type, "long") == 0) ? "Long" : "Int");
-    // For now, just read remaining data into first non-null case field
-    sb_append(sb, "        byte[] remaining = new byte[buffer.remaining()];\n");
-    sb_append(sb, "        buffer.get(remaining);\n");
-    // Try to deserialize into each case field
-    for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
-        if (case_def->declarator && case_def->declarator->name && case_def->declarator->name->identifier) {
-            const char *field_name = case_def->declarator->name->identifier;
-            char *field_type = java_type_name(case_def->type_spec, false);
-            sb_appendf(sb, "        // Try to deserialize into %s\n", field_name);
-            sb_appendf(sb, "        %s = new %s();\n", field_name, field_type);
-            sb_appendf(sb, "        %s.deserialize(remaining);\n", field_name);
-            free(field_type);
-            break;
-        }
+    java_codec_t codec;
+    codec_init(&codec, sb, config->cdr_format, false);
+    if (config->cdr_format == JAVA_CDR_PACKED) {
+        generate_packed_union_codec(sb, union_def, discrim_type, &codec);
+    } else {
+        generate_xcdr_union_codec(sb, union_def, discrim_type, &codec);
     }
-    sb_append(sb, "    }\n\n");
+    generate_union_key_equality(sb, union_def, actual_union_name, discrim_type);
     
     sb_append(sb, "    @Override\n");
     sb_append(sb, "    public String toString() {\n");
@@ -838,86 +1686,119 @@ int generate_java_union(const idl_union_t *union_def, const char *output_dir, co
     
     char file_path[768];
     snprintf(file_path, sizeof(file_path), "%s/%s.java", package_path, actual_union_name);
-    FILE *f = fopen(file_path, "w");
-    if (f) {
-        fputs(sb_string(sb), f);
-        fclose(f);
-        printf("  Created: %s\n", file_path);
-    } else {
-        fprintf(stderr, "  Error: Could not create file: %s\n", file_path);
-        free(package);
+    if (java_write_file(file_path, sb) != 0) {
         sb_destroy(sb);
         return -1;
     }
     
-    free(package);
     sb_destroy(sb);
     return 0;
 }
 
-int generate_java_bitmask(const idl_bitmask_t *bitmask_def, const char *output_dir, const char *prefix, const char *bitmask_name) {
-    if (!bitmask_def || !output_dir) return -1;
+int generate_java_bitmask(const idl_bitmask_t *bitmask_def, const java_generator_config_t *config, const char *bitmask_name) {
+    if (!bitmask_def || !config || !config->output_dir) return -1;
     
-    char *package = resolve_package((const idl_node_t *)bitmask_def, prefix);
+    const char *output_dir = config->output_dir;
+    const char *package = resolve_package((const idl_node_t *)bitmask_def, config->package_prefix);
     const char *actual_bitmask_name = bitmask_name ? bitmask_name : "GeneratedBitmask";
     
     string_builder_t *sb = sb_create();
     if (!sb) {
-        free(package);
         return -1;
     }
     
     sb_appendf(sb, "package %s;\n\n", package);
-    sb_append(sb, "import com.sun.jna.Structure;\n\n");
-    sb_appendf(sb, "public class %s extends Structure {\n\n", actual_bitmask_name);
+    if (!config->generate_records) sb_append(sb, "import com.sun.jna.Structure;\n");
+    sb_append(sb, "import java.nio.ByteBuffer;\n\n");
+    generate_class_declaration(sb, actual_bitmask_name, config->generate_records);
+    
+    uint32_t width = cdr_bitmask_size(bitmask_def);
+    const char *value_type = java_bitmask_type(bitmask_def, false);
     
     // Add bitmask value field
-    sb_append(sb, "    public long value;  // bitmask value\n\n");
+    sb_appendf(sb, "    public %s value;  // bitmask value\n\n", value_type);
     
     // Add bit values as constants
     sb_append(sb, "    // Bit values\n");
-    int bit_pos = 0;
     for (const idl_bit_value_t *bit = bitmask_def->bit_values; bit; bit = (const idl_bit_value_t *)((idl_node_t *)bit)->next) {
         const char *bit_name = "BIT";
         if (bit->name && bit->name->identifier) {
             bit_name = bit->name->identifier;
         }
-        sb_appendf(sb, "    public static final long %s = 1L << %d;\n", bit_name, bit_pos);
-        bit_pos++;
+        if (width == 8) {
+            sb_appendf(sb, "    public static final long %s = 1L << %u;\n", bit_name, bit->position.value);
+        } else if (width == 4) {
+            sb_appendf(sb, "    public static final int %s = 1 << %u;\n", bit_name, bit->position.value);
+        } else {
+            sb_appendf(sb, "    public static final %s %s = %s(1 << %u);\n", value_type, bit_name, codec_width_cast(width), bit->position.value);
+        }
     }
     sb_append(sb, "\n");
     
     sb_appendf(sb, "    public %s() { }\n\n", actual_bitmask_name);
-    sb_appendf(sb, "    public %s(long value) {\n", actual_bitmask_name);
+    sb_appendf(sb, "    public %s(%s value) {\n", actual_bitmask_name, value_type);
     sb_append(sb, "        this.value = value;\n");
     sb_append(sb, "    }\n\n");
     
-    sb_append(sb, "    public long getValue() { return value; }\n");
-    sb_append(sb, "    public void setValue(long value) { this.value = value; }\n\n");
+    sb_appendf(sb, "    public %s getValue() { return value; }\n", value_type);
+    sb_appendf(sb, "    public void setValue(%s value) { this.value = value; }\n\n", value_type);
     
     // Add helper methods
-    sb_appendf(sb, "    public boolean isSet(long flag) {\n");
+    sb_appendf(sb, "    public boolean isSet(%s flag) {\n", value_type);
     sb_append(sb, "        return (value & flag) == flag;\n");
     sb_append(sb, "    }\n\n");
     
-    sb_appendf(sb, "    public void setFlag(long flag) {\n");
+    sb_appendf(sb, "    public void setFlag(%s flag) {\n", value_type);
     sb_append(sb, "        value |= flag;\n");
     sb_append(sb, "    }\n\n");
     
-    sb_appendf(sb, "    public void clearFlag(long flag) {\n");
+    sb_appendf(sb, "    public void clearFlag(%s flag) {\n", value_type);
     sb_append(sb, "        value &= ~flag;\n");
     sb_append(sb, "    }\n\n");
     
+    // Static forms for values stored inline in struct members and sequences
+    const char *narrow = width < 4 ? codec_width_cast(width) : "";
+    sb_appendf(sb, "    public static boolean isSet(%s value, %s flag) {\n", value_type, value_type);
+    sb_append(sb, "        return (value & flag) == flag;\n");
+    sb_append(sb, "    }\n\n");
+    
+    sb_appendf(sb, "    public static %s setFlag(%s value, %s flag) {\n", value_type, value_type, value_type);
+    sb_appendf(sb, width < 4 ? "        return %s(value | flag);\n" : "        return %svalue | flag;\n", narrow);
+    sb_append(sb, "    }\n\n");
+    
+    sb_appendf(sb, "    public static %s clearFlag(%s value, %s flag) {\n", value_type, value_type, value_type);
+    sb_appendf(sb, width < 4 ? "        return %s(value & ~flag);\n" : "        return %svalue & ~flag;\n", narrow);
+    sb_append(sb, "    }\n\n");
+    
+    sb_append(sb, "    public int getSerializedSize() {\n");
+    sb_appendf(sb, "        return %u;\n", width);
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    public void serializeInto(ByteBuffer buffer) {\n");
+    generate_value_padding(sb, width, config->cdr_format);
+    sb_appendf(sb, "        buffer.put%s(value);\n", codec_width_accessor(width));
+    sb_append(sb, "    }\n\n");
+    
+    const char *dt_kind = width == 1 ? "OCTET" : width == 2 ? "INT16" : width == 4 ? "INT32" : "INT64";
+    generate_type_objects(sb, bitmask_def, actual_bitmask_name);
+    
     sb_append(sb, "    public static DynamicType describeType() {\n");
     sb_appendf(sb, "        DynamicType dt = new DynamicType(\"%s\");\n", actual_bitmask_name);
     sb_append(sb, "        dt.setKind(DynamicType.BITMASK);\n");
-    sb_append(sb, "        dt.addMember(\"value\", DynamicType.INT64);\n");
+    sb_appendf(sb, "        dt.addMember(\"value\", DynamicType.%s);\n", dt_kind);
     sb_append(sb, "        return dt;\n");
     sb_append(sb, "    }\n\n");
     
+    const char *hex = width == 8 ? "Long.toHexString(value)"
+                    : width == 4 ? "Integer.toHexString(value)"
+                    : width == 2 ? "Integer.toHexString(value & 0xffff)"
+                    : "Integer.toHexString(value & 0xff)";
+    sb_appendf(sb, "    public static String toString(%s value) {\n", value_type);
+    sb_appendf(sb, "        return \"%s[value=0x\" + %s + \"]\";\n", actual_bitmask_name, hex);
+    sb_append(sb, "    }\n\n");
+    
     sb_append(sb, "    @Override\n");
     sb_append(sb, "    public String toString() {\n");
-    sb_appendf(sb, "        return \"%s[value=0x\" + Long.toHexString(value) + \"]\";\n", actual_bitmask_name);
+    sb_append(sb, "        return toString(value);\n");
     sb_append(sb, "    }\n");
     sb_append(sb, "}\n");
     
@@ -939,19 +1820,11 @@ int generate_java_bitmask(const idl_bitmask_t *bitmask_def, const char *output_d
     
     char file_path[768];
     snprintf(file_path, sizeof(file_path), "%s/%s.java", package_path, actual_bitmask_name);
-    FILE *f = fopen(file_path, "w");
-    if (f) {
-        fputs(sb_string(sb), f);
-        fclose(f);
-        printf("  Created: %s\n", file_path);
-    } else {
-        fprintf(stderr, "  Error: Could not create file: %s\n", file_path);
-        free(package);
+    if (java_write_file(file_path, sb) != 0) {
         sb_destroy(sb);
         return -1;
     }
     
-    free(package);
     sb_destroy(sb);
     return 0;
 }
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * CDR runtime shared by the generated codecs, written once per output
+ * directory: CdrWriter and CdrReader in org.eclipse.cyclonedds.java.cdr hold
+ * the string, padding, length-header and list-reuse code that the codec
+ * emitter (java_codec.c) would otherwise inline into every class, and
+ * CdrKeys the element-wise list comparison of keyHashCode()/keyEquals().
+ * Member loops stay in the generated classes; everything they call is a
+ * small static method that HotSpot inlines at each call site.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "idlc_java.h"
+
+typedef struct string_builder string_builder_t;
+
+extern string_builder_t *sb_create(void);
+extern void sb_destroy(string_builder_t *sb);
+extern int sb_append(string_builder_t *sb, const char *str);
+extern int sb_appendf(string_builder_t *sb, const char *format, ...);
+
+extern char *java_package_path(const java_generator_config_t *config, const char *package);
+extern int java_write_class(const char *package_path, const char *class_name, const string_builder_t *sb);
+
+#define RUNTIME_PACKAGE "org.eclipse.cyclonedds.java.cdr"
+
+static void generate_cdr_writer(string_builder_t *sb) {
+    sb_append(sb, "package " RUNTIME_PACKAGE ";\n\n");
+    sb_append(sb, "import java.nio.ByteBuffer;\n");
+    sb_append(sb, "import java.nio.ByteOrder;\n");
+    sb_append(sb, "import java.nio.charset.StandardCharsets;\n");
+    sb_append(sb, "import java.util.Arrays;\n\n");
+    sb_append(sb, "/**\n");
+    sb_append(sb, " * CDR write primitives called by the generated serializeInto() methods,\n");
+    sb_append(sb, " * and a growable buffer for callers that serialize repeatedly.\n");
+    sb_append(sb, " */\n");
+    sb_append(sb, "public final class CdrWriter {\n");
+    sb_append(sb, "    private ByteBuffer buffer;\n\n");
+    sb_append(sb, "    public CdrWriter() {\n");
+    sb_append(sb, "        this(256);\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    public CdrWriter(int capacity) {\n");
+    sb_append(sb, "        buffer = ByteBuffer.allocate(capacity).order(ByteOrder.LITTLE_ENDIAN);\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** The cleared buffer with room for size bytes, reallocated at twice the size when it has not */\n");
+    sb_append(sb, "    public ByteBuffer reserve(int size) {\n");
+    sb_append(sb, "        if (buffer.capacity() < size) {\n");
+    sb_append(sb, "            buffer = ByteBuffer.allocate(Math.max(size, 2 * buffer.capacity())).order(buffer.order());\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        buffer.clear();\n");
+    sb_append(sb, "        return buffer;\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** Copy of the bytes written since the last reserve() */\n");
+    sb_append(sb, "    public byte[] toByteArray() {\n");
+    sb_append(sb, "        return Arrays.copyOf(buffer.array(), buffer.position());\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    public static void writePadding(ByteBuffer buffer, int alignment) {\n");
+    sb_append(sb, "        for (int i = -buffer.position() & (alignment - 1); i > 0; i--) {\n");
+    sb_append(sb, "            buffer.put((byte) 0);\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** Reserves a DHEADER or NEXTINT and returns its position, for endLength() */\n");
+    sb_append(sb, "    public static int beginLength(ByteBuffer buffer) {\n");
+    sb_append(sb, "        int position = buffer.position();\n");
+    sb_append(sb, "        buffer.putInt(0);\n");
+    sb_append(sb, "        return position;\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** Sets the length reserved at position to the number of bytes written after it */\n");
+    sb_append(sb, "    public static void endLength(ByteBuffer buffer, int position) {\n");
+    sb_append(sb, "        buffer.putInt(position, buffer.position() - position - 4);\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** XCDR string: length including the NUL, UTF-8 bytes, NUL; null is written as \"\" */\n");
+    sb_append(sb, "    public static void writeString(ByteBuffer buffer, String value) {\n");
+    sb_append(sb, "        if (value != null) {\n");
+    sb_append(sb, "            byte[] bytes = value.getBytes(StandardCharsets.UTF_8);\n");
+    sb_append(sb, "            buffer.putInt(bytes.length + 1);\n");
+    sb_append(sb, "            buffer.put(bytes);\n");
+    sb_append(sb, "        } else {\n");
+    sb_append(sb, "            buffer.putInt(1);\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        buffer.put((byte) 0);\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** Packed string: length and UTF-8 bytes; null is written as length -1 */\n");
+    sb_append(sb, "    public static void writePackedString(ByteBuffer buffer, String value) {\n");
+    sb_append(sb, "        if (value != null) {\n");
+    sb_append(sb, "            byte[] bytes = value.getBytes(StandardCharsets.UTF_8);\n");
+    sb_append(sb, "            buffer.putInt(bytes.length);\n");
+    sb_append(sb, "            buffer.put(bytes);\n");
+    sb_append(sb, "        } else {\n");
+    sb_append(sb, "            buffer.putInt(-1);\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** Length of the UTF-8 encoding of s, without encoding it */\n");
+    sb_append(sb, "    public static int utf8Length(String s) {\n");
+    sb_append(sb, "        int len = 0;\n");
+    sb_append(sb, "        for (int i = 0, n = s.length(); i < n; i++) {\n");
+    sb_append(sb, "            char c = s.charAt(i);\n");
+    sb_append(sb, "            if (c < 0x80) {\n");
+    sb_append(sb, "                len += 1;\n");
+    sb_append(sb, "            } else if (c < 0x800) {\n");
+    sb_append(sb, "                len += 2;\n");
+    sb_append(sb, "            } else if (Character.isHighSurrogate(c) && i + 1 < n && Character.isLowSurrogate(s.charAt(i + 1))) {\n");
+    sb_append(sb, "                len += 4;\n");
+    sb_append(sb, "                i++;\n");
+    sb_append(sb, "            } else if (Character.isSurrogate(c)) {\n");
+    sb_append(sb, "                len += 1;  // encoded as '?' by getBytes()\n");
+    sb_append(sb, "            } else {\n");
+    sb_append(sb, "                len += 3;\n");
+    sb_append(sb, "            }\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        return len;\n");
+    sb_append(sb, "    }\n");
+    sb_append(sb, "}\n");
+}
+
+static void generate_cdr_reader(string_builder_t *sb) {
+    sb_append(sb, "package " RUNTIME_PACKAGE ";\n\n");
+    sb_append(sb, "import java.nio.ByteBuffer;\n");
+    sb_append(sb, "import java.nio.charset.StandardCharsets;\n");
+    sb_append(sb, "import java.util.ArrayList;\n");
+    sb_append(sb, "import java.util.List;\n\n");
+    sb_append(sb, "/** CDR read primitives called by the generated deserializeFrom() methods. */\n");
+    sb_append(sb, "public final class CdrReader {\n");
+    sb_append(sb, "    private CdrReader() { }\n\n");
+    sb_append(sb, "    public static void skipPadding(ByteBuffer buffer, int alignment) {\n");
+    sb_append(sb, "        buffer.position((buffer.position() + alignment - 1) & -alignment);\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** XCDR string, whose length includes the NUL */\n");
+    sb_append(sb, "    public static String readString(ByteBuffer buffer) {\n");
+    sb_append(sb, "        int len = buffer.getInt();\n");
+    sb_append(sb, "        String value = new String(buffer.array(), buffer.arrayOffset() + buffer.position(), Math.max(len - 1, 0), StandardCharsets.UTF_8);\n");
+    sb_append(sb, "        buffer.position(buffer.position() + len);\n");
+    sb_append(sb, "        return value;\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** Packed string, null for a length of -1 (or 0) */\n");
+    sb_append(sb, "    public static String readPackedString(ByteBuffer buffer) {\n");
+    sb_append(sb, "        int len = buffer.getInt();\n");
+    sb_append(sb, "        if (len <= 0) {\n");
+    sb_append(sb, "            return null;\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        String value = new String(buffer.array(), buffer.arrayOffset() + buffer.position(), len, StandardCharsets.UTF_8);\n");
+    sb_append(sb, "        buffer.position(buffer.position() + len);\n");
+    sb_append(sb, "        return value;\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** Size of a mutable member from its EMHEADER length code, consuming NEXTINT for LC 4 */\n");
+    sb_append(sb, "    public static int memberSize(ByteBuffer buffer, int emheader) {\n");
+    sb_append(sb, "        switch ((emheader >>> 28) & 7) {\n");
+    sb_append(sb, "            case 0: return 1;\n");
+    sb_append(sb, "            case 1: return 2;\n");
+    sb_append(sb, "            case 2: return 4;\n");
+    sb_append(sb, "            case 3: return 8;\n");
+    sb_append(sb, "            case 4: return buffer.getInt();\n");
+    sb_append(sb, "            case 5: return 4 + buffer.getInt(buffer.position());\n");
+    sb_append(sb, "            case 6: return 4 + 4 * buffer.getInt(buffer.position());\n");
+    sb_append(sb, "            default: return 4 + 8 * buffer.getInt(buffer.position());\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /**\n");
+    sb_append(sb, "     * list ready to receive len elements: a new list if it is null, else the\n");
+    sb_append(sb, "     * list trimmed to its first len elements (keep) or cleared, with its\n");
+    sb_append(sb, "     * capacity raised to len. A negative len (packed null) counts as 0.\n");
+    sb_append(sb, "     */\n");
+    sb_append(sb, "    public static <T> List<T> reuseList(List<T> list, int len, boolean keep) {\n");
+    sb_append(sb, "        if (list == null) {\n");
+    sb_append(sb, "            return new ArrayList<>(Math.max(len, 0));\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        if (!keep) {\n");
+    sb_append(sb, "            list.clear();\n");
+    sb_append(sb, "        } else if (list.size() > len) {\n");
+    sb_append(sb, "            list.subList(Math.max(len, 0), list.size()).clear();\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        if (list instanceof ArrayList) {\n");
+    sb_append(sb, "            ((ArrayList<T>) list).ensureCapacity(len);\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        return list;\n");
+    sb_append(sb, "    }\n");
+    sb_append(sb, "}\n");
+}
+
+static void generate_cdr_keys(string_builder_t *sb) {
+    sb_append(sb, "package " RUNTIME_PACKAGE ";\n\n");
+    sb_append(sb, "import java.util.List;\n");
+    sb_append(sb, "import java.util.function.BiPredicate;\n");
+    sb_append(sb, "import java.util.function.ToIntFunction;\n\n");
+    sb_append(sb, "/**\n");
+    sb_append(sb, " * List comparison for the generated keyHashCode()/keyEquals(), whose element\n");
+    sb_append(sb, " * classes do not override equals()/hashCode() by key.\n");
+    sb_append(sb, " */\n");
+    sb_append(sb, "public final class CdrKeys {\n");
+    sb_append(sb, "    private CdrKeys() { }\n\n");
+    sb_append(sb, "    /** List.hashCode() with hash in place of the elements' hashCode() */\n");
+    sb_append(sb, "    public static <T> int hashCode(List<T> list, ToIntFunction<? super T> hash) {\n");
+    sb_append(sb, "        if (list == null) {\n");
+    sb_append(sb, "            return 0;\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        int h = 1;\n");
+    sb_append(sb, "        for (int i = 0, n = list.size(); i < n; i++) {\n");
+    sb_append(sb, "            h = 31 * h + hash.applyAsInt(list.get(i));\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        return h;\n");
+    sb_append(sb, "    }\n\n");
+    sb_append(sb, "    /** List.equals() with equals in place of the elements' equals() */\n");
+    sb_append(sb, "    public static <T> boolean equals(List<T> a, List<T> b, BiPredicate<? super T, ? super T> equals) {\n");
+    sb_append(sb, "        if (a == b) {\n");
+    sb_append(sb, "            return true;\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        if (a == null || b == null || a.size() != b.size()) {\n");
+    sb_append(sb, "            return false;\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        for (int i = 0, n = a.size(); i < n; i++) {\n");
+    sb_append(sb, "            if (!equals.test(a.get(i), b.get(i))) {\n");
+    sb_append(sb, "                return false;\n");
+    sb_append(sb, "            }\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "        return true;\n");
+    sb_append(sb, "    }\n");
+    sb_append(sb, "}\n");
+}
+
+int generate_java_runtime(const java_generator_config_t *config) {
+    if (!config || !config->output_dir) return -1;
+
+    char *package_path = java_package_path(config, RUNTIME_PACKAGE);
+    string_builder_t *writer = sb_create();
+    string_builder_t *reader = sb_create();
+    string_builder_t *keys = sb_create();
+    int result = -1;
+    if (package_path && writer && reader && keys) {
+        generate_cdr_writer(writer);
+        generate_cdr_reader(reader);
+        generate_cdr_keys(keys);
+        result = java_write_class(package_path, "CdrWriter", writer);
+        if (result == 0) result = java_write_class(package_path, "CdrReader", reader);
+        if (result == 0) result = java_write_class(package_path, "CdrKeys", keys);
+    }
+
+    sb_destroy(writer);
+    sb_destroy(reader);
+    sb_destroy(keys);
+    free(package_path);
+    return result;
+}
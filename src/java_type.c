@@ -14,6 +14,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <stdarg.h>
 #include "idlc_java.h"
 
 typedef struct string_builder string_builder_t;
@@ -24,10 +25,63 @@ extern int sb_append(string_builder_t *sb, const char *str);
 extern int sb_appendf(string_builder_t *sb, const char *format, ...);
 extern const char *sb_string(const string_builder_t *sb);
 
-extern char *resolve_package(const idl_node_t *node, const char *prefix);
+extern const char *resolve_package(const idl_node_t *node, const char *prefix);
+extern const idl_type_spec_t *codec_typedef_alias(const idl_type_spec_t *type_spec);
+extern const char *java_internf(const char *format, ...);
+extern uint32_t cdr_bitmask_size(const idl_bitmask_t *bitmask_def);
 
-char *java_type_name(const idl_type_spec_t *type_spec, bool boxed) {
-    if (!type_spec) return strdup("Object");
+/*
+ * With java-inline-typedefs aliases are resolved at every use site: members
+ * take the aliased Java type and the codec works on the aliased type, so no
+ * wrapper object is allocated per aliased member. Set once per run, like the
+ * other option flags.
+ */
+static bool inline_typedefs = false;
+
+void java_set_inline_typedefs(bool enabled) {
+    inline_typedefs = enabled;
+}
+
+/* Type to generate code for: the aliased type if typedefs are inlined */
+const idl_type_spec_t *java_resolve_alias(const idl_type_spec_t *type_spec) {
+    if (!inline_typedefs) return type_spec;
+    while (type_spec && idl_type(type_spec) == IDL_TYPEDEF) {
+        const idl_type_spec_t *alias = codec_typedef_alias(type_spec);
+        if (!alias) break;
+        type_spec = alias;
+    }
+    return type_spec;
+}
+
+/* Definition a forward-declared struct or union stands for, NULL if it was never defined */
+const idl_type_spec_t *java_resolve_forward(const idl_type_spec_t *type_spec) {
+    if (type_spec && (idl_mask(type_spec) & IDL_FORWARD)) return ((const idl_forward_t *)type_spec)->type_spec;
+    return type_spec;
+}
+
+/*
+ * Java storage type of a bitmask value: the narrowest integer holding its
+ * @bit_bound. Bitmask values are carried as this primitive; the generated
+ * bitmask class only holds the flag constants and helpers.
+ */
+const char *java_bitmask_type(const idl_bitmask_t *bitmask_def, bool boxed) {
+    switch (cdr_bitmask_size(bitmask_def)) {
+        case 1: return boxed ? "Byte" : "byte";
+        case 2: return boxed ? "Short" : "short";
+        case 4: return boxed ? "Integer" : "int";
+        default: return boxed ? "Long" : "long";
+    }
+}
+
+/*
+ * Java type of a type spec. Names of named types point into the AST and
+ * composed types such as lists are interned in the run's arena, so the
+ * result lives until generate() returns and is never freed by the caller.
+ */
+const char *java_type_name(const idl_type_spec_t *type_spec, bool boxed) {
+    type_spec = java_resolve_forward(type_spec);
+    if (!type_spec) return "Object";
+    type_spec = java_resolve_alias(type_spec);
 
     // Use idl_type directly instead of idl_unalias to avoid accessing freed memory
     idl_type_t type = idl_type(type_spec);
@@ -37,50 +91,47 @@ char *java_type_name(const idl_type_spec_t *type_spec, bool boxed) {
         // For typedefs from other modules, use idl_name() which works across module boundaries
         const idl_name_t *type_name = idl_name(type_spec);
         if (type_name && type_name->identifier) {
-            return strdup(type_name->identifier);
+            return type_name->identifier;
         }
-        return strdup("Object");
+        return "Object";
     }
 
     switch (type) {
         case IDL_BOOL:
-            return strdup(boxed ? "Boolean" : "boolean");
+            return boxed ? "Boolean" : "boolean";
         case IDL_OCTET:
         case IDL_CHAR:
-            return strdup(boxed ? "Byte" : "byte");
+            return boxed ? "Byte" : "byte";
         case IDL_SHORT:
-            return strdup(boxed ? "Short" : "short");
+            return boxed ? "Short" : "short";
         case IDL_USHORT:
-            return strdup(boxed ? "Character" : "char");
+            return boxed ? "Character" : "char";
         case IDL_LONG:
-            return strdup(boxed ? "Integer" : "int");
+            return boxed ? "Integer" : "int";
         case IDL_ULONG:
-            return strdup(boxed ? "Integer" : "int");
+            return boxed ? "Integer" : "int";
         case IDL_LLONG:
-            return strdup(boxed ? "Long" : "long");
+            return boxed ? "Long" : "long";
         case IDL_ULLONG:
-            return strdup(boxed ? "Long" : "long");
+            return boxed ? "Long" : "long";
         case IDL_FLOAT:
-            return strdup(boxed ? "Float" : "float");
+            return boxed ? "Float" : "float";
         case IDL_DOUBLE:
-            return strdup(boxed ? "Double" : "double");
+            return boxed ? "Double" : "double";
         case IDL_STRING:
-            return strdup("String");
+            return "String";
         case IDL_WSTRING:
-            return strdup("String");
+            return "String";
         case IDL_SEQUENCE: {
             const idl_sequence_t *seq = (const idl_sequence_t *)type_spec;
-            if (!seq || !seq->type_spec) return strdup("java.util.List<Object>");
-            char *element_type = java_type_name(seq->type_spec, true);
-            char *result = malloc(strlen(element_type) + 20);
-            sprintf(result, "java.util.List<%s>", element_type);
-            free(element_type);
-            return result;
+            if (!seq || !seq->type_spec) return "java.util.List<Object>";
+            return java_internf("java.util.List<%s>", java_type_name(seq->type_spec, true));
         }
+        case IDL_BITMASK:
+            return java_bitmask_type((const idl_bitmask_t *)type_spec, boxed);
         case IDL_STRUCT:
         case IDL_UNION:
-        case IDL_ENUM:
-        case IDL_BITMASK: {
+        case IDL_ENUM: {
             const idl_name_t *name = NULL;
             idl_mask_t type_mask = idl_mask(type_spec);
             if (type_mask & IDL_STRUCT) {
@@ -89,26 +140,56 @@ char *java_type_name(const idl_type_spec_t *type_spec, bool boxed) {
                 name = ((const idl_union_t *)type_spec)->name;
             } else if (type_mask & IDL_ENUM) {
                 name = ((const idl_enum_t *)type_spec)->name;
-            } else if (type_mask & IDL_BITMASK) {
-                name = ((const idl_bitmask_t *)type_spec)->name;
             }
             if (name && name->identifier) {
-                return strdup(name->identifier);
+                return name->identifier;
             }
-            return strdup("Object");
+            return "Object";
         }
         case IDL_TYPEDEF: {
             const idl_typedef_t *td = (const idl_typedef_t *)type_spec;
             if (td && td->declarators && td->declarators->name && td->declarators->name->identifier) {
-                return strdup(td->declarators->name->identifier);
+                return td->declarators->name->identifier;
             }
-            return strdup("Object");
+            return "Object";
         }
         default:
-            return strdup("Object");
+            return "Object";
+    }
+}
+
+static bool is_java_primitive(idl_type_t type) {
+    switch (type) {
+        case IDL_BOOL:
+        case IDL_OCTET:
+        case IDL_CHAR:
+        case IDL_SHORT:
+        case IDL_USHORT:
+        case IDL_LONG:
+        case IDL_ULONG:
+        case IDL_LLONG:
+        case IDL_ULLONG:
+        case IDL_FLOAT:
+        case IDL_DOUBLE: return true;
+        default: return false;
     }
 }
 
+/*
+ * Java type of a struct member. With java-use-arrays, sequences of primitives
+ * map to primitive arrays (int[], double[], ...) instead of boxed Lists.
+ */
+const char *java_field_type_name(const idl_type_spec_t *type_spec, bool use_arrays) {
+    type_spec = java_resolve_alias(type_spec);
+    if (use_arrays && type_spec && idl_type(type_spec) == IDL_SEQUENCE) {
+        const idl_sequence_t *seq = (const idl_sequence_t *)type_spec;
+        if (seq->type_spec && is_java_primitive(idl_type(java_resolve_alias(seq->type_spec)))) {
+            return java_internf("%s[]", java_type_name(seq->type_spec, false));
+        }
+    }
+    return java_type_name(type_spec, false);
+}
+
 const char *java_default_value(idl_type_t type) {
     switch (type) {
         case IDL_BOOL: return "false";
@@ -127,10 +208,163 @@ const char *java_default_value(idl_type_t type) {
         case IDL_INT64:
         case IDL_UINT64:
         case IDL_LLONG:
-        case IDL_ULLONG: return "0";
+        case IDL_ULLONG:
+        case IDL_BITMASK: return "0";
         case IDL_FLOAT:
         case IDL_DOUBLE:
         case IDL_LDOUBLE: return "0.0";
         default: return "null";
     }
 }
+
+static char *format_expr(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    char *result = malloc((size_t)len + 1);
+    if (!result) return NULL;
+    va_start(args, format);
+    vsnprintf(result, (size_t)len + 1, format, args);
+    va_end(args);
+    return result;
+}
+
+static bool is_array_field(const idl_type_spec_t *type_spec, bool use_arrays) {
+    if (!use_arrays || idl_type(type_spec) != IDL_SEQUENCE) return false;
+    const idl_sequence_t *seq = (const idl_sequence_t *)type_spec;
+    return seq->type_spec && is_java_primitive(idl_type(java_resolve_alias(seq->type_spec)));
+}
+
+/* `(expr != null ? expr.value : default)` for a typedef holder */
+static char *typedef_value_expr(const idl_type_spec_t *alias, const char *expr) {
+    return format_expr("(%s != null ? %s.value : %s)", expr, expr, java_default_value(idl_type(alias)));
+}
+
+/*
+ * Whether a list of this element type is compared element by element:
+ * structs, unions, enums and typedef holders inherit identity or native
+ * memory equals()/hashCode(), so a List of them would not match equal keys.
+ */
+static bool key_elementwise(const idl_type_spec_t *type_spec) {
+    type_spec = java_resolve_alias(type_spec);
+    switch (idl_type(type_spec)) {
+        case IDL_STRUCT:
+        case IDL_UNION:
+        case IDL_ENUM:
+        case IDL_TYPEDEF:
+            return true;
+        case IDL_SEQUENCE: {
+            const idl_sequence_t *seq = (const idl_sequence_t *)type_spec;
+            return seq->type_spec && key_elementwise(seq->type_spec);
+        }
+        default:
+            return false;
+    }
+}
+
+/* depth names the lambda parameters of nested lists apart */
+static char *key_hash_expr(const idl_type_spec_t *type_spec, const char *expr, bool use_arrays, int depth) {
+    type_spec = java_resolve_alias(type_spec);
+    idl_type_t type = idl_type(type_spec);
+
+    if (is_java_primitive(type)) {
+        return format_expr("%s.hashCode(%s)", java_type_name(type_spec, true), expr);
+    }
+    switch (type) {
+        case IDL_ENUM:
+            return format_expr("(%s != null ? %s.getValue() : 0)", expr, expr);
+        case IDL_BITMASK: {
+            const char *boxed = java_bitmask_type((const idl_bitmask_t *)type_spec, true);
+            return format_expr("%s.hashCode(%s)", boxed, expr);
+        }
+        case IDL_STRUCT:
+        case IDL_UNION:
+            return format_expr("(%s != null ? %s.keyHashCode() : 0)", expr, expr);
+        case IDL_SEQUENCE: {
+            const idl_sequence_t *seq = (const idl_sequence_t *)type_spec;
+            if (is_array_field(type_spec, use_arrays)) {
+                return format_expr("java.util.Arrays.hashCode(%s)", expr);
+            }
+            if (!seq->type_spec || !key_elementwise(seq->type_spec)) break;
+            char elem[16];
+            snprintf(elem, sizeof(elem), "e%d", depth);
+            char *hash = key_hash_expr(seq->type_spec, elem, false, depth + 1);
+            char *result = hash ? format_expr("org.eclipse.cyclonedds.java.cdr.CdrKeys.hashCode(%s, %s -> %s)", expr, elem, hash) : NULL;
+            free(hash);
+            return result;
+        }
+        case IDL_TYPEDEF: {
+            const idl_type_spec_t *alias = codec_typedef_alias(type_spec);
+            if (!alias) break;
+            char *value = typedef_value_expr(alias, expr);
+            char *result = key_hash_expr(alias, value, false, depth);
+            free(value);
+            return result;
+        }
+        default:
+            break;
+    }
+    return format_expr("java.util.Objects.hashCode(%s)", expr);
+}
+
+static char *key_equals_expr(const idl_type_spec_t *type_spec, const char *a, const char *b, bool use_arrays, int depth) {
+    type_spec = java_resolve_alias(type_spec);
+    idl_type_t type = idl_type(type_spec);
+
+    switch (type) {
+        case IDL_FLOAT:
+            return format_expr("Float.floatToIntBits(%s) == Float.floatToIntBits(%s)", a, b);
+        case IDL_DOUBLE:
+            return format_expr("Double.doubleToLongBits(%s) == Double.doubleToLongBits(%s)", a, b);
+        case IDL_ENUM:
+        case IDL_BITMASK:
+            return format_expr("%s == %s", a, b);
+        case IDL_STRUCT:
+        case IDL_UNION:
+            return format_expr("(%s == %s || (%s != null && %s != null && %s.keyEquals(%s)))", a, b, a, b, a, b);
+        case IDL_SEQUENCE: {
+            const idl_sequence_t *seq = (const idl_sequence_t *)type_spec;
+            if (is_array_field(type_spec, use_arrays)) {
+                return format_expr("java.util.Arrays.equals(%s, %s)", a, b);
+            }
+            if (!seq->type_spec || !key_elementwise(seq->type_spec)) break;
+            char elem_a[16], elem_b[16];
+            snprintf(elem_a, sizeof(elem_a), "a%d", depth);
+            snprintf(elem_b, sizeof(elem_b), "b%d", depth);
+            char *equals = key_equals_expr(seq->type_spec, elem_a, elem_b, false, depth + 1);
+            char *result = equals ? format_expr("org.eclipse.cyclonedds.java.cdr.CdrKeys.equals(%s, %s, (%s, %s) -> %s)", a, b, elem_a, elem_b, equals) : NULL;
+            free(equals);
+            return result;
+        }
+        case IDL_TYPEDEF: {
+            const idl_type_spec_t *alias = codec_typedef_alias(type_spec);
+            if (!alias) break;
+            char *value_a = typedef_value_expr(alias, a);
+            char *value_b = typedef_value_expr(alias, b);
+            char *result = key_equals_expr(alias, value_a, value_b, false, depth);
+            free(value_a);
+            free(value_b);
+            return result;
+        }
+        default:
+            if (is_java_primitive(type)) return format_expr("%s == %s", a, b);
+            break;
+    }
+    return format_expr("java.util.Objects.equals(%s, %s)", a, b);
+}
+
+/*
+ * Java expression hashing the key value in expr. Nested structs and unions
+ * contribute their keyHashCode(), lists of them hash element by element
+ * through CdrKeys; the result agrees with java_key_equals_expr().
+ */
+char *java_key_hash_expr(const idl_type_spec_t *type_spec, const char *expr, bool use_arrays) {
+    return key_hash_expr(type_spec, expr, use_arrays, 0);
+}
+
+/* Java expression comparing two key values; floats compare by bit pattern */
+char *java_key_equals_expr(const idl_type_spec_t *type_spec, const char *a, const char *b, bool use_arrays) {
+    return key_equals_expr(type_spec, a, b, use_arrays, 0);
+}
@@ -16,6 +16,9 @@
 #include <ctype.h>
 #include "idlc_java.h"
 
+extern const char *java_intern(const char *str);
+extern const char *java_internf(const char *format, ...);
+
 /* Get struct name - try different ways to safely extract the name */
 const char *get_struct_name(const idl_struct_t *struct_def) {
     if (!struct_def) return "UnknownStruct";
@@ -76,7 +79,8 @@ const char *get_module_name(const idl_module_t *module) {
     return "module";
 }
 
-char *resolve_package(const idl_node_t *node, const char *prefix) {
+/* Java package of node, interned in the run's arena */
+const char *resolve_package(const idl_node_t *node, const char *prefix) {
     /* Build full module path by walking up the parent chain */
     const char *module_names[20];
     int module_count = 0;
@@ -92,63 +96,45 @@ char *resolve_package(const idl_node_t *node, const char *prefix) {
         n = n->parent;
     }
     
+    bool prefixed = prefix && strlen(prefix) > 0;
     if (module_count == 0) {
-        char *package_name = strdup("generated");
-        if (prefix && strlen(prefix) > 0) {
-            char *full = malloc(strlen(prefix) + strlen(package_name) + 2);
-            sprintf(full, "%s.%s", prefix, package_name);
-            free(package_name);
-            return full;
-        }
-        return package_name;
+        return prefixed ? java_internf("%s.generated", prefix) : "generated";
     }
     
     /* Build package name from module path (reversed since we walked up) */
-    int total_len = 0;
+    size_t total_len = prefixed ? strlen(prefix) + 1 : 0;
     for (int i = module_count - 1; i >= 0; i--) {
         total_len += strlen(module_names[i]) + 1;
     }
     
-    char *package_name = malloc(total_len);
-    package_name[0] = '\0';
+    char tmp[256];
+    char *package_name = total_len <= sizeof(tmp) ? tmp : malloc(total_len);
+    if (!package_name) return NULL;
+    size_t len = prefixed ? (size_t)sprintf(package_name, "%s.", prefix) : 0;
     for (int i = module_count - 1; i >= 0; i--) {
-        if (i < module_count - 1) strcat(package_name, ".");
-        strcat(package_name, module_names[i]);
-    }
-    
-    if (prefix && strlen(prefix) > 0) {
-        char *full = malloc(strlen(prefix) + strlen(package_name) + 2);
-        sprintf(full, "%s.%s", prefix, package_name);
-        free(package_name);
-        return full;
+        len += (size_t)sprintf(package_name + len, "%s%s", module_names[i], i > 0 ? "." : "");
     }
     
-    return package_name;
+    const char *package = java_intern(package_name);
+    if (package_name != tmp) free(package_name);
+    return package;
 }
 
-char *resolve_simple_name(const idl_node_t *node) {
-    if (!node) return strdup("Unnamed");
+const char *resolve_simple_name(const idl_node_t *node) {
+    if (!node) return "Unnamed";
     
     if (idl_mask(node) & IDL_STRUCT) {
-        return strdup(get_struct_name((const idl_struct_t *)node));
+        return get_struct_name((const idl_struct_t *)node);
     }
     if (idl_mask(node) & IDL_ENUM) {
         const idl_enum_t *e = (const idl_enum_t *)node;
-        return e->name ? strdup((const char*)e->name) : strdup("UnnamedEnum");
+        return e->name && e->name->identifier ? e->name->identifier : "UnnamedEnum";
     }
     
-    return strdup("Unnamed");
+    return "Unnamed";
 }
 
-char *resolve_qualified_name(const idl_node_t *node, const char *prefix) {
-    char *package = resolve_package(node, prefix);
-    char *simple = resolve_simple_name(node);
-    
-    char *qualified = malloc(strlen(package) + strlen(simple) + 2);
-    sprintf(qualified, "%s.%s", package, simple);
-    
-    free(package);
-    free(simple);
-    
-    return qualified;
+const char *resolve_qualified_name(const idl_node_t *node, const char *prefix) {
+    const char *package = resolve_package(node, prefix);
+    return package ? java_internf("%s.%s", package, resolve_simple_name(node)) : NULL;
 }
@@ -0,0 +1,973 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * dds_topic_descriptor_t data for a topic struct, as idlc -l c emits it: the
+ * m_ops serializer program over the C layout of the type (see java_native.c),
+ * the key descriptors, flagset, size and alignment. Offsets assume an LP64
+ * target. The program has one block per type: the topic struct first, then
+ * every struct and union it refers to, and blocks for nested collections;
+ * EXT/JSR/JEQ4 operands are relative jumps from the referencing instruction
+ * into those blocks. KOF entries for the keys follow the last block.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "idlc_java.h"
+
+typedef struct string_builder string_builder_t;
+
+extern int sb_append(string_builder_t *sb, const char *str);
+extern int sb_appendf(string_builder_t *sb, const char *format, ...);
+
+extern const idl_type_spec_t *codec_typedef_alias(const idl_type_spec_t *type_spec);
+extern const idl_type_spec_t *java_resolve_forward(const idl_type_spec_t *type_spec);
+extern int64_t case_label_value(const idl_const_expr_t *const_expr);
+extern int64_t default_discriminator(const idl_union_t *union_def);
+extern uint32_t cdr_enum_size(const idl_enum_t *enum_def, java_cdr_format_t format);
+extern uint32_t cdr_bitmask_size(const idl_bitmask_t *bitmask_def);
+extern uint32_t cdr_align(uint32_t offset, uint32_t align);
+extern bool cdr_key_fits(const idl_struct_t *struct_def, java_cdr_format_t format, uint32_t limit);
+
+/* dds_opcodes.h */
+#define DDS_OP_RTS              (0x00u << 24)
+#define DDS_OP_ADR              (0x01u << 24)
+#define DDS_OP_JSR              (0x02u << 24)
+#define DDS_OP_JEQ              (0x03u << 24)
+#define DDS_OP_DLC              (0x04u << 24)
+#define DDS_OP_PLC              (0x05u << 24)
+#define DDS_OP_PLM              (0x06u << 24)
+#define DDS_OP_KOF              (0x07u << 24)
+#define DDS_OP_JEQ4             (0x08u << 24)
+
+#define DDS_OP_VAL_1BY          0x01u
+#define DDS_OP_VAL_2BY          0x02u
+#define DDS_OP_VAL_4BY          0x03u
+#define DDS_OP_VAL_8BY          0x04u
+#define DDS_OP_VAL_STR          0x05u
+#define DDS_OP_VAL_BST          0x06u
+#define DDS_OP_VAL_SEQ          0x07u
+#define DDS_OP_VAL_ARR          0x08u
+#define DDS_OP_VAL_UNI          0x09u
+#define DDS_OP_VAL_STU          0x0au
+#define DDS_OP_VAL_BSQ          0x0bu
+#define DDS_OP_VAL_ENU          0x0cu
+#define DDS_OP_VAL_EXT          0x0du
+#define DDS_OP_VAL_BLN          0x0eu
+#define DDS_OP_VAL_BMK          0x0fu
+
+#define DDS_OP_TYPE(v)          ((v) << 16)
+#define DDS_OP_SUBTYPE(v)       ((v) << 8)
+
+#define DDS_OP_FLAG_KEY         (1u << 0)
+#define DDS_OP_FLAG_DEF         (1u << 1)   /* union has a default case */
+#define DDS_OP_FLAG_FP          (1u << 1)
+#define DDS_OP_FLAG_SGN         (1u << 2)
+#define DDS_OP_FLAG_MU          (1u << 3)
+#define DDS_OP_FLAG_BASE        (1u << 4)
+#define DDS_OP_FLAG_OPT         (1u << 5)
+#define DDS_OP_FLAG_EXT         (1u << 6)
+
+/* Size of an enum or bitmask, in bits 14-15 of the opcode */
+#define DDS_OP_TYPE_SZ(n)       ((uint32_t)((n) == 1 ? 0 : (n) == 2 ? 1 : (n) == 4 ? 2 : 3) << 14)
+
+/* dds_public_impl.h */
+#define DDS_TOPIC_FIXED_KEY         (1u << 1)
+#define DDS_TOPIC_CONTAINS_UNION    (1u << 2)
+#define DDS_TOPIC_FIXED_KEY_XCDR2   (1u << 4)
+#define DDS_TOPIC_FIXED_SIZE        (1u << 7)
+
+#define POINTER_SIZE 8u
+#define SEQUENCE_SIZE 24u           /* dds_sequence_t: two uint32_t, a pointer and a bool */
+
+typedef enum word_kind {
+    WORD_OPCODE,
+    WORD_NUMBER,
+    WORD_JUMP       /* (next << 16) + target, patched once blocks are placed */
+} word_kind_t;
+
+typedef struct op_word {
+    uint32_t value;
+    word_kind_t kind;
+    const char *comment;    /* on the first word of an instruction */
+} op_word_t;
+
+/* A block of the program: the ops of a struct or union, or of an anonymous collection element */
+typedef struct op_block {
+    const idl_node_t *type;             /* struct or union, NULL for an element block */
+    const idl_type_spec_t *element;     /* element type of an element block */
+    uint32_t count;                     /* array elements of an element block */
+    uint32_t start;
+    uint32_t *member_ops;               /* struct blocks: ADR index of each member, relative to start */
+    size_t member_count;
+    bool emitted;
+} op_block_t;
+
+typedef struct op_patch {
+    uint32_t word;      /* operand to patch */
+    uint32_t insn;      /* instruction the jump is relative to */
+    size_t block;
+} op_patch_t;
+
+typedef struct descriptor {
+    op_word_t *ops;
+    uint32_t count, capacity;
+    uint32_t instructions;
+    op_block_t *blocks;
+    size_t block_count, block_capacity;
+    op_patch_t *patches;
+    size_t patch_count, patch_capacity;
+    bool contains_union;
+    bool fixed_size;
+    bool unsupported;
+    bool out_of_memory;     /* the program is incomplete, nothing may be emitted */
+} descriptor_t;
+
+/* C layout of a type */
+typedef struct c_layout {
+    uint32_t size;
+    uint32_t align;
+} c_layout_t;
+
+static void type_layout(descriptor_t *desc, const idl_type_spec_t *type_spec, c_layout_t *layout);
+
+static const char *member_name(const idl_declarator_t *declarator) {
+    return declarator && declarator->name && declarator->name->identifier ? declarator->name->identifier : "unknown";
+}
+
+static uint32_t array_count(const idl_declarator_t *declarator) {
+    if (!declarator || !idl_is_array(declarator)) return 0;
+    uint32_t count = 1;
+    for (const idl_node_t *dim = (const idl_node_t *)declarator->const_expr; dim; dim = dim->next) {
+        count *= ((const idl_literal_t *)dim)->value.uint32;
+    }
+    return count;
+}
+
+/* Resolve forward declarations and typedefs, multiplying count by the dimensions of array typedefs */
+static const idl_type_spec_t *unalias(const idl_type_spec_t *type_spec, uint32_t *count) {
+    type_spec = java_resolve_forward(type_spec);
+    while (type_spec && idl_type(type_spec) == IDL_TYPEDEF) {
+        uint32_t dims = array_count((const idl_declarator_t *)type_spec);
+        if (dims) *count = (*count ? *count : 1) * dims;
+        type_spec = java_resolve_forward(codec_typedef_alias(type_spec));
+    }
+    return type_spec;
+}
+
+/* ---- C layout ------------------------------------------------------------ */
+
+static void struct_layout(descriptor_t *desc, const idl_struct_t *struct_def, c_layout_t *layout, uint32_t *offsets) {
+    uint32_t offset = 0, align = 1;
+    if (struct_def->inherit_spec && struct_def->inherit_spec->base) {
+        c_layout_t base;
+        type_layout(desc, struct_def->inherit_spec->base, &base);
+        offset = base.size;
+        align = base.align;
+    }
+    size_t index = 0;
+    for (const idl_member_t *member = struct_def->members; member; ) {
+        c_layout_t member_layout;
+        if (member->optional.value || member->external.value) {
+            member_layout.size = member_layout.align = POINTER_SIZE;
+            desc->fixed_size = false;
+        } else {
+            uint32_t count = array_count(member->declarators);
+            type_layout(desc, member->type_spec, &member_layout);
+            if (count) member_layout.size *= count;
+        }
+        offset = cdr_align(offset, member_layout.align);
+        if (offsets) offsets[index] = offset;
+        offset += member_layout.size;
+        if (member_layout.align > align) align = member_layout.align;
+        index++;
+
+        idl_node_t *next_node = (idl_node_t *)member;
+        if (!next_node->next) break;
+        member = (const idl_member_t *)next_node->next;
+    }
+    layout->size = cdr_align(offset, align);
+    layout->align = align;
+}
+
+/* Offset of _u in the C struct of a union */
+static uint32_t union_layout(descriptor_t *desc, const idl_union_t *union_def, c_layout_t *layout) {
+    c_layout_t discrim = { 4, 4 };
+    if (union_def->switch_type_spec) type_layout(desc, union_def->switch_type_spec->type_spec, &discrim);
+    uint32_t size = 0, align = 1;
+    for (const idl_case_t *case_def = union_def->cases; case_def; ) {
+        c_layout_t branch;
+        uint32_t count = array_count(case_def->declarator);
+        type_layout(desc, case_def->type_spec, &branch);
+        if (count) branch.size *= count;
+        if (branch.size > size) size = branch.size;
+        if (branch.align > align) align = branch.align;
+
+        idl_node_t *next_node = (idl_node_t *)case_def;
+        if (!next_node->next) break;
+        case_def = (const idl_case_t *)next_node->next;
+    }
+    uint32_t offset = cdr_align(discrim.size, align);
+    uint32_t total_align = discrim.align > align ? discrim.align : align;
+    layout->size = cdr_align(offset + cdr_align(size, align), total_align);
+    layout->align = total_align;
+    desc->contains_union = true;
+    return offset;
+}
+
+static void type_layout(descriptor_t *desc, const idl_type_spec_t *type_spec, c_layout_t *layout) {
+    uint32_t count = 0;
+    type_spec = unalias(type_spec, &count);
+    layout->size = layout->align = 1;
+    switch (type_spec ? idl_type(type_spec) : 0) {
+        case IDL_BOOL:
+        case IDL_CHAR:
+        case IDL_OCTET:
+        case IDL_INT8:
+        case IDL_UINT8:
+            break;
+        case IDL_SHORT:
+        case IDL_USHORT:
+        case IDL_INT16:
+        case IDL_UINT16:
+            layout->size = layout->align = 2;
+            break;
+        case IDL_LONG:
+        case IDL_ULONG:
+        case IDL_INT32:
+        case IDL_UINT32:
+        case IDL_FLOAT:
+        case IDL_ENUM:
+            layout->size = layout->align = 4;
+            break;
+        case IDL_LLONG:
+        case IDL_ULLONG:
+        case IDL_INT64:
+        case IDL_UINT64:
+        case IDL_DOUBLE:
+            layout->size = layout->align = 8;
+            break;
+        case IDL_BITMASK:
+            layout->size = layout->align = cdr_bitmask_size((const idl_bitmask_t *)type_spec);
+            break;
+        case IDL_STRING: {
+            uint32_t maximum = ((const idl_string_t *)type_spec)->maximum;
+            if (maximum > 0) {
+                layout->size = maximum + 1;
+            } else {
+                layout->size = layout->align = POINTER_SIZE;
+                desc->fixed_size = false;
+            }
+            break;
+        }
+        case IDL_SEQUENCE:
+            layout->size = SEQUENCE_SIZE;
+            layout->align = POINTER_SIZE;
+            desc->fixed_size = false;
+            break;
+        case IDL_STRUCT:
+            struct_layout(desc, (const idl_struct_t *)type_spec, layout, NULL);
+            break;
+        case IDL_UNION:
+            union_layout(desc, (const idl_union_t *)type_spec, layout);
+            break;
+        default:
+            desc->unsupported = true;
+            break;
+    }
+    if (count) layout->size *= count;
+}
+
+/* ---- program ------------------------------------------------------------- */
+
+static uint32_t emit_word(descriptor_t *desc, uint32_t value, word_kind_t kind, const char *comment) {
+    if (desc->count == desc->capacity) {
+        uint32_t capacity = desc->capacity ? desc->capacity * 2 : 64;
+        op_word_t *ops = realloc(desc->ops, capacity * sizeof(*ops));
+        if (!ops) {
+            desc->out_of_memory = true;
+            return desc->count;
+        }
+        desc->ops = ops;
+        desc->capacity = capacity;
+    }
+    desc->ops[desc->count].value = value;
+    desc->ops[desc->count].kind = kind;
+    desc->ops[desc->count].comment = comment;
+    if (kind == WORD_OPCODE) desc->instructions++;
+    return desc->count++;
+}
+
+static uint32_t emit_opcode(descriptor_t *desc, uint32_t value, const char *comment) {
+    return emit_word(desc, value, WORD_OPCODE, comment);
+}
+
+static size_t add_block(descriptor_t *desc, const idl_node_t *type, const idl_type_spec_t *element, uint32_t count) {
+    if (type) {
+        for (size_t i = 0; i < desc->block_count; i++) {
+            if (desc->blocks[i].type == type) return i;
+        }
+    }
+    if (desc->block_count == desc->block_capacity) {
+        size_t capacity = desc->block_capacity ? desc->block_capacity * 2 : 8;
+        op_block_t *blocks = realloc(desc->blocks, capacity * sizeof(*blocks));
+        if (!blocks) {
+            /* block 0 stands in; the descriptor is dropped anyway */
+            desc->out_of_memory = true;
+            return 0;
+        }
+        desc->blocks = blocks;
+        desc->block_capacity = capacity;
+    }
+    op_block_t *block = &desc->blocks[desc->block_count];
+    memset(block, 0, sizeof(*block));
+    block->type = type;
+    block->element = element;
+    block->count = count;
+    return desc->block_count++;
+}
+
+/* Adds the offset from insn to block to the low 16 bits of word once blocks are placed */
+static void add_patch(descriptor_t *desc, uint32_t word, uint32_t insn, size_t block) {
+    if (desc->patch_count == desc->patch_capacity) {
+        size_t capacity = desc->patch_capacity ? desc->patch_capacity * 2 : 16;
+        op_patch_t *patches = realloc(desc->patches, capacity * sizeof(*patches));
+        if (!patches) {
+            desc->out_of_memory = true;
+            return;
+        }
+        desc->patches = patches;
+        desc->patch_capacity = capacity;
+    }
+    desc->patches[desc->patch_count++] = (op_patch_t){ word, insn, block };
+}
+
+/* Jump operand from insn to a block, (next << 16) + target */
+static void emit_jump(descriptor_t *desc, uint32_t insn, uint32_t next, size_t block) {
+    uint32_t word = emit_word(desc, next << 16, WORD_JUMP, NULL);
+    add_patch(desc, word, insn, block);
+}
+
+static uint32_t enum_max(const idl_enum_t *enum_def) {
+    uint32_t max = 0;
+    for (const idl_enumerator_t *e = enum_def->enumerators; e; e = (const idl_enumerator_t *)((const idl_node_t *)e)->next) {
+        if (e->value.value > max) max = e->value.value;
+    }
+    return max;
+}
+
+static uint64_t bitmask_bits(const idl_bitmask_t *bitmask_def) {
+    uint64_t bits = 0;
+    for (const idl_bit_value_t *b = bitmask_def->bit_values; b; b = (const idl_bit_value_t *)((const idl_node_t *)b)->next) {
+        bits |= 1ull << b->position.value;
+    }
+    return bits;
+}
+
+/* Type code and flags of a primitive, 0 if the type is not one */
+static uint32_t primitive_code(idl_type_t type, uint32_t *flags) {
+    *flags = 0;
+    switch (type) {
+        case IDL_BOOL: return DDS_OP_VAL_BLN;
+        case IDL_INT8: *flags = DDS_OP_FLAG_SGN; return DDS_OP_VAL_1BY;
+        case IDL_CHAR:
+        case IDL_OCTET:
+        case IDL_UINT8: return DDS_OP_VAL_1BY;
+        case IDL_SHORT:
+        case IDL_INT16: *flags = DDS_OP_FLAG_SGN; return DDS_OP_VAL_2BY;
+        case IDL_USHORT:
+        case IDL_UINT16: return DDS_OP_VAL_2BY;
+        case IDL_LONG:
+        case IDL_INT32: *flags = DDS_OP_FLAG_SGN; return DDS_OP_VAL_4BY;
+        case IDL_ULONG:
+        case IDL_UINT32: return DDS_OP_VAL_4BY;
+        case IDL_LLONG:
+        case IDL_INT64: *flags = DDS_OP_FLAG_SGN; return DDS_OP_VAL_8BY;
+        case IDL_ULLONG:
+        case IDL_UINT64: return DDS_OP_VAL_8BY;
+        case IDL_FLOAT: *flags = DDS_OP_FLAG_FP; return DDS_OP_VAL_4BY;
+        case IDL_DOUBLE: *flags = DDS_OP_FLAG_FP; return DDS_OP_VAL_8BY;
+        default: return 0;
+    }
+}
+
+/*
+ * Element of a sequence or array: its type code and flags, and the block
+ * holding its ops if it is not encoded inline.
+ */
+typedef struct element {
+    uint32_t code;
+    uint32_t flags;
+    const idl_type_spec_t *type_spec;
+    uint32_t count;         /* the element is itself an array */
+} element_t;
+
+static void classify_element(descriptor_t *desc, const idl_type_spec_t *type_spec, element_t *elem) {
+    elem->count = 0;
+    elem->type_spec = unalias(type_spec, &elem->count);
+    elem->flags = 0;
+    idl_type_t type = elem->type_spec ? idl_type(elem->type_spec) : 0;
+    if (elem->count) {
+        elem->code = DDS_OP_VAL_ARR;
+        return;
+    }
+    elem->code = primitive_code(type, &elem->flags);
+    if (elem->code) return;
+    switch (type) {
+        case IDL_STRING:
+            elem->code = ((const idl_string_t *)elem->type_spec)->maximum ? DDS_OP_VAL_BST : DDS_OP_VAL_STR;
+            break;
+        case IDL_ENUM:
+            elem->code = DDS_OP_VAL_ENU;
+            elem->flags = DDS_OP_TYPE_SZ(cdr_enum_size((const idl_enum_t *)elem->type_spec, JAVA_CDR_XCDR2));
+            break;
+        case IDL_BITMASK:
+            elem->code = DDS_OP_VAL_BMK;
+            elem->flags = DDS_OP_TYPE_SZ(cdr_bitmask_size((const idl_bitmask_t *)elem->type_spec));
+            break;
+        case IDL_SEQUENCE:
+            elem->code = ((const idl_sequence_t *)elem->type_spec)->maximum ? DDS_OP_VAL_BSQ : DDS_OP_VAL_SEQ;
+            break;
+        case IDL_STRUCT:
+            elem->code = DDS_OP_VAL_STU;
+            break;
+        case IDL_UNION:
+            elem->code = DDS_OP_VAL_UNI;
+            break;
+        default:
+            desc->unsupported = true;
+            break;
+    }
+}
+
+static bool element_has_block(const element_t *elem) {
+    return elem->code == DDS_OP_VAL_STU || elem->code == DDS_OP_VAL_UNI || elem->code == DDS_OP_VAL_SEQ ||
+           elem->code == DDS_OP_VAL_BSQ || elem->code == DDS_OP_VAL_ARR;
+}
+
+static size_t element_block(descriptor_t *desc, const element_t *elem) {
+    if (elem->code == DDS_OP_VAL_STU || elem->code == DDS_OP_VAL_UNI) {
+        return add_block(desc, (const idl_node_t *)elem->type_spec, NULL, 0);
+    }
+    return add_block(desc, NULL, elem->type_spec, elem->count);
+}
+
+/* Operands after the bound: what the element needs to be decoded */
+static void emit_element_operands(descriptor_t *desc, const element_t *elem, uint32_t insn, uint32_t next) {
+    if (elem->code == DDS_OP_VAL_ENU) {
+        emit_word(desc, enum_max((const idl_enum_t *)elem->type_spec), WORD_NUMBER, NULL);
+    } else if (elem->code == DDS_OP_VAL_BMK) {
+        uint64_t bits = bitmask_bits((const idl_bitmask_t *)elem->type_spec);
+        emit_word(desc, (uint32_t)(bits >> 32), WORD_NUMBER, NULL);
+        emit_word(desc, (uint32_t)bits, WORD_NUMBER, NULL);
+    } else if (elem->code == DDS_OP_VAL_BST) {
+        emit_word(desc, ((const idl_string_t *)elem->type_spec)->maximum + 1, WORD_NUMBER, NULL);
+    } else if (element_has_block(elem)) {
+        c_layout_t layout;
+        type_layout(desc, elem->type_spec, &layout);
+        if (elem->count) layout.size *= elem->count;
+        emit_word(desc, layout.size, WORD_NUMBER, NULL);
+        emit_jump(desc, insn, next, element_block(desc, elem));
+    }
+}
+
+/* Words taken by the element operands, to compute the next-instruction offset */
+static uint32_t element_operand_words(const element_t *elem) {
+    switch (elem->code) {
+        case DDS_OP_VAL_ENU:
+        case DDS_OP_VAL_BST: return 1;
+        case DDS_OP_VAL_BMK: return 2;
+        default: return element_has_block(elem) ? 2 : 0;
+    }
+}
+
+/*
+ * ADR instruction(s) for a value of type_spec at offset (count > 0 for an
+ * array), with extra flags (key, optional, ...). Returns the ADR index.
+ */
+static uint32_t emit_value(descriptor_t *desc, const idl_type_spec_t *type_spec, uint32_t count, uint32_t offset,
+                           uint32_t flags, const char *comment) {
+    type_spec = unalias(type_spec, &count);
+    idl_type_t type = type_spec ? idl_type(type_spec) : 0;
+    uint32_t insn;
+
+    if (count) {
+        element_t elem;
+        classify_element(desc, type_spec, &elem);
+        insn = emit_opcode(desc, DDS_OP_ADR | DDS_OP_TYPE(DDS_OP_VAL_ARR) | DDS_OP_SUBTYPE(elem.code) | elem.flags | flags, comment);
+        emit_word(desc, offset, WORD_NUMBER, NULL);
+        emit_word(desc, count, WORD_NUMBER, NULL);
+        if (element_has_block(&elem)) {
+            /* arrays put the jump before the element size */
+            c_layout_t layout;
+            type_layout(desc, elem.type_spec, &layout);
+            if (elem.count) layout.size *= elem.count;
+            emit_jump(desc, insn, 5, element_block(desc, &elem));
+            emit_word(desc, layout.size, WORD_NUMBER, NULL);
+        } else if (elem.code == DDS_OP_VAL_BST) {
+            desc->unsupported = true;
+        } else {
+            emit_element_operands(desc, &elem, insn, 0);
+        }
+        return insn;
+    }
+
+    uint32_t prim_flags;
+    uint32_t code = primitive_code(type, &prim_flags);
+    if (code) {
+        insn = emit_opcode(desc, DDS_OP_ADR | DDS_OP_TYPE(code) | prim_flags | flags, comment);
+        emit_word(desc, offset, WORD_NUMBER, NULL);
+        return insn;
+    }
+
+    switch (type) {
+        case IDL_STRING: {
+            uint32_t maximum = ((const idl_string_t *)type_spec)->maximum;
+            insn = emit_opcode(desc, DDS_OP_ADR | DDS_OP_TYPE(maximum ? DDS_OP_VAL_BST : DDS_OP_VAL_STR) | flags, comment);
+            emit_word(desc, offset, WORD_NUMBER, NULL);
+            if (maximum) emit_word(desc, maximum + 1, WORD_NUMBER, NULL);
+            return insn;
+        }
+        case IDL_ENUM: {
+            const idl_enum_t *enum_def = (const idl_enum_t *)type_spec;
+            insn = emit_opcode(desc, DDS_OP_ADR | DDS_OP_TYPE(DDS_OP_VAL_ENU) | DDS_OP_TYPE_SZ(cdr_enum_size(enum_def, JAVA_CDR_XCDR2)) | flags, comment);
+            emit_word(desc, offset, WORD_NUMBER, NULL);
+            emit_word(desc, enum_max(enum_def), WORD_NUMBER, NULL);
+            return insn;
+        }
+        case IDL_BITMASK: {
+            const idl_bitmask_t *bitmask_def = (const idl_bitmask_t *)type_spec;
+            uint64_t bits = bitmask_bits(bitmask_def);
+            insn = emit_opcode(desc, DDS_OP_ADR | DDS_OP_TYPE(DDS_OP_VAL_BMK) | DDS_OP_TYPE_SZ(cdr_bitmask_size(bitmask_def)) | flags, comment);
+            emit_word(desc, offset, WORD_NUMBER, NULL);
+            emit_word(desc, (uint32_t)(bits >> 32), WORD_NUMBER, NULL);
+            emit_word(desc, (uint32_t)bits, WORD_NUMBER, NULL);
+            return insn;
+        }
+        case IDL_SEQUENCE: {
+            const idl_sequence_t *seq = (const idl_sequence_t *)type_spec;
+            element_t elem;
+            classify_element(desc, seq->type_spec, &elem);
+            uint32_t seq_code = seq->maximum ? DDS_OP_VAL_BSQ : DDS_OP_VAL_SEQ;
+            uint32_t next = 2 + (seq->maximum ? 1 : 0) + element_operand_words(&elem);
+            insn = emit_opcode(desc, DDS_OP_ADR | DDS_OP_TYPE(seq_code) | DDS_OP_SUBTYPE(elem.code) | elem.flags | flags, comment);
+            emit_word(desc, offset, WORD_NUMBER, NULL);
+            if (seq->maximum) emit_word(desc, seq->maximum, WORD_NUMBER, NULL);
+            emit_element_operands(desc, &elem, insn, next);
+            return insn;
+        }
+        case IDL_STRUCT:
+        case IDL_UNION: {
+            bool pointer = (flags & (DDS_OP_FLAG_OPT | DDS_OP_FLAG_EXT)) != 0;
+            insn = emit_opcode(desc, DDS_OP_ADR | DDS_OP_TYPE(DDS_OP_VAL_EXT) | flags, comment);
+            emit_word(desc, offset, WORD_NUMBER, NULL);
+            emit_jump(desc, insn, pointer ? 4 : 3, add_block(desc, (const idl_node_t *)type_spec, NULL, 0));
+            if (pointer) {
+                c_layout_t layout;
+                type_layout(desc, type_spec, &layout);
+                emit_word(desc, layout.size, WORD_NUMBER, NULL);
+            }
+            return insn;
+        }
+        default:
+            desc->unsupported = true;
+            return emit_opcode(desc, DDS_OP_RTS, comment);
+    }
+}
+
+static uint32_t member_flags(const idl_member_t *member) {
+    uint32_t flags = 0;
+    if (member->key.value) flags |= DDS_OP_FLAG_KEY | DDS_OP_FLAG_MU;
+    if (member->optional.value) flags |= DDS_OP_FLAG_OPT;
+    if (member->external.value) flags |= DDS_OP_FLAG_EXT;
+    return flags;
+}
+
+static size_t count_members(const idl_struct_t *struct_def) {
+    size_t count = 0;
+    for (const idl_node_t *node = (const idl_node_t *)struct_def->members; node; node = node->next) count++;
+    return count;
+}
+
+/*
+ * Struct block. Final structs are a flat list of ADRs, appendable ones are
+ * prefixed by DLC, and mutable ones are a PLC with a PLM per member (member
+ * id as operand) whose target is an ADR/RTS pair for the member.
+ */
+static void emit_struct_block(descriptor_t *desc, size_t block_index, const idl_struct_t *struct_def) {
+    size_t member_count = count_members(struct_def);
+    uint32_t *offsets = calloc(member_count ? member_count : 1, sizeof(uint32_t));
+    uint32_t *member_ops = calloc(member_count ? member_count : 1, sizeof(uint32_t));
+    if (!offsets || !member_ops) {
+        desc->out_of_memory = true;
+        free(offsets);
+        free(member_ops);
+        return;
+    }
+    c_layout_t layout;
+    struct_layout(desc, struct_def, &layout, offsets);
+    uint32_t start = desc->count;
+    const idl_type_spec_t *base = struct_def->inherit_spec ? struct_def->inherit_spec->base : NULL;
+    idl_extensibility_t extensibility = struct_def->extensibility.value;
+
+    if (extensibility == IDL_MUTABLE) {
+        emit_opcode(desc, DDS_OP_PLC, NULL);
+        uint32_t *plm = calloc(member_count + 1, sizeof(uint32_t));
+        if (!plm) {
+            desc->out_of_memory = true;
+            free(offsets);
+            free(member_ops);
+            return;
+        }
+        size_t base_block = 0;
+        if (base) {
+            base_block = add_block(desc, (const idl_node_t *)base, NULL, 0);
+            uint32_t insn = emit_word(desc, DDS_OP_PLM | (DDS_OP_FLAG_BASE << 16), WORD_OPCODE, "base");
+            emit_word(desc, 0, WORD_NUMBER, NULL);
+            /* PLM targets are in the low 16 bits of the opcode itself */
+            add_patch(desc, insn, insn, base_block);
+        }
+        size_t index = 0;
+        for (const idl_member_t *member = struct_def->members; member; ) {
+            plm[index] = emit_opcode(desc, DDS_OP_PLM, member_name(member->declarators));
+            emit_word(desc, member->declarators ? member->declarators->id.value : (uint32_t)index, WORD_NUMBER, NULL);
+            index++;
+            idl_node_t *next_node = (idl_node_t *)member;
+            if (!next_node->next) break;
+            member = (const idl_member_t *)next_node->next;
+        }
+        emit_opcode(desc, DDS_OP_RTS, NULL);
+        index = 0;
+        for (const idl_member_t *member = struct_def->members; member; ) {
+            if (!desc->out_of_memory) desc->ops[plm[index]].value |= desc->count - plm[index];
+            member_ops[index] = emit_value(desc, member->type_spec, array_count(member->declarators), offsets[index],
+                                           member_flags(member), member_name(member->declarators)) - start;
+            emit_opcode(desc, DDS_OP_RTS, NULL);
+            index++;
+            idl_node_t *next_node = (idl_node_t *)member;
+            if (!next_node->next) break;
+            member = (const idl_member_t *)next_node->next;
+        }
+        free(plm);
+    } else {
+        if (extensibility == IDL_APPENDABLE) emit_opcode(desc, DDS_OP_DLC, NULL);
+        if (base) {
+            uint32_t insn = emit_opcode(desc, DDS_OP_ADR | DDS_OP_TYPE(DDS_OP_VAL_EXT) | DDS_OP_FLAG_BASE, "parent");
+            emit_word(desc, 0, WORD_NUMBER, NULL);
+            emit_jump(desc, insn, 3, add_block(desc, (const idl_node_t *)base, NULL, 0));
+        }
+        size_t index = 0;
+        for (const idl_member_t *member = struct_def->members; member; ) {
+            member_ops[index] = emit_value(desc, member->type_spec, array_count(member->declarators), offsets[index],
+                                           member_flags(member), member_name(member->declarators)) - start;
+            index++;
+            idl_node_t *next_node = (idl_node_t *)member;
+            if (!next_node->next) break;
+            member = (const idl_member_t *)next_node->next;
+        }
+        emit_opcode(desc, DDS_OP_RTS, NULL);
+    }
+
+    desc->blocks[block_index].member_ops = member_ops;
+    desc->blocks[block_index].member_count = member_count;
+    free(offsets);
+}
+
+/* JEQ4 for one label of a union case: simple branches inline, others jump to a block */
+static void emit_case(descriptor_t *desc, const idl_case_t *case_def, int64_t label, uint32_t offset) {
+    uint32_t count = array_count(case_def->declarator);
+    const idl_type_spec_t *type_spec = unalias(case_def->type_spec, &count);
+    const char *name = member_name(case_def->declarator);
+    element_t elem;
+    classify_element(desc, case_def->type_spec, &elem);
+
+    bool inline_value = !count && (elem.code == DDS_OP_VAL_1BY || elem.code == DDS_OP_VAL_2BY || elem.code == DDS_OP_VAL_4BY ||
+                                   elem.code == DDS_OP_VAL_8BY || elem.code == DDS_OP_VAL_BLN || elem.code == DDS_OP_VAL_STR ||
+                                   elem.code == DDS_OP_VAL_ENU);
+    if (inline_value) {
+        emit_opcode(desc, DDS_OP_JEQ4 | DDS_OP_TYPE(elem.code) | elem.flags, name);
+        emit_word(desc, (uint32_t)label, WORD_NUMBER, NULL);
+        emit_word(desc, offset, WORD_NUMBER, NULL);
+        emit_word(desc, elem.code == DDS_OP_VAL_ENU ? enum_max((const idl_enum_t *)type_spec) : 0, WORD_NUMBER, NULL);
+        return;
+    }
+
+    size_t block = (elem.code == DDS_OP_VAL_STU || elem.code == DDS_OP_VAL_UNI) && !count
+        ? add_block(desc, (const idl_node_t *)type_spec, NULL, 0)
+        : add_block(desc, NULL, case_def->type_spec, array_count(case_def->declarator));
+    uint32_t code = count ? DDS_OP_VAL_ARR : elem.code == DDS_OP_VAL_STU ? DDS_OP_VAL_EXT : elem.code;
+    uint32_t insn = emit_opcode(desc, DDS_OP_JEQ4 | DDS_OP_TYPE(code), name);
+    emit_word(desc, (uint32_t)label, WORD_NUMBER, NULL);
+    emit_word(desc, offset, WORD_NUMBER, NULL);
+    emit_word(desc, 0, WORD_NUMBER, NULL);
+    /* the jump is in the low 16 bits of the JEQ4 opcode */
+    add_patch(desc, insn, insn, block);
+}
+
+/* Union block: UNI on _d with the case count, then one JEQ4 per label */
+static void emit_union_block(descriptor_t *desc, const idl_union_t *union_def) {
+    c_layout_t layout;
+    uint32_t offset = union_layout(desc, union_def, &layout);
+    const idl_type_spec_t *discrim = union_def->switch_type_spec ? union_def->switch_type_spec->type_spec : NULL;
+    element_t disc;
+    classify_element(desc, discrim, &disc);
+
+    uint32_t labels = 0;
+    for (const idl_case_t *c = union_def->cases; c; c = (const idl_case_t *)((const idl_node_t *)c)->next) {
+        for (const idl_case_label_t *l = c->labels; l; l = (const idl_case_label_t *)((const idl_node_t *)l)->next) labels++;
+    }
+
+    if (union_def->extensibility.value == IDL_APPENDABLE) emit_opcode(desc, DDS_OP_DLC, NULL);
+    emit_opcode(desc, DDS_OP_ADR | DDS_OP_TYPE(DDS_OP_VAL_UNI) | DDS_OP_SUBTYPE(disc.code) | disc.flags |
+                                      (union_def->default_case ? DDS_OP_FLAG_DEF : 0), "_d");
+    emit_word(desc, 0, WORD_NUMBER, NULL);
+    emit_word(desc, labels, WORD_NUMBER, NULL);
+    emit_word(desc, ((4 + 4 * labels) << 16) | 4, WORD_JUMP, NULL);
+
+    for (const idl_case_t *case_def = union_def->cases; case_def; ) {
+        for (const idl_case_label_t *label = case_def->labels; label; ) {
+            int64_t value = label->const_expr ? case_label_value(label->const_expr) : default_discriminator(union_def);
+            emit_case(desc, case_def, value, offset);
+            idl_node_t *next_label = (idl_node_t *)label;
+            if (!next_label->next) break;
+            label = (const idl_case_label_t *)next_label->next;
+        }
+        idl_node_t *next_node = (idl_node_t *)case_def;
+        if (!next_node->next) break;
+        case_def = (const idl_case_t *)next_node->next;
+    }
+    emit_opcode(desc, DDS_OP_RTS, NULL);
+}
+
+static void emit_block(descriptor_t *desc, size_t index) {
+    desc->blocks[index].start = desc->count;
+    desc->blocks[index].emitted = true;
+    const idl_node_t *type = desc->blocks[index].type;
+    if (type && (idl_mask(type) & IDL_STRUCT)) {
+        emit_struct_block(desc, index, (const idl_struct_t *)type);
+    } else if (type && (idl_mask(type) & IDL_UNION)) {
+        emit_union_block(desc, (const idl_union_t *)type);
+    } else {
+        emit_value(desc, desc->blocks[index].element, desc->blocks[index].count, 0, 0, "element");
+        emit_opcode(desc, DDS_OP_RTS, NULL);
+    }
+}
+
+/* ---- keys ---------------------------------------------------------------- */
+
+typedef struct key_path {
+    char name[256];
+    uint32_t ops[8];        /* ADR index per level, relative to the enclosing block */
+    uint32_t depth;
+} key_path_t;
+
+typedef struct key_list {
+    key_path_t *keys;
+    size_t count, capacity;
+} key_list_t;
+
+static bool struct_has_key(const idl_struct_t *struct_def) {
+    for (const idl_member_t *member = struct_def->members; member; member = (const idl_member_t *)((const idl_node_t *)member)->next) {
+        if (member->key.value) return true;
+    }
+    return false;
+}
+
+/* Key leaves of a struct block: its key members, or all members if it has none; nested structs recurse */
+static void collect_keys(descriptor_t *desc, const idl_struct_t *struct_def, const key_path_t *prefix, key_list_t *list) {
+    size_t block_index = add_block(desc, (const idl_node_t *)struct_def, NULL, 0);
+    const op_block_t *block = &desc->blocks[block_index];
+    bool keyed = struct_has_key(struct_def);
+    size_t index = 0;
+    for (const idl_member_t *member = struct_def->members; member; ) {
+        if ((!keyed || member->key.value) && index < block->member_count && prefix->depth < 8) {
+            key_path_t path = *prefix;
+            if (path.depth > 0) strncat(path.name, ".", sizeof(path.name) - strlen(path.name) - 1);
+            strncat(path.name, member_name(member->declarators), sizeof(path.name) - strlen(path.name) - 1);
+            path.ops[path.depth++] = block->member_ops[index];
+
+            uint32_t count = 0;
+            const idl_type_spec_t *type_spec = unalias(member->type_spec, &count);
+            if (!count && type_spec && idl_type(type_spec) == IDL_STRUCT) {
+                collect_keys(desc, (const idl_struct_t *)type_spec, &path, list);
+                block = &desc->blocks[block_index];
+            } else {
+                if (list->count == list->capacity) {
+                    size_t capacity = list->capacity ? list->capacity * 2 : 4;
+                    key_path_t *keys = realloc(list->keys, capacity * sizeof(*keys));
+                    if (!keys) {
+                        desc->out_of_memory = true;
+                        return;
+                    }
+                    list->keys = keys;
+                    list->capacity = capacity;
+                }
+                list->keys[list->count++] = path;
+            }
+        }
+        index++;
+        idl_node_t *next_node = (idl_node_t *)member;
+        if (!next_node->next) break;
+        member = (const idl_member_t *)next_node->next;
+    }
+}
+
+/* ---- output -------------------------------------------------------------- */
+
+static void scoped_name(char *buf, size_t size, const idl_node_t *node, const char *name) {
+    const char *modules[32];
+    int depth = 0;
+    for (const idl_node_t *scope = node->parent; scope && depth < 32; scope = scope->parent) {
+        if ((idl_mask(scope) & IDL_MODULE) && ((const idl_module_t *)scope)->name) {
+            modules[depth++] = ((const idl_module_t *)scope)->name->identifier;
+        }
+    }
+    buf[0] = '\0';
+    while (depth-- > 0) {
+        strncat(buf, modules[depth], size - strlen(buf) - 1);
+        strncat(buf, "::", size - strlen(buf) - 1);
+    }
+    strncat(buf, name, size - strlen(buf) - 1);
+}
+
+static void append_word(string_builder_t *sb, const op_word_t *word) {
+    switch (word->kind) {
+        case WORD_OPCODE:
+            sb_appendf(sb, "0x%08" PRIx32, word->value);
+            break;
+        case WORD_JUMP:
+            sb_appendf(sb, "(%" PRIu32 " << 16) + %" PRIu32, word->value >> 16, word->value & 0xffffu);
+            break;
+        default:
+            if (word->value > INT32_MAX) {
+                sb_appendf(sb, "0x%08" PRIx32, word->value);
+            } else {
+                sb_appendf(sb, "%" PRIu32, word->value);
+            }
+            break;
+    }
+}
+
+static void append_ops(string_builder_t *sb, const descriptor_t *desc) {
+    sb_append(sb, "        public static final int[] OPS = {\n");
+    for (uint32_t i = 0; i < desc->count; ) {
+        uint32_t end = i + 1;
+        while (end < desc->count && desc->ops[end].kind != WORD_OPCODE) end++;
+        sb_append(sb, "            ");
+        for (uint32_t w = i; w < end; w++) {
+            append_word(sb, &desc->ops[w]);
+            if (w + 1 < desc->count) sb_append(sb, w + 1 < end ? ", " : ",");
+        }
+        if (desc->ops[i].comment) sb_appendf(sb, "  // %s", desc->ops[i].comment);
+        sb_append(sb, "\n");
+        i = end;
+    }
+    sb_append(sb, "        };\n");
+}
+
+static void descriptor_free(descriptor_t *desc) {
+    for (size_t i = 0; i < desc->block_count; i++) free(desc->blocks[i].member_ops);
+    free(desc->blocks);
+    free(desc->patches);
+    free(desc->ops);
+}
+
+/*
+ * Nested `Descriptor` class of a <Type>Native topic struct: the constants of
+ * its dds_topic_descriptor_t, which DdsTopicDescriptor copies into native
+ * memory. Returns false, emitting nothing, for types the opcode program
+ * cannot express (long double, wchar/wstring, arrays of bounded strings).
+ */
+bool generate_topic_descriptor(string_builder_t *sb, const idl_struct_t *struct_def) {
+    descriptor_t desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.fixed_size = true;
+
+    add_block(&desc, (const idl_node_t *)struct_def, NULL, 0);
+    for (size_t i = 0; i < desc.block_count; i++) {
+        emit_block(&desc, i);
+    }
+    uint32_t nops = desc.instructions;
+    for (size_t i = 0; i < desc.patch_count && !desc.out_of_memory; i++) {
+        const op_patch_t *patch = &desc.patches[i];
+        desc.ops[patch->word].value |= (desc.blocks[patch->block].start - patch->insn) & 0xffffu;
+    }
+
+    key_list_t keys = { NULL, 0, 0 };
+    if (struct_has_key(struct_def) && !desc.out_of_memory) {
+        key_path_t root;
+        memset(&root, 0, sizeof(root));
+        collect_keys(&desc, struct_def, &root, &keys);
+    }
+    uint32_t *key_offsets = calloc(keys.count ? keys.count : 1, sizeof(uint32_t));
+    if (!key_offsets) desc.out_of_memory = true;
+    for (size_t k = 0; k < keys.count && key_offsets; k++) {
+        key_offsets[k] = emit_opcode(&desc, DDS_OP_KOF | keys.keys[k].depth, keys.keys[k].name);
+        for (uint32_t d = 0; d < keys.keys[k].depth; d++) {
+            emit_word(&desc, keys.keys[k].ops[d], WORD_NUMBER, NULL);
+        }
+    }
+
+    if (desc.unsupported || desc.out_of_memory) {
+        fprintf(stderr, "  Warning: no topic descriptor for %s (%s)\n",
+                struct_def->name ? struct_def->name->identifier : "struct",
+                desc.out_of_memory ? "out of memory" : "type not supported by the opcode program");
+        free(key_offsets);
+        free(keys.keys);
+        descriptor_free(&desc);
+        return false;
+    }
+
+    c_layout_t layout;
+    struct_layout(&desc, struct_def, &layout, NULL);
+    uint32_t flagset = 0;
+    if (keys.count > 0 && cdr_key_fits(struct_def, JAVA_CDR_XCDR1, 16)) flagset |= DDS_TOPIC_FIXED_KEY;
+    if (keys.count > 0 && cdr_key_fits(struct_def, JAVA_CDR_XCDR2, 16)) flagset |= DDS_TOPIC_FIXED_KEY_XCDR2;
+    if (desc.contains_union) flagset |= DDS_TOPIC_CONTAINS_UNION;
+    if (desc.fixed_size) flagset |= DDS_TOPIC_FIXED_SIZE;
+
+    const char *name = struct_def->name ? struct_def->name->identifier : "struct";
+    char type_name[512];
+    scoped_name(type_name, sizeof(type_name), (const idl_node_t *)struct_def, name);
+
+    sb_append(sb, "\n");
+    sb_append(sb, "    /** dds_topic_descriptor_t contents as generated by idlc -l c (LP64 layout) */\n");
+    sb_append(sb, "    public static final class Descriptor {\n");
+    sb_appendf(sb, "        public static final String TYPE_NAME = \"%s\";\n", type_name);
+    sb_appendf(sb, "        public static final int SIZE = %" PRIu32 ";\n", layout.size);
+    sb_appendf(sb, "        public static final int ALIGN = %" PRIu32 ";\n", layout.align);
+    sb_appendf(sb, "        public static final int FLAGSET = 0x%02" PRIx32 ";\n", flagset);
+    sb_appendf(sb, "        public static final int NOPS = %" PRIu32 ";\n", nops);
+    sb_append(sb, "        public static final String[] KEY_NAMES = {");
+    for (size_t k = 0; k < keys.count; k++) sb_appendf(sb, "%s\"%s\"", k ? ", " : " ", keys.keys[k].name);
+    sb_append(sb, " };\n");
+    sb_append(sb, "        public static final int[] KEY_OFFSETS = {");
+    for (size_t k = 0; k < keys.count; k++) sb_appendf(sb, "%s%" PRIu32, k ? ", " : " ", key_offsets[k]);
+    sb_append(sb, " };\n");
+    sb_append(sb, "        public static final int[] KEY_INDICES = {");
+    for (size_t k = 0; k < keys.count; k++) sb_appendf(sb, "%s%zu", k ? ", " : " ", k);
+    sb_append(sb, " };\n");
+    append_ops(sb, &desc);
+    sb_append(sb, "\n");
+    sb_append(sb, "        private Descriptor() { }\n\n");
+    sb_append(sb, "        public static DdsTopicDescriptor create() {\n");
+    sb_append(sb, "            return new DdsTopicDescriptor(TYPE_NAME, SIZE, ALIGN, FLAGSET, KEY_NAMES, KEY_OFFSETS, KEY_INDICES, NOPS, OPS);\n");
+    sb_append(sb, "        }\n");
+    sb_append(sb, "    }\n");
+
+    free(key_offsets);
+    free(keys.keys);
+    descriptor_free(&desc);
+    return true;
+}
@@ -0,0 +1,708 @@
+/*
+ * Copyright (c) 2024 IDLC Java Generator Contributors
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License 1.0
+ * which is available at http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+
+/*
+ * XTypes TypeObjects and TypeIdentifiers computed at generation time.
+ *
+ * Each type gets a minimal and a complete TypeObject, serialized as XCDR2
+ * little-endian following the DDS-XTypes 1.3 Annex B definitions, and the
+ * matching equivalence hash: the first 14 bytes of the MD5 of that
+ * serialization. Types referenced by a TypeObject are identified by their own
+ * hash of the same kind, so the hashes are computed recursively. Primitives,
+ * strings and plain sequences and arrays are fully descriptive and identified
+ * inline. Recursive types would need the strongly connected component hashes
+ * of XTypes 7.3.4.9, which are not implemented: they get no TypeObjects.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "idlc_java.h"
+
+typedef struct string_builder string_builder_t;
+
+extern int sb_append(string_builder_t *sb, const char *str);
+extern int sb_appendf(string_builder_t *sb, const char *format, ...);
+
+extern int64_t case_label_value(const idl_const_expr_t *const_expr);
+extern const idl_type_spec_t *java_resolve_forward(const idl_type_spec_t *type_spec);
+
+/* TypeKind / TypeIdentifier discriminators */
+#define TK_NONE                  0x00
+#define TK_BOOLEAN               0x01
+#define TK_BYTE                  0x02
+#define TK_INT16                 0x03
+#define TK_INT32                 0x04
+#define TK_INT64                 0x05
+#define TK_UINT16                0x06
+#define TK_UINT32                0x07
+#define TK_UINT64                0x08
+#define TK_FLOAT32               0x09
+#define TK_FLOAT64               0x0a
+#define TK_FLOAT128              0x0b
+#define TK_INT8                  0x0c
+#define TK_UINT8                 0x0d
+#define TK_CHAR8                 0x10
+#define TK_CHAR16                0x11
+#define TK_ALIAS                 0x30
+#define TK_ENUM                  0x40
+#define TK_BITMASK               0x41
+#define TK_STRUCTURE             0x51
+#define TK_UNION                 0x52
+#define TI_STRING8_SMALL         0x70
+#define TI_STRING8_LARGE         0x71
+#define TI_STRING16_SMALL        0x72
+#define TI_STRING16_LARGE        0x73
+#define TI_PLAIN_SEQUENCE_SMALL  0x80
+#define TI_PLAIN_SEQUENCE_LARGE  0x81
+#define TI_PLAIN_ARRAY_SMALL     0x90
+#define TI_PLAIN_ARRAY_LARGE     0x91
+#define EK_MINIMAL               0xf1
+#define EK_COMPLETE              0xf2
+#define EK_BOTH                  0xf3
+
+/* MemberFlag / TypeFlag bits */
+#define TRY_CONSTRUCT1           (1u << 0)
+#define IS_EXTERNAL              (1u << 2)
+#define IS_OPTIONAL              (1u << 3)
+#define IS_MUST_UNDERSTAND       (1u << 4)
+#define IS_KEY                   (1u << 5)
+#define IS_DEFAULT               (1u << 6)
+#define IS_FINAL                 (1u << 0)
+#define IS_APPENDABLE            (1u << 1)
+#define IS_MUTABLE               (1u << 2)
+#define IS_NESTED                (1u << 3)
+
+typedef enum xt_kind {
+    XT_MINIMAL,
+    XT_COMPLETE
+} xt_kind_t;
+
+/* ---- MD5 (RFC 1321) ------------------------------------------------------ */
+
+typedef struct md5_state {
+    uint32_t a, b, c, d;
+    uint64_t length;
+    unsigned char block[64];
+} md5_state_t;
+
+static const uint32_t md5_k[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const unsigned char md5_r[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static void md5_block(md5_state_t *md5, const unsigned char *block) {
+    uint32_t w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] | (uint32_t)block[i * 4 + 1] << 8 |
+               (uint32_t)block[i * 4 + 2] << 16 | (uint32_t)block[i * 4 + 3] << 24;
+    }
+
+    uint32_t a = md5->a, b = md5->b, c = md5->c, d = md5->d;
+    for (int i = 0; i < 64; i++) {
+        uint32_t f;
+        int g;
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) & 15;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) & 15;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) & 15;
+        }
+        uint32_t rotated = a + f + md5_k[i] + w[g];
+        a = d;
+        d = c;
+        c = b;
+        b += (rotated << md5_r[i]) | (rotated >> (32 - md5_r[i]));
+    }
+    md5->a += a;
+    md5->b += b;
+    md5->c += c;
+    md5->d += d;
+}
+
+static void md5(const unsigned char *data, size_t size, unsigned char digest[16]) {
+    md5_state_t state = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0, { 0 } };
+
+    state.length = (uint64_t)size * 8;
+    for (; size >= 64; data += 64, size -= 64) md5_block(&state, data);
+
+    memcpy(state.block, data, size);
+    state.block[size++] = 0x80;
+    if (size > 56) {
+        memset(state.block + size, 0, 64 - size);
+        md5_block(&state, state.block);
+        size = 0;
+    }
+    memset(state.block + size, 0, 56 - size);
+    for (int i = 0; i < 8; i++) state.block[56 + i] = (unsigned char)(state.length >> (8 * i));
+    md5_block(&state, state.block);
+
+    uint32_t words[4] = { state.a, state.b, state.c, state.d };
+    for (int i = 0; i < 16; i++) digest[i] = (unsigned char)(words[i / 4] >> (8 * (i % 4)));
+}
+
+/* ---- XCDR2 little-endian writer ----------------------------------------- */
+
+/* Types whose TypeObject is being serialized, innermost first */
+typedef struct xt_visit {
+    const idl_type_spec_t *type_spec;
+    const struct xt_visit *outer;
+} xt_visit_t;
+
+typedef struct xt_buffer {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    bool failed;
+    const xt_visit_t *visiting;
+} xt_buffer_t;
+
+static void put_bytes(xt_buffer_t *buf, const void *bytes, size_t count) {
+    if (buf->failed || count == 0) return;
+    if (buf->size + count > buf->capacity) {
+        size_t capacity = buf->capacity ? buf->capacity : 256;
+        while (capacity < buf->size + count) capacity *= 2;
+        unsigned char *data = realloc(buf->data, capacity);
+        if (!data) {
+            buf->failed = true;
+            return;
+        }
+        buf->data = data;
+        buf->capacity = capacity;
+    }
+    memcpy(buf->data + buf->size, bytes, count);
+    buf->size += count;
+}
+
+/* XCDR2 aligns to at most 4 bytes, relative to the start of the stream */
+static void put_align(xt_buffer_t *buf, size_t align) {
+    static const unsigned char zeros[4] = { 0 };
+    put_bytes(buf, zeros, (align - (buf->size & (align - 1))) & (align - 1));
+}
+
+static void put_u8(xt_buffer_t *buf, uint8_t value) {
+    put_bytes(buf, &value, 1);
+}
+
+static void put_u16(xt_buffer_t *buf, uint16_t value) {
+    unsigned char bytes[2] = { (unsigned char)value, (unsigned char)(value >> 8) };
+    put_align(buf, 2);
+    put_bytes(buf, bytes, 2);
+}
+
+static void put_u32(xt_buffer_t *buf, uint32_t value) {
+    unsigned char bytes[4] = {
+        (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24)
+    };
+    put_align(buf, 4);
+    put_bytes(buf, bytes, 4);
+}
+
+static void put_string(xt_buffer_t *buf, const char *str) {
+    size_t len = strlen(str);
+    put_u32(buf, (uint32_t)len + 1);
+    put_bytes(buf, str, len + 1);
+}
+
+/* Absent @optional member: XCDR2 writes only the presence flag */
+static void put_absent(xt_buffer_t *buf) {
+    put_u8(buf, 0);
+}
+
+/* DHEADER of an appendable struct or a sequence of non-primitives */
+static size_t begin_dheader(xt_buffer_t *buf) {
+    put_u32(buf, 0);
+    return buf->size;
+}
+
+static void end_dheader(xt_buffer_t *buf, size_t start) {
+    if (buf->failed) return;
+    uint32_t length = (uint32_t)(buf->size - start);
+    for (int i = 0; i < 4; i++) buf->data[start - 4 + i] = (unsigned char)(length >> (8 * i));
+}
+
+/* ---- names --------------------------------------------------------------- */
+
+static const char *identifier_or(const idl_name_t *name, const char *fallback) {
+    return name && name->identifier ? name->identifier : fallback;
+}
+
+/* Fully qualified IDL name, "Module::Type" */
+static void put_qualified_name(xt_buffer_t *buf, const idl_node_t *scope, const char *name) {
+    char qualified[1024];
+    const char *modules[32];
+    int depth = 0;
+
+    for (const idl_node_t *node = scope->parent; node && depth < 32; node = node->parent) {
+        if (idl_mask(node) & IDL_MODULE) modules[depth++] = identifier_or(((const idl_module_t *)node)->name, "");
+    }
+    qualified[0] = '\0';
+    while (depth-- > 0) {
+        strncat(qualified, modules[depth], sizeof(qualified) - strlen(qualified) - 1);
+        strncat(qualified, "::", sizeof(qualified) - strlen(qualified) - 1);
+    }
+    strncat(qualified, name, sizeof(qualified) - strlen(qualified) - 1);
+    put_string(buf, qualified);
+}
+
+/* CompleteTypeDetail: no builtin or custom annotations, then the type name */
+static void put_type_detail(xt_buffer_t *buf, xt_kind_t kind, const idl_node_t *scope, const char *name) {
+    if (kind == XT_MINIMAL) return;
+    put_absent(buf);
+    put_absent(buf);
+    put_qualified_name(buf, scope, name);
+}
+
+/* CompleteMemberDetail carries the name, MinimalMemberDetail its 4-byte MD5 */
+static void put_member_detail(xt_buffer_t *buf, xt_kind_t kind, const char *name) {
+    if (kind == XT_MINIMAL) {
+        unsigned char digest[16];
+        md5((const unsigned char *)name, strlen(name), digest);
+        put_bytes(buf, digest, 4);
+    } else {
+        put_string(buf, name);
+        put_absent(buf);
+        put_absent(buf);
+    }
+}
+
+/* ---- TypeIdentifier ------------------------------------------------------ */
+
+static void put_type_object(xt_buffer_t *buf, const idl_type_spec_t *type_spec, xt_kind_t kind);
+
+static uint8_t primitive_kind(idl_type_t type) {
+    switch (type) {
+        case IDL_BOOL: return TK_BOOLEAN;
+        case IDL_OCTET: return TK_BYTE;
+        case IDL_CHAR: return TK_CHAR8;
+        case IDL_WCHAR: return TK_CHAR16;
+        case IDL_INT8: return TK_INT8;
+        case IDL_UINT8: return TK_UINT8;
+        case IDL_SHORT:
+        case IDL_INT16: return TK_INT16;
+        case IDL_USHORT:
+        case IDL_UINT16: return TK_UINT16;
+        case IDL_LONG:
+        case IDL_INT32: return TK_INT32;
+        case IDL_ULONG:
+        case IDL_UINT32: return TK_UINT32;
+        case IDL_LLONG:
+        case IDL_INT64: return TK_INT64;
+        case IDL_ULLONG:
+        case IDL_UINT64: return TK_UINT64;
+        case IDL_FLOAT: return TK_FLOAT32;
+        case IDL_DOUBLE: return TK_FLOAT64;
+        case IDL_LDOUBLE: return TK_FLOAT128;
+        default: return TK_NONE;
+    }
+}
+
+/* Primitives, strings and plain collections of them need no TypeObject */
+static bool fully_descriptive(const idl_type_spec_t *type_spec) {
+    idl_type_t type = idl_type(type_spec);
+    if (primitive_kind(type) != TK_NONE || type == IDL_STRING || type == IDL_WSTRING) return true;
+    if (type == IDL_SEQUENCE) return fully_descriptive(((const idl_sequence_t *)type_spec)->type_spec);
+    return false;
+}
+
+/*
+ * Equivalence hash of a type: MD5 of its serialized TypeObject, truncated.
+ * Fails for a type that is already being serialized further out in outer.
+ */
+static bool type_hash(const xt_buffer_t *outer, const idl_type_spec_t *type_spec, xt_kind_t kind, unsigned char hash[14]) {
+    for (const xt_visit_t *visit = outer->visiting; visit; visit = visit->outer) {
+        if (visit->type_spec == type_spec) return false;
+    }
+    xt_visit_t visit = { type_spec, outer->visiting };
+    xt_buffer_t buf = { NULL, 0, 0, false, &visit };
+    put_type_object(&buf, type_spec, kind);
+    if (buf.failed) {
+        free(buf.data);
+        return false;
+    }
+    unsigned char digest[16];
+    md5(buf.data, buf.size, digest);
+    memcpy(hash, digest, 14);
+    free(buf.data);
+    return true;
+}
+
+static void put_type_identifier(xt_buffer_t *buf, const idl_type_spec_t *type_spec, xt_kind_t kind) {
+    type_spec = java_resolve_forward(type_spec);
+    if (!type_spec) {
+        buf->failed = true;
+        return;
+    }
+    idl_type_t type = idl_type(type_spec);
+    uint8_t primitive = primitive_kind(type);
+
+    if (primitive != TK_NONE) {
+        put_u8(buf, primitive);
+        return;
+    }
+    switch (type) {
+        case IDL_STRING:
+        case IDL_WSTRING: {
+            uint32_t bound = ((const idl_string_t *)type_spec)->maximum;
+            bool wide = type == IDL_WSTRING;
+            if (bound < 256) {
+                put_u8(buf, wide ? TI_STRING16_SMALL : TI_STRING8_SMALL);
+                put_u8(buf, (uint8_t)bound);
+            } else {
+                put_u8(buf, wide ? TI_STRING16_LARGE : TI_STRING8_LARGE);
+                put_u32(buf, bound);
+            }
+            return;
+        }
+        case IDL_SEQUENCE: {
+            const idl_sequence_t *seq = (const idl_sequence_t *)type_spec;
+            bool small = seq->maximum < 256;
+            put_u8(buf, small ? TI_PLAIN_SEQUENCE_SMALL : TI_PLAIN_SEQUENCE_LARGE);
+            put_u8(buf, fully_descriptive(seq->type_spec) ? EK_BOTH : kind == XT_MINIMAL ? EK_MINIMAL : EK_COMPLETE);
+            put_u16(buf, TRY_CONSTRUCT1);
+            if (small) {
+                put_u8(buf, (uint8_t)seq->maximum);
+            } else {
+                put_u32(buf, seq->maximum);
+            }
+            put_type_identifier(buf, seq->type_spec, kind);
+            return;
+        }
+        case IDL_STRUCT:
+        case IDL_UNION:
+        case IDL_ENUM:
+        case IDL_BITMASK:
+        case IDL_TYPEDEF: {
+            unsigned char hash[14];
+            if (!type_hash(buf, type_spec, kind, hash)) {
+                buf->failed = true;
+                return;
+            }
+            put_u8(buf, kind == XT_MINIMAL ? EK_MINIMAL : EK_COMPLETE);
+            put_bytes(buf, hash, sizeof(hash));
+            return;
+        }
+        default:
+            buf->failed = true;
+            return;
+    }
+}
+
+/* TypeIdentifier of a member or alias, a plain array of type_spec if the declarator has dimensions */
+static void put_declarator_identifier(xt_buffer_t *buf, const idl_declarator_t *declarator, const idl_type_spec_t *type_spec, xt_kind_t kind) {
+    if (!declarator || !idl_is_array(declarator)) {
+        put_type_identifier(buf, type_spec, kind);
+        return;
+    }
+
+    uint32_t dimensions = 0;
+    bool small = true;
+    for (const idl_node_t *dim = (const idl_node_t *)declarator->const_expr; dim; dim = dim->next) {
+        if (((const idl_literal_t *)dim)->value.uint32 >= 256) small = false;
+        dimensions++;
+    }
+    put_u8(buf, small ? TI_PLAIN_ARRAY_SMALL : TI_PLAIN_ARRAY_LARGE);
+    put_u8(buf, fully_descriptive(type_spec) ? EK_BOTH : kind == XT_MINIMAL ? EK_MINIMAL : EK_COMPLETE);
+    put_u16(buf, TRY_CONSTRUCT1);
+    put_u32(buf, dimensions);
+    for (const idl_node_t *dim = (const idl_node_t *)declarator->const_expr; dim; dim = dim->next) {
+        uint32_t bound = ((const idl_literal_t *)dim)->value.uint32;
+        if (small) {
+            put_u8(buf, (uint8_t)bound);
+        } else {
+            put_u32(buf, bound);
+        }
+    }
+    put_type_identifier(buf, type_spec, kind);
+}
+
+/* ---- TypeObject bodies --------------------------------------------------- */
+
+static uint16_t extensibility_flags(idl_extensibility_t extensibility) {
+    switch (extensibility) {
+        case IDL_APPENDABLE: return IS_APPENDABLE;
+        case IDL_MUTABLE: return IS_MUTABLE;
+        default: return IS_FINAL;
+    }
+}
+
+static void put_struct_type(xt_buffer_t *buf, const idl_struct_t *struct_def, xt_kind_t kind) {
+    uint16_t flags = extensibility_flags(struct_def->extensibility.value);
+    if (struct_def->nested.value) flags |= IS_NESTED;
+    put_u16(buf, flags);
+
+    size_t header = begin_dheader(buf);
+    if (struct_def->inherit_spec && struct_def->inherit_spec->base) {
+        put_type_identifier(buf, struct_def->inherit_spec->base, kind);
+    } else {
+        put_u8(buf, TK_NONE);
+    }
+    put_type_detail(buf, kind, (const idl_node_t *)struct_def, identifier_or(struct_def->name, ""));
+    end_dheader(buf, header);
+
+    uint32_t count = 0;
+    for (const idl_member_t *member = struct_def->members; member; member = (const idl_member_t *)((const idl_node_t *)member)->next) {
+        for (const idl_declarator_t *decl = member->declarators; decl; decl = (const idl_declarator_t *)((const idl_node_t *)decl)->next) {
+            count++;
+        }
+    }
+
+    size_t members = begin_dheader(buf);
+    put_u32(buf, count);
+    for (const idl_member_t *member = struct_def->members; member; member = (const idl_member_t *)((const idl_node_t *)member)->next) {
+        uint16_t member_flags = TRY_CONSTRUCT1;
+        if (member->key.value) member_flags |= IS_KEY | IS_MUST_UNDERSTAND;
+        if (member->optional.value) member_flags |= IS_OPTIONAL;
+        if (member->external.value) member_flags |= IS_EXTERNAL;
+
+        for (const idl_declarator_t *decl = member->declarators; decl; decl = (const idl_declarator_t *)((const idl_node_t *)decl)->next) {
+            size_t element = begin_dheader(buf);
+            put_u32(buf, decl->id.value);
+            put_u16(buf, member_flags);
+            put_declarator_identifier(buf, decl, member->type_spec, kind);
+            put_member_detail(buf, kind, identifier_or(decl->name, ""));
+            end_dheader(buf, element);
+        }
+    }
+    end_dheader(buf, members);
+}
+
+static bool is_default_case(const idl_case_t *case_def) {
+    for (const idl_case_label_t *label = case_def->labels; label; label = (const idl_case_label_t *)((const idl_node_t *)label)->next) {
+        if (!label->const_expr) return true;
+    }
+    return false;
+}
+
+static void put_union_type(xt_buffer_t *buf, const idl_union_t *union_def, xt_kind_t kind) {
+    put_u16(buf, extensibility_flags(union_def->extensibility.value));
+
+    size_t header = begin_dheader(buf);
+    put_type_detail(buf, kind, (const idl_node_t *)union_def, identifier_or(union_def->name, ""));
+    end_dheader(buf, header);
+
+    size_t discriminator = begin_dheader(buf);
+    uint16_t discriminator_flags = TRY_CONSTRUCT1;
+    if (union_def->switch_type_spec->key.value) discriminator_flags |= IS_KEY | IS_MUST_UNDERSTAND;
+    put_u16(buf, discriminator_flags);
+    put_type_identifier(buf, union_def->switch_type_spec->type_spec, kind);
+    if (kind == XT_COMPLETE) {
+        put_absent(buf);
+        put_absent(buf);
+    }
+    end_dheader(buf, discriminator);
+
+    uint32_t count = 0;
+    for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
+        count++;
+    }
+
+    size_t members = begin_dheader(buf);
+    put_u32(buf, count);
+    for (const idl_case_t *case_def = union_def->cases; case_def; case_def = (const idl_case_t *)((const idl_node_t *)case_def)->next) {
+        size_t element = begin_dheader(buf);
+        put_u32(buf, case_def->declarator ? case_def->declarator->id.value : 0);
+        put_u16(buf, TRY_CONSTRUCT1 | (is_default_case(case_def) ? IS_DEFAULT : 0));
+        put_declarator_identifier(buf, case_def->declarator, case_def->type_spec, kind);
+
+        uint32_t labels = 0;
+        for (const idl_case_label_t *label = case_def->labels; label; label = (const idl_case_label_t *)((const idl_node_t *)label)->next) {
+            if (label->const_expr) labels++;
+        }
+        put_u32(buf, labels);
+        for (const idl_case_label_t *label = case_def->labels; label; label = (const idl_case_label_t *)((const idl_node_t *)label)->next) {
+            if (label->const_expr) put_u32(buf, (uint32_t)(int32_t)case_label_value(label->const_expr));
+        }
+
+        put_member_detail(buf, kind, case_def->declarator ? identifier_or(case_def->declarator->name, "") : "");
+        end_dheader(buf, element);
+    }
+    end_dheader(buf, members);
+}
+
+static void put_enum_type(xt_buffer_t *buf, const idl_enum_t *enum_def, xt_kind_t kind) {
+    const idl_enumerator_t *default_enumerator = enum_def->default_enumerator ? enum_def->default_enumerator : enum_def->enumerators;
+
+    put_u16(buf, 0);
+
+    size_t header = begin_dheader(buf);
+    put_u16(buf, enum_def->bit_bound.value ? enum_def->bit_bound.value : 32);
+    put_type_detail(buf, kind, (const idl_node_t *)enum_def, identifier_or(enum_def->name, ""));
+    end_dheader(buf, header);
+
+    uint32_t count = 0;
+    for (const idl_enumerator_t *e = enum_def->enumerators; e; e = (const idl_enumerator_t *)((const idl_node_t *)e)->next) {
+        count++;
+    }
+
+    size_t literals = begin_dheader(buf);
+    put_u32(buf, count);
+    for (const idl_enumerator_t *e = enum_def->enumerators; e; e = (const idl_enumerator_t *)((const idl_node_t *)e)->next) {
+        size_t element = begin_dheader(buf);
+        put_u32(buf, e->value.value);
+        put_u16(buf, e == default_enumerator ? IS_DEFAULT : 0);
+        put_member_detail(buf, kind, identifier_or(e->name, ""));
+        end_dheader(buf, element);
+    }
+    end_dheader(buf, literals);
+}
+
+static void put_bitmask_type(xt_buffer_t *buf, const idl_bitmask_t *bitmask_def, xt_kind_t kind) {
+    put_u16(buf, 0);
+
+    size_t header = begin_dheader(buf);
+    put_u16(buf, bitmask_def->bit_bound.value ? bitmask_def->bit_bound.value : 32);
+    put_type_detail(buf, kind, (const idl_node_t *)bitmask_def, identifier_or(bitmask_def->name, ""));
+    end_dheader(buf, header);
+
+    uint32_t count = 0;
+    for (const idl_bit_value_t *bit = bitmask_def->bit_values; bit; bit = (const idl_bit_value_t *)((const idl_node_t *)bit)->next) {
+        count++;
+    }
+
+    size_t flags = begin_dheader(buf);
+    put_u32(buf, count);
+    for (const idl_bit_value_t *bit = bitmask_def->bit_values; bit; bit = (const idl_bit_value_t *)((const idl_node_t *)bit)->next) {
+        size_t element = begin_dheader(buf);
+        put_u16(buf, bit->position.value);
+        put_u16(buf, 0);
+        put_member_detail(buf, kind, identifier_or(bit->name, ""));
+        end_dheader(buf, element);
+    }
+    end_dheader(buf, flags);
+}
+
+/* type_spec is the typedef's declarator, as it appears at use sites */
+static void put_alias_type(xt_buffer_t *buf, const idl_declarator_t *declarator, xt_kind_t kind) {
+    const idl_typedef_t *typedef_def = (const idl_typedef_t *)((const idl_node_t *)declarator)->parent;
+
+    put_u16(buf, 0);
+
+    size_t header = begin_dheader(buf);
+    put_type_detail(buf, kind, (const idl_node_t *)typedef_def, identifier_or(declarator->name, ""));
+    end_dheader(buf, header);
+
+    size_t body = begin_dheader(buf);
+    put_u16(buf, 0);
+    put_declarator_identifier(buf, declarator, typedef_def->type_spec, kind);
+    if (kind == XT_COMPLETE) {
+        put_absent(buf);
+        put_absent(buf);
+    }
+    end_dheader(buf, body);
+}
+
+/* TypeObject: an appendable union of the complete and minimal forms */
+static void put_type_object(xt_buffer_t *buf, const idl_type_spec_t *type_spec, xt_kind_t kind) {
+    size_t start = begin_dheader(buf);
+    put_u8(buf, kind == XT_MINIMAL ? EK_MINIMAL : EK_COMPLETE);
+    switch (idl_type(type_spec)) {
+        case IDL_STRUCT:
+            put_u8(buf, TK_STRUCTURE);
+            put_struct_type(buf, (const idl_struct_t *)type_spec, kind);
+            break;
+        case IDL_UNION:
+            put_u8(buf, TK_UNION);
+            put_union_type(buf, (const idl_union_t *)type_spec, kind);
+            break;
+        case IDL_ENUM:
+            put_u8(buf, TK_ENUM);
+            put_enum_type(buf, (const idl_enum_t *)type_spec, kind);
+            break;
+        case IDL_BITMASK:
+            put_u8(buf, TK_BITMASK);
+            put_bitmask_type(buf, (const idl_bitmask_t *)type_spec, kind);
+            break;
+        case IDL_TYPEDEF:
+            put_u8(buf, TK_ALIAS);
+            put_alias_type(buf, (const idl_declarator_t *)type_spec, kind);
+            break;
+        default:
+            buf->failed = true;
+            break;
+    }
+    end_dheader(buf, start);
+}
+
+/* ---- Java constants ------------------------------------------------------ */
+
+static void append_byte_array(string_builder_t *sb, const char *name, const unsigned char *data, size_t size) {
+    sb_appendf(sb, "        public static final byte[] %s = {", name);
+    for (size_t i = 0; i < size; i++) {
+        if (i % 12 == 0) sb_append(sb, "\n           ");
+        if (data[i] < 0x80) {
+            sb_appendf(sb, " 0x%02x%s", data[i], i + 1 < size ? "," : "");
+        } else {
+            sb_appendf(sb, " (byte) 0x%02x%s", data[i], i + 1 < size ? "," : "");
+        }
+    }
+    sb_append(sb, "\n        };\n");
+}
+
+/*
+ * Nested TypeObjects class holding the TypeIdentifiers (EK_* followed by the
+ * 14-byte hash) and serialized TypeObjects of a type. It is only loaded on
+ * first use, so types that are never registered cost nothing at startup.
+ */
+int generate_type_object_constants(string_builder_t *sb, const idl_type_spec_t *type_spec) {
+    xt_visit_t visit = { type_spec, NULL };
+    xt_buffer_t objects[2] = { { NULL, 0, 0, false, &visit }, { NULL, 0, 0, false, &visit } };
+    unsigned char ids[2][15];
+    int ret = 0;
+
+    for (int kind = XT_MINIMAL; kind <= XT_COMPLETE && ret == 0; kind++) {
+        put_type_object(&objects[kind], type_spec, (xt_kind_t)kind);
+        if (objects[kind].failed) {
+            ret = -1;
+            break;
+        }
+        unsigned char digest[16];
+        md5(objects[kind].data, objects[kind].size, digest);
+        ids[kind][0] = kind == XT_MINIMAL ? EK_MINIMAL : EK_COMPLETE;
+        memcpy(ids[kind] + 1, digest, 14);
+    }
+
+    if (ret == 0) {
+        sb_append(sb, "    public static final class TypeObjects {\n");
+        append_byte_array(sb, "MINIMAL_TYPE_ID", ids[XT_MINIMAL], sizeof(ids[XT_MINIMAL]));
+        append_byte_array(sb, "COMPLETE_TYPE_ID", ids[XT_COMPLETE], sizeof(ids[XT_COMPLETE]));
+        append_byte_array(sb, "MINIMAL_TYPE_OBJECT", objects[XT_MINIMAL].data, objects[XT_MINIMAL].size);
+        append_byte_array(sb, "COMPLETE_TYPE_OBJECT", objects[XT_COMPLETE].data, objects[XT_COMPLETE].size);
+        sb_append(sb, "\n        private TypeObjects() { }\n");
+        sb_append(sb, "    }\n\n");
+    }
+
+    free(objects[XT_MINIMAL].data);
+    free(objects[XT_COMPLETE].data);
+    return ret;
+}
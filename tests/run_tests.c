@@ -10,6 +10,7 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#include <utime.h>
 
 #define TEST_IDLC "/opt/cyclonedds/bin/idlc"
 #define TEST_PLUGIN_DIR "/home/stuart/repos/idlc2java/build"
@@ -48,6 +49,21 @@ int count_files_in_dir(const char *dir) {
     return count;
 }
 
+int file_contains(const char *path, const char *needle) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    char buf[512];
+    int found = 0;
+    while (fgets(buf, sizeof(buf), f)) {
+        if (strstr(buf, needle)) {
+            found = 1;
+            break;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
 int test_plugin_loading(void) {
     printf("=== Test: Plugin Loading ===\n");
     
@@ -175,6 +191,384 @@ int test_struct_has_describe_type(void) {
     return found ? 0 : -1;
 }
 
+int test_struct_has_serialized_size(void) {
+    printf("\n=== Test: Struct has getSerializedSize() ===\n");
+    
+    const char *path = "/tmp/idlc_test_shapes/Shapes/Circle.java";
+    int found = file_contains(path, "public int getSerializedSize()") &&
+                file_contains(path, "ByteBuffer.allocate(getSerializedSize())") &&
+                !file_contains(path, "ByteBuffer.allocate(256)");
+    
+    printf("%s\n", found ? "✓ Exact-size serialize()" : "✗ serialize() not exact-size");
+    return found ? 0 : -1;
+}
+
+int test_struct_has_serialize_into(void) {
+    printf("\n=== Test: Struct has serializeInto() ===\n");
+    
+    const char *path = "/tmp/idlc_test_shapes/Shapes/Circle.java";
+    int found = file_contains(path, "public void serializeInto(ByteBuffer buffer)") &&
+                file_contains(path, "center.serializeInto(buffer);") &&
+                !file_contains(path, "buffer.put(center.serialize())");
+    
+    printf("%s\n", found ? "✓ Nested members write into parent buffer" : "✗ Missing serializeInto()");
+    return found ? 0 : -1;
+}
+
+int test_struct_has_deserialize_from(void) {
+    printf("\n=== Test: Struct has deserializeFrom() ===\n");
+    
+    const char *path = "/tmp/idlc_test_shapes/Shapes/SequenceStruct.java";
+    int found = file_contains(path, "public void deserializeFrom(ByteBuffer buffer)") &&
+                file_contains(path, "elem.deserializeFrom(buffer);") &&
+                !file_contains(path, "new byte[buffer.remaining()]");
+    
+    printf("%s\n", found ? "✓ Nested members read from parent buffer" : "✗ Missing deserializeFrom()");
+    return found ? 0 : -1;
+}
+
+int test_cdr_runtime(void) {
+    printf("\n=== Test: Shared CDR runtime ===\n");
+    
+    const char *runtime = "/tmp/idlc_test_shapes/org/eclipse/cyclonedds/java/cdr";
+    char writer[256], reader[256];
+    snprintf(writer, sizeof(writer), "%s/CdrWriter.java", runtime);
+    snprintf(reader, sizeof(reader), "%s/CdrReader.java", runtime);
+    const char *path = "/tmp/idlc_test_shapes/Shapes/Circle.java";
+    int found = file_contains(writer, "public static void writePackedString(ByteBuffer buffer, String value)") &&
+                file_contains(reader, "public static String readPackedString(ByteBuffer buffer)") &&
+                file_contains(path, "import org.eclipse.cyclonedds.java.cdr.CdrWriter;") &&
+                file_contains(path, "CdrWriter.writePackedString(buffer, color);") &&
+                file_contains(path, "color = CdrReader.readPackedString(buffer);") &&
+                !file_contains(path, "private static int utf8Length(String s)");
+    
+    printf("%s\n", found ? "✓ Codecs call the shared runtime" : "✗ Codec helpers inlined per class");
+    return found ? 0 : -1;
+}
+
+int test_deserialize_reuse(void) {
+    printf("\n=== Test: deserialize(ByteBuffer, reuse) ===\n");
+    
+    const char *path = "/tmp/idlc_test_shapes/Shapes/SequenceStruct.java";
+    int found = file_contains(path, "public static SequenceStruct deserialize(ByteBuffer buffer, SequenceStruct reuse)") &&
+                file_contains(path, "ByteBuffer payload = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN);") &&
+                file_contains(path, "pointList = CdrReader.reuseList(pointList, len, true);") &&
+                file_contains(path, "intList = CdrReader.reuseList(intList, len, false);") &&
+                file_contains(path, "Point elem = i < kept ? pointList.get(i) : null;") &&
+                !file_contains(path, "Point elem = new Point();");
+    
+    printf("%s\n", found ? "✓ Lists and elements refilled in place" : "✗ deserialize() does not reuse");
+    return found ? 0 : -1;
+}
+
+int test_method_splitting(void) {
+    printf("\n=== Test: Oversized Methods Split ===\n");
+    
+    const char *idl = "/tmp/idlc_test_wide.idl";
+    FILE *f = fopen(idl, "w");
+    if (!f) {
+        printf("✗ Could not write %s\n", idl);
+        return -1;
+    }
+    fprintf(f, "module Wide {\n  struct Wide {\n");
+    for (int i = 0; i < 300; i++) {
+        fprintf(f, "    %s m%d;\n", i % 2 ? "string" : "sequence<long>", i);
+    }
+    fprintf(f, "  };\n};\n");
+    fclose(f);
+    
+    char command[1024];
+    snprintf(command, sizeof(command),
+        "LD_LIBRARY_PATH=%s %s -l java -o /tmp/idlc_test_wide %s 2>&1",
+        TEST_PLUGIN_DIR, TEST_IDLC, idl);
+    
+    if (run_command(command) != 0) {
+        printf("✗ Generation failed\n");
+        return -1;
+    }
+    
+    const char *path = "/tmp/idlc_test_wide/Wide/Wide.java";
+    int found = file_contains(path, "        serializePart0(buffer);") &&
+                file_contains(path, "    private void serializePart0(ByteBuffer buffer) {") &&
+                file_contains(path, "        deserializePart1(buffer);") &&
+                file_contains(path, "        size += sizePart0();") &&
+                !file_contains("/tmp/idlc_test_shapes/Shapes/Circle.java", "Part0(");
+    
+    printf("%s\n", found ? "✓ Long codec methods split into parts" : "✗ Codec methods not split");
+    return found ? 0 : -1;
+}
+
+int test_struct_key_hash(void) {
+    printf("\n=== Test: Keyed Struct has computeKeyHash() ===\n");
+    
+    const char *point = "/tmp/idlc_test_shapes/Shapes/Point.java";
+    const char *colored = "/tmp/idlc_test_shapes/Shapes/ColoredShape.java";
+    int found = file_contains(point, "public void serializeKey(ByteBuffer buffer)") &&
+                file_contains(point, "public byte[] computeKeyHash()") &&
+                !file_contains(point, "MessageDigest") &&
+                file_contains(colored, "MessageDigest.getInstance(\"MD5\")");
+    
+    printf("%s\n", found ? "✓ Key serialization and keyhash" : "✗ Missing key API");
+    return found ? 0 : -1;
+}
+
+int test_instance_cache(void) {
+    printf("\n=== Test: Keyed Topic has InstanceCache ===\n");
+    
+    const char *point = "/tmp/idlc_test_shapes/Shapes/Point.java";
+    const char *cache = "/tmp/idlc_test_shapes/Shapes/PointInstanceCache.java";
+    int found = file_contains(point, "public boolean keyEquals(Point other)") &&
+                file_contains(point, "public int keyHashCode()") &&
+                file_contains(cache, "private int[] xKeys;") &&
+                file_contains(cache, "public Point get(int x, int y)");
+    
+    printf("%s\n", found ? "✓ Key equality and instance cache" : "✗ Missing instance cache");
+    return found ? 0 : -1;
+}
+
+int test_key_list_equality(void) {
+    printf("\n=== Test: Element-wise key equality ===\n");
+    
+    const char *keys = "/tmp/idlc_test_shapes/org/eclipse/cyclonedds/java/cdr/CdrKeys.java";
+    const char *alias = "/tmp/idlc_test_shapes/Shapes/AliasKey.java";
+    const char *seq = "/tmp/idlc_test_shapes/Shapes/SequenceStruct.java";
+    const char *holder = "/tmp/idlc_test_shapes/Shapes/UnionHolder.java";
+    const char *shape = "/tmp/idlc_test_shapes/Shapes/ShapeValue.java";
+    int found = file_contains(keys, "public static <T> int hashCode(List<T> list, ToIntFunction<? super T> hash)") &&
+                file_contains(alias, "CdrKeys.hashCode(ids, e0 -> Integer.hashCode((e0 != null ? e0.value : 0)))") &&
+                file_contains(alias, "CdrKeys.equals(ids, other.ids, (a0, b0) -> (a0 != null ? a0.value : 0) == (b0 != null ? b0.value : 0))") &&
+                file_contains(seq, "CdrKeys.hashCode(pointList, e0 -> (e0 != null ? e0.keyHashCode() : 0))") &&
+                file_contains(holder, "(extendedUnion != null ? extendedUnion.keyHashCode() : 0)") &&
+                file_contains(shape, "public boolean keyEquals(ShapeValue other)") &&
+                !file_contains(seq, "java.util.Objects.equals(pointList, other.pointList)");
+    
+    printf("%s\n", found ? "✓ Key lists compared element by element" : "✗ Key lists compared by identity");
+    return found ? 0 : -1;
+}
+
+int test_type_object_constants(void) {
+    printf("\n=== Test: XTypes TypeObject constants ===\n");
+    
+    const char *path = "/tmp/idlc_test_shapes/Shapes/Point.java";
+    const char *tree = "/tmp/idlc_test_shapes/Shapes/TreeNode.java";
+    int found = file_contains(path, "public static final class TypeObjects {") &&
+                file_contains(path, "public static final byte[] MINIMAL_TYPE_ID = {") &&
+                file_contains(path, "public static final byte[] COMPLETE_TYPE_OBJECT = {") &&
+                file_contains(tree, "public java.util.List<TreeNode> children;") &&
+                !file_contains(tree, "class TypeObjects");
+    
+    printf("%s\n", found ? "✓ TypeObjects emitted" : "✗ TypeObjects missing");
+    return found ? 0 : -1;
+}
+
+int test_fixed_size_struct(void) {
+    printf("\n=== Test: Fixed-Size Struct Codec ===\n");
+    
+    const char *path = "/tmp/idlc_test_shapes/Shapes/Point.java";
+    int found = file_contains(path, "public static final int SERIALIZED_SIZE = 8;") &&
+                file_contains(path, "buffer.putInt(offset + 4, y);") &&
+                file_contains(path, "y = buffer.getInt(offset + 4);") &&
+                file_contains("/tmp/idlc_test_shapes/Shapes/Circle.java", "return false;");
+    
+    printf("%s\n", found ? "✓ Point uses constant-offset codec" : "✗ Fixed-size codec missing");
+    return found ? 0 : -1;
+}
+
+int test_use_arrays_option(void) {
+    printf("\n=== Test: java-use-arrays Option ===\n");
+    
+    char command[1024];
+    snprintf(command, sizeof(command),
+        "LD_LIBRARY_PATH=%s %s -l java -f java-use-arrays -o /tmp/idlc_test_arrays -I %s/examples/all-types %s/examples/all-types/shapes.idl 2>&1",
+        TEST_PLUGIN_DIR, TEST_IDLC, TEST_EXAMPLES_DIR, TEST_EXAMPLES_DIR);
+    
+    if (run_command(command) != 0) {
+        printf("✗ Generation failed\n");
+        return -1;
+    }
+    
+    const char *path = "/tmp/idlc_test_arrays/Shapes/Circle.java";
+    int found = file_contains(path, "public double[] points;") &&
+                file_contains(path, "buffer.asDoubleBuffer().put(points);");
+    
+    printf("%s\n", found ? "✓ Primitive sequences use arrays" : "✗ Primitive sequences still boxed");
+    return found ? 0 : -1;
+}
+
+int test_jobs_option(void) {
+    printf("\n=== Test: java-jobs Option ===\n");
+    
+    static const char *jobs[] = { "1", "4" };
+    char command[1024];
+    for (int i = 0; i < 2; i++) {
+        snprintf(command, sizeof(command),
+            "rm -rf /tmp/idlc_test_jobs%s && LD_LIBRARY_PATH=%s %s -l java -f java-jobs=%s -o /tmp/idlc_test_jobs%s -I %s/examples/all-types %s/examples/all-types/shapes.idl 2>&1",
+            jobs[i], TEST_PLUGIN_DIR, TEST_IDLC, jobs[i], jobs[i], TEST_EXAMPLES_DIR, TEST_EXAMPLES_DIR);
+        if (run_command(command) != 0) {
+            printf("✗ Generation with java-jobs=%s failed\n", jobs[i]);
+            return -1;
+        }
+    }
+    
+    int same = run_command("diff -r /tmp/idlc_test_jobs1 /tmp/idlc_test_jobs4 > /dev/null") == 0;
+    
+    printf("%s\n", same ? "✓ Parallel output matches single-threaded output" : "✗ Parallel output differs");
+    return same ? 0 : -1;
+}
+
+int test_incremental_output(void) {
+    printf("\n=== Test: Write-if-changed Output ===\n");
+    
+    const char *path = "/tmp/idlc_test_incremental/Shapes/Circle.java";
+    const char *stale = "/tmp/idlc_test_incremental/Shapes/Removed.java";
+    char command[1024];
+    snprintf(command, sizeof(command),
+        "LD_LIBRARY_PATH=%s %s -l java -o /tmp/idlc_test_incremental -I %s/examples/all-types %s/examples/all-types/shapes.idl 2>&1",
+        TEST_PLUGIN_DIR, TEST_IDLC, TEST_EXAMPLES_DIR, TEST_EXAMPLES_DIR);
+    
+    run_command("rm -rf /tmp/idlc_test_incremental");
+    if (run_command(command) != 0) {
+        printf("✗ Generation failed\n");
+        return -1;
+    }
+    
+    /* an unchanged file keeps its mtime, a file only the manifest knows is removed */
+    struct utimbuf epoch = { 0, 0 };
+    utime(path, &epoch);
+    FILE *f = fopen("/tmp/idlc_test_incremental/.idlc-java.manifest", "a");
+    if (f) {
+        fprintf(f, "0000000000000000 0 Shapes/Removed.java\n");
+        fclose(f);
+    }
+    f = fopen(stale, "w");
+    if (f) fclose(f);
+    
+    if (run_command(command) != 0) {
+        printf("✗ Second generation failed\n");
+        return -1;
+    }
+    
+    struct stat st;
+    int ok = stat(path, &st) == 0 && st.st_mtime == 0 && !file_exists(stale);
+    
+    printf("%s\n", ok ? "✓ Unchanged files kept, stale files removed" : "✗ Output rewritten or stale files kept");
+    return ok ? 0 : -1;
+}
+
+int test_deps_option(void) {
+    printf("\n=== Test: java-deps Option ===\n");
+    
+    const char *path = "/tmp/idlc_test_deps.json";
+    char command[1024];
+    snprintf(command, sizeof(command),
+        "LD_LIBRARY_PATH=%s %s -l java -f java-deps=%s -o /tmp/idlc_test_deps -I %s/examples/all-types %s/examples/all-types/shapes.idl 2>&1",
+        TEST_PLUGIN_DIR, TEST_IDLC, path, TEST_EXAMPLES_DIR, TEST_EXAMPLES_DIR);
+    
+    if (run_command(command) != 0) {
+        printf("✗ Generation failed\n");
+        return -1;
+    }
+    
+    int found = file_contains(path, "common_types.idl\" }") &&
+                file_contains(path, "\"name\": \"Shapes.ExtendedCircle\"") &&
+                file_contains(path, "\"references\": [\"Shapes.Circle\"") &&
+                file_contains(path, "\"Shapes/Circle.java\"");
+    
+    /* an unchanged graph is not rewritten */
+    struct utimbuf epoch = { 0, 0 };
+    utime(path, &epoch);
+    struct stat st;
+    found = found && run_command(command) == 0 && stat(path, &st) == 0 && st.st_mtime == 0;
+    
+    printf("%s\n", found ? "✓ Includes, type references and files listed" : "✗ Dependency graph incomplete");
+    return found ? 0 : -1;
+}
+
+int test_records_option(void) {
+    printf("\n=== Test: java-records Option ===\n");
+    
+    char command[1024];
+    snprintf(command, sizeof(command),
+        "LD_LIBRARY_PATH=%s %s -l java -f java-records -o /tmp/idlc_test_records -I %s/examples/all-types %s/examples/all-types/shapes.idl 2>&1",
+        TEST_PLUGIN_DIR, TEST_IDLC, TEST_EXAMPLES_DIR, TEST_EXAMPLES_DIR);
+    
+    if (run_command(command) != 0) {
+        printf("✗ Generation failed\n");
+        return -1;
+    }
+    
+    const char *path = "/tmp/idlc_test_records/Shapes/Circle.java";
+    int found = file_contains(path, "public final class Circle {") &&
+                file_contains(path, "public void serializeInto(ByteBuffer buffer)") &&
+                !file_contains(path, "com.sun.jna");
+    
+    printf("%s\n", found ? "✓ Plain final classes without JNA" : "✗ Still extends Structure");
+    return found ? 0 : -1;
+}
+
+int test_xcdr2_option(void) {
+    printf("\n=== Test: java-cdr=xcdr2 Option ===\n");
+    
+    char command[1024];
+    snprintf(command, sizeof(command),
+        "LD_LIBRARY_PATH=%s %s -l java -f java-cdr=xcdr2 -o /tmp/idlc_test_xcdr2 -I %s/examples/all-types %s/examples/all-types/shapes.idl 2>&1",
+        TEST_PLUGIN_DIR, TEST_IDLC, TEST_EXAMPLES_DIR, TEST_EXAMPLES_DIR);
+    
+    if (run_command(command) != 0) {
+        printf("✗ Generation failed\n");
+        return -1;
+    }
+    
+    const char *path = "/tmp/idlc_test_xcdr2/Shapes/Circle.java";
+    int found = file_contains(path, "buffer.putShort((short) 0x0007);") &&
+                file_contains(path, "public int serializedEnd(int pos)") &&
+                file_contains(path, "int end = start + 4 + payload.position() + (buffer.get(start + 3) & 3);");
+    
+    printf("%s\n", found ? "✓ XCDR2 encapsulation emitted" : "✗ XCDR2 encapsulation missing");
+    return found ? 0 : -1;
+}
+
+int test_xcdr2_mutable(void) {
+    printf("\n=== Test: java-cdr=xcdr2 Mutable Members ===\n");
+    
+    /* Length codes as the C serializer picks them: no NEXTINT for primitives, strings and sequences */
+    const char *path = "/tmp/idlc_test_xcdr2/Shapes/MutableShape.java";
+    int found = file_contains(path, "pos += 18;") &&
+                file_contains(path, "buffer.putInt(0xa0000000);  // EMHEADER id") &&
+                file_contains(path, "buffer.putInt(0x10000001);  // EMHEADER layer") &&
+                file_contains(path, "buffer.putInt(0x30000002);  // EMHEADER scale") &&
+                file_contains(path, "buffer.putInt(0x50000003);  // EMHEADER name") &&
+                file_contains(path, "buffer.putInt(0x60000004);  // EMHEADER points") &&
+                file_contains(path, "buffer.putInt(0x40000005);  // EMHEADER origin") &&
+                file_contains(path, "int memberSize = CdrReader.memberSize(buffer, emheader);") &&
+                file_contains(path, "int memberEnd = buffer.position() + memberSize;");
+    
+    printf("%s\n", found ? "✓ Mutable members use C length codes" : "✗ Mutable member encoding differs from C");
+    return found ? 0 : -1;
+}
+
+int test_xcdr_rejects_arrays(void) {
+    printf("\n=== Test: XCDR Codec Rejects Arrays and Optionals ===\n");
+    
+    static const char *idl[] = {
+        "module M { struct A { long a[3]; }; };",
+        "module M { struct O { @optional long o; }; };"
+    };
+    char command[1024];
+    for (int i = 0; i < 2; i++) {
+        snprintf(command, sizeof(command),
+            "echo '%s' > /tmp/idlc_test_reject.idl && LD_LIBRARY_PATH=%s %s -l java -f java-cdr=xcdr2 -o /tmp/idlc_test_reject /tmp/idlc_test_reject.idl 2>&1",
+            idl[i], TEST_PLUGIN_DIR, TEST_IDLC);
+        if (run_command(command) == 0) {
+            printf("✗ Generated an XCDR codec for: %s\n", idl[i]);
+            return -1;
+        }
+    }
+    
+    printf("✓ Unsupported members fail generation\n");
+    return 0;
+}
+
 int test_enum_is_java_enum(void) {
     printf("\n=== Test: Enum is Java enum ===\n");
     
@@ -216,6 +610,18 @@ int test_enum_has_get_value(void) {
     return found ? 0 : -1;
 }
 
+int test_enum_from_value(void) {
+    printf("\n=== Test: Enum has fromValue() ===\n");
+    
+    const char *path = "/tmp/idlc_test_shapes/Shapes/ShapeType.java";
+    int found = file_contains(path, "private static final ShapeType[] VALUES = values();") &&
+                file_contains(path, "public static ShapeType fromValue(int value)") &&
+                file_contains(path, "return VALUES[index];");
+    
+    printf("%s\n", found ? "✓ Has fromValue()" : "✗ Missing fromValue()");
+    return found ? 0 : -1;
+}
+
 int test_bitmask_extends_structure(void) {
     printf("\n=== Test: Bitmask extends Structure ===\n");
     
@@ -239,6 +645,19 @@ int test_bitmask_extends_structure(void) {
     return found ? 0 : -1;
 }
 
+int test_bitmask_inline_members(void) {
+    printf("\n=== Test: Bitmask members stored inline ===\n");
+    
+    int found = file_contains("/tmp/idlc_test_shapes/Shapes/FlagsHolder.java", "public int readFlags;") &&
+                file_contains("/tmp/idlc_test_shapes/CommonEnums/Flags.java", "public static boolean isSet(int value, int flag)") &&
+                file_contains("/tmp/idlc_test_shapes/CommonEnums/Flags.java", "buffer.putInt(value);") &&
+                file_contains("/tmp/idlc_test_shapes/Shapes/FlagsHolder.java", "public static final int SERIALIZED_SIZE = 12;") &&
+                file_contains("/tmp/idlc_test_shapes/Shapes/FlagsHolder.java", "buffer.putInt(offset + 4, readFlags);");
+    
+    printf("%s\n", found ? "✓ Bitmask members are ints" : "✗ Bitmask members not inline");
+    return found ? 0 : -1;
+}
+
 int test_union_generation(void) {
     printf("\n=== Test: Union Generation ===\n");
     
@@ -247,6 +666,15 @@ int test_union_generation(void) {
         return -1;
     }
     
+    const char *path = "/tmp/idlc_test_shapes/Shapes/IntShapeValue.java";
+    if (!file_contains(path, "switch (_d) {") ||
+        !file_contains(path, "            case 2: {") ||
+        !file_contains(path, "        _d = 1;") ||
+        file_contains(path, "Try to deserialize into")) {
+        printf("✗ Union codec not switched on the discriminator\n");
+        return -1;
+    }
+    
     int found = count_files_in_dir("/tmp/idlc_test_shapes/Shapes");
     printf("✓ Generated %d files\n", found);
     return 0;
@@ -315,6 +743,95 @@ int test_tex_entity_payload(void) {
     return result == 0 ? 0 : -1;
 }
 
+int test_inline_typedefs_option(void) {
+    printf("\n=== Test: java-inline-typedefs Option ===\n");
+    
+    char command[1024];
+    snprintf(command, sizeof(command),
+        "LD_LIBRARY_PATH=%s %s -l java -f java-inline-typedefs -o /tmp/idlc_test_inline -I %s/examples/all-types %s/examples/all-types/shapes.idl 2>&1",
+        TEST_PLUGIN_DIR, TEST_IDLC, TEST_EXAMPLES_DIR, TEST_EXAMPLES_DIR);
+    
+    if (run_command(command) != 0) {
+        printf("✗ Generation failed\n");
+        return -1;
+    }
+    
+    const char *path = "/tmp/idlc_test_inline/Shapes/TypedefStruct.java";
+    int found = file_contains(path, "public byte byteVal;") &&
+                file_contains(path, "public String uriVal;") &&
+                file_contains(path, "buffer.put(byteVal);") &&
+                !file_exists("/tmp/idlc_test_inline/CommonTypedefs/URI.java");
+    
+    printf("%s\n", found ? "✓ Aliases resolved inline" : "✗ Alias classes still used");
+    return found ? 0 : -1;
+}
+
+int test_native_layout_option(void) {
+    printf("\n=== Test: java-native-layout Option ===\n");
+    
+    char command[1024];
+    snprintf(command, sizeof(command),
+        "LD_LIBRARY_PATH=%s %s -l java -f java-native-layout -o /tmp/idlc_test_native -I %s/examples/all-types %s/examples/all-types/shapes.idl 2>&1",
+        TEST_PLUGIN_DIR, TEST_IDLC, TEST_EXAMPLES_DIR, TEST_EXAMPLES_DIR);
+    
+    if (run_command(command) != 0) {
+        printf("✗ Generation failed\n");
+        return -1;
+    }
+    
+    const char *path = "/tmp/idlc_test_native/Shapes/CircleNative.java";
+    int found = file_contains(path, "public PointNative center;") &&
+                file_contains(path, "public Pointer color;") &&
+                file_contains(path, "public DdsSequence points;") &&
+                file_contains(path, "implements Structure.ByValue") &&
+                file_contains("/tmp/idlc_test_native/Shapes/ShapeValueNative.java", "public _U _u;") &&
+                file_exists("/tmp/idlc_test_native/Shapes/DdsSequence.java") &&
+                file_contains("/tmp/idlc_test_native/Shapes/Circle.java", "public String color;");
+    
+    printf("%s\n", found ? "✓ C layout Structures generated" : "✗ Native layout missing");
+    return found ? 0 : -1;
+}
+
+int test_topic_descriptor(void) {
+    printf("\n=== Test: Native Topic Descriptor ===\n");
+    
+    // Relies on the output of test_native_layout_option
+    const char *path = "/tmp/idlc_test_native/Shapes/CircleNative.java";
+    int found = file_contains(path, "public static final class Descriptor") &&
+                file_contains(path, "TYPE_NAME = \"Shapes::Circle\";") &&
+                file_contains(path, "KEY_NAMES = { \"id\" };") &&
+                file_contains(path, "0x0103000d, 0,  // id") &&
+                file_contains(path, "public static final int[] OPS = {") &&
+                file_contains("/tmp/idlc_test_native/Shapes/MixedKeyNative.java", "FLAGSET = 0x90;") &&
+                file_contains("/tmp/idlc_test_native/Shapes/AliasKeyNative.java", "FLAGSET = 0x12;") &&
+                file_exists("/tmp/idlc_test_native/Shapes/DdsTopicDescriptor.java") &&
+                !file_contains("/tmp/idlc_test_native/Shapes/ShapeValueNative.java", "class Descriptor");
+    
+    printf("%s\n", found ? "✓ Topic descriptor generated" : "✗ Topic descriptor missing");
+    return found ? 0 : -1;
+}
+
+int test_topic_endpoints(void) {
+    printf("\n=== Test: Topic Reader/Writer ===\n");
+    
+    // Relies on the output of test_native_layout_option
+    const char *dir = "/tmp/idlc_test_native/Shapes";
+    char writer[256], reader[256], ddsc[256];
+    snprintf(writer, sizeof(writer), "%s/CircleWriter.java", dir);
+    snprintf(reader, sizeof(reader), "%s/CircleReader.java", dir);
+    snprintf(ddsc, sizeof(ddsc), "%s/Ddsc.java", dir);
+    int found = file_contains(writer, "ThreadLocal<CircleNative> SAMPLE") &&
+                file_contains(writer, "Ddsc.dds_write(writer, sample.getPointer())") &&
+                file_contains(reader, "public int take(CircleNative[] samples)") &&
+                file_contains(reader, "Ddsc.dds_return_loan(reader, loans, loaned)") &&
+                file_contains(ddsc, "Native.register(\"ddsc\");") &&
+                file_exists("/tmp/idlc_test_native/Shapes/DdsSampleInfo.java") &&
+                !file_exists("/tmp/idlc_test_native/Shapes/ShapeValueWriter.java");
+    
+    printf("%s\n", found ? "✓ Direct-mapped endpoints generated" : "✗ Endpoints missing");
+    return found ? 0 : -1;
+}
+
 int test_struct_inheritance(void) {
     printf("\n=== Test: Struct Inheritance ===\n");
     
@@ -357,6 +874,29 @@ int main(int argc, char *argv[]) {
     if (test_struct_has_serialize() != 0) failed++;
     if (test_struct_has_deserialize() != 0) failed++;
     if (test_struct_has_describe_type() != 0) failed++;
+    if (test_type_object_constants() != 0) failed++;
+    if (test_struct_has_serialized_size() != 0) failed++;
+    if (test_struct_has_serialize_into() != 0) failed++;
+    if (test_struct_has_deserialize_from() != 0) failed++;
+    if (test_deserialize_reuse() != 0) failed++;
+    if (test_cdr_runtime() != 0) failed++;
+    if (test_method_splitting() != 0) failed++;
+    if (test_struct_key_hash() != 0) failed++;
+    if (test_instance_cache() != 0) failed++;
+    if (test_key_list_equality() != 0) failed++;
+    if (test_fixed_size_struct() != 0) failed++;
+    if (test_use_arrays_option() != 0) failed++;
+    if (test_jobs_option() != 0) failed++;
+    if (test_incremental_output() != 0) failed++;
+    if (test_deps_option() != 0) failed++;
+    if (test_xcdr2_option() != 0) failed++;
+    if (test_xcdr2_mutable() != 0) failed++;
+    if (test_xcdr_rejects_arrays() != 0) failed++;
+    if (test_records_option() != 0) failed++;
+    if (test_inline_typedefs_option() != 0) failed++;
+    if (test_native_layout_option() != 0) failed++;
+    if (test_topic_descriptor() != 0) failed++;
+    if (test_topic_endpoints() != 0) failed++;
     if (test_struct_inheritance() != 0) failed++;
     if (test_sequence_struct() != 0) failed++;
     if (test_cross_module_typedef() != 0) failed++;
@@ -364,9 +904,11 @@ int main(int argc, char *argv[]) {
     // Enum tests
     if (test_enum_is_java_enum() != 0) failed++;
     if (test_enum_has_get_value() != 0) failed++;
+    if (test_enum_from_value() != 0) failed++;
     
     // Bitmask tests
     if (test_bitmask_extends_structure() != 0) failed++;
+    if (test_bitmask_inline_members() != 0) failed++;
     
     // Union tests
     if (test_union_generation() != 0) failed++;
@@ -375,7 +917,7 @@ int main(int argc, char *argv[]) {
     if (test_tex_entity_payload() != 0) failed++;
     
     printf("\n=== Test Summary ===\n");
-    printf("Passed: %d, Failed: %d\n", 16 - failed, failed);
+    printf("Passed: %d, Failed: %d\n", 40 - failed, failed);
     
     return failed > 0 ? 1 : 0;
 }